@@ -9,10 +9,12 @@ class AnimationController
 {
     SceneMgr* m_scene = nullptr;
 
-    acre::Animation* m_current = nullptr;
-    float            m_time    = 0.0f;
+    acre::Animation* m_current    = nullptr;
+    float            m_time       = 0.0f;
+    uint32_t         m_generation = 0; // SceneMgr::generation m_current belongs to
 
     std::vector<std::vector<float>> m_sampled_values;
+    std::vector<uint32_t>           m_changed;
 
 public:
     AnimationController(SceneMgr* scene);
@@ -36,5 +38,7 @@ private:
 
     void _update_scene();
 
-    void _update_children(acre::Resource* node);
+    void _update_attached(const acre::TransformHierarchy& hierarchy, acre::Resource* node);
+
+    void _update_skins(SceneAsset& asset);
 };
@@ -10,10 +10,11 @@ class CmdController
     SceneMgr*   m_scene;
     std::string m_history;
 
-    std::function<void()>                   m_renderframe_func;
-    std::function<void()>                   m_showProfilerFunc;
-    std::function<void(uint32_t, uint32_t)> m_pickPixelFunc;
-    std::function<void()>                   m_saveframe_func;
+    std::function<void()>                                                      m_renderframe_func;
+    std::function<void()>                                                      m_showProfilerFunc;
+    std::function<void(uint32_t, uint32_t)>                                    m_pickPixelFunc;
+    std::function<void()>                                                      m_saveframe_func;
+    std::function<bool(const std::string& mode, const std::string& fileName)> m_load_func;
 
 public:
     enum class CmdType
@@ -39,6 +40,8 @@ public:
         cActive,
         cUnAlive,
         cLoad,
+        cBench,
+        cResidency,
 
         cCount,
     };
@@ -65,6 +68,7 @@ public:
     void set_showprofiler_callback(std::function<void()> callback) { m_showProfilerFunc = callback; }
     void set_pickpixel_callback(std::function<void(uint32_t, uint32_t)> callback) { m_pickPixelFunc = callback; }
     void set_saveframe_callback(std::function<void()> callback) { m_saveframe_func = callback; }
+    void set_load_callback(std::function<bool(const std::string& mode, const std::string& fileName)> callback) { m_load_func = callback; }
 
     CmdStatus execute(const std::string& command);
 
@@ -90,4 +94,6 @@ private:
     CmdStatus active(const std::vector<std::string>& params);
     CmdStatus reset_alive(const std::vector<std::string>& params);
     CmdStatus load(const std::vector<std::string>& params);
+    CmdStatus bench(const std::vector<std::string>& params);
+    CmdStatus residency(const std::vector<std::string>& params);
 };
@@ -0,0 +1,130 @@
+#pragma once
+
+#include <controller/loader/gltfLoader.h>
+
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+class SceneMgr;
+
+// Runs scene loads as background jobs. Parsing, staging and image decodes happen on the worker pool
+// and the editor keeps drawing meanwhile. An open goes into the scene in one main thread step
+// (GLTFLoader::Config::atomic_commit) replacing the old scene, an add commits progressively unless
+// the config asks for atomic_commit. Owns the loaders, which own the data of their assets
+class LoadController
+{
+public:
+    enum class State
+    {
+        sQueued, // an add waiting for the open before it
+        sRunning,
+        sCommitted,
+        sCanceled,
+        sFailed,
+    };
+
+    struct Status
+    {
+        uint32_t         job = 0;
+        std::string      file_name;
+        bool             replace    = false; // opens a new scene rather than adding to the current one
+        State            state      = State::sRunning;
+        double           elapsed_ms = 0.0;
+        Loader::Progress progress;
+    };
+
+private:
+    struct Job
+    {
+        uint32_t                              id = 0;
+        std::string                           file_name;
+        bool                                  replace = false;
+        bool                                  atomic  = false; // nothing in the scene before it commits
+        State                                 state   = State::sRunning;
+        std::unique_ptr<Loader>               loader;
+        std::chrono::steady_clock::time_point start;
+        Loader::Progress                      reported; // last progress handed to the status callback
+    };
+
+    SceneMgr*          m_scene = nullptr;
+    GLTFLoader::Config m_config;
+
+    std::vector<Job>                     m_jobs;
+    std::vector<std::unique_ptr<Loader>> m_loaders; // of the committed assets, until the scene is cleared
+    std::vector<std::unique_ptr<Loader>> m_retired; // canceled or failed, destroyed once no longer busy
+    uint32_t                             m_next_job = 1;
+    bool                                 m_polling  = false;
+
+    std::function<void(const Status&)> m_status_func;
+    std::function<void(const Status&)> m_ready_func;
+    std::function<void(const Status&)> m_committed_func;
+
+public:
+    LoadController(SceneMgr* scene);
+
+    ~LoadController();
+
+    // Jobs always load progressive, opens always with atomic_commit
+    void set_config(const GLTFLoader::Config& config) { m_config = config; }
+
+    const auto& config() const { return m_config; }
+
+    /**
+     * @brief load fileName as the new scene
+     * @note main thread, running jobs are canceled, the current scene is cleared in the step that
+     *       commits the new one and stays as it is when the job is canceled or fails
+     */
+    uint32_t open(const std::string& fileName);
+
+    // Main thread, loads fileName next to the current scene, after the open still running if any
+    uint32_t add(const std::string& fileName);
+
+    // Main thread, nothing of an atomic job ends up in the scene, a progressive add keeps what it
+    // committed so far. False when it already ended
+    bool cancel(uint32_t job);
+
+    void cancel_all();
+
+    // After SceneMgr::clear_scene, cancels the jobs and drops the loaders of the cleared assets
+    void clear();
+
+    bool busy() const { return !m_jobs.empty(); }
+
+    // Main thread, whenever the progress of a running job changes and once when it ends
+    void set_status_callback(std::function<void(const Status&)> func) { m_status_func = func; }
+
+    // Main thread, once a progressive add is drawable, before the rest of it comes in
+    void set_ready_callback(std::function<void(const Status&)> func) { m_ready_func = func; }
+
+    // Main thread, right after a job committed its asset
+    void set_committed_callback(std::function<void(const Status&)> func) { m_committed_func = func; }
+
+    // "Loading scene.glb: decoding images 12/40", for the status bar
+    static std::string describe(const Status& status);
+
+private:
+    uint32_t _push(const std::string& fileName, bool replace);
+
+    void _start(Job& job);
+
+    Job* _find(uint32_t job);
+
+    // The commit callback of an open, the old scene goes right before the new one comes in
+    void _replace_scene();
+
+    // Takes the job out of m_jobs, its loader to m_loaders or m_retired
+    void _end(uint32_t job, State state);
+
+    void _ready(uint32_t job);
+
+    Status _status(const Job& job) const;
+
+    void _schedule_poll();
+
+    void _poll();
+
+    void _reap();
+};
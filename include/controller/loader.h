@@ -1,31 +1,99 @@
 #pragma once
 
 #include <model/sceneMgr.h>
+#include <utils/brdfLut.h>
+#include <utils/ktx2.h>
 
+#include <functional>
+#include <future>
 #include <string>
+#include <vector>
 
 class Loader
 {
+public:
+    // Stage of the running load and the units of it done so far, total is 0 when it has no units
+    struct Progress
+    {
+        const char* stage = nullptr;
+        uint32_t    done  = 0;
+        uint32_t    total = 0;
+    };
+
 protected:
     SceneMgr* m_scene = nullptr;
 
+    std::function<void()> m_ready_func;
+    std::function<void()> m_loaded_func;
+    std::function<void()> m_commit_func;
+    std::function<void()> m_failed_func;
+
+    // Environment precomputes of loadHDR still running on the worker pool
+    std::vector<std::future<void>> m_environment_tasks;
+    bool                           m_prepare_environment = false;
+
 public:
     Loader(SceneMgr* scene);
 
-    virtual ~Loader() {}
+    virtual ~Loader();
 
+    /**
+     * @brief load a scene into the SceneMgr
+     * @note loaders may return before the scene is complete, the ready callback runs on the main
+     *       thread once the scene can be drawn and framed, the loaded callback once it is complete
+     */
     virtual void loadScene(const std::string& fileName) = 0;
 
+    void set_ready_callback(std::function<void()> func) { m_ready_func = func; }
+
+    void set_loaded_callback(std::function<void()> func) { m_loaded_func = func; }
+
+    // Main thread, right before a loader that commits in one step touches the scene
+    void set_commit_callback(std::function<void()> func) { m_commit_func = func; }
+
+    // Main thread, the file could not be loaded at all
+    void set_failed_callback(std::function<void()> func) { m_failed_func = func; }
+
+    /**
+     * @brief stop the running load
+     * @note main thread, what it committed stays in the scene, no callback runs for it anymore
+     */
+    virtual void cancel() {}
+
+    // Worker tasks or queued steps still use the loader, it must not be destroyed yet
+    virtual bool busy() const { return false; }
+
+    // Main thread, stage is null when no load is running
+    virtual Progress progress() const { return {}; }
+
     void loadImage(const std::string& fileName);
 
+    /**
+     * @brief load an equirect HDR as the HDR light
+     * @note with set_prepare_environment, its prefiltered cube, SH irradiance and sampling CDF
+     *       (SceneMgr::environment) come from the environment cache or are computed on the worker
+     *       pool and committed when done
+     */
     void loadHDR(const std::string& fileName);
 
+    // Opt-in (File > Image > Prefilter HDR Environment), off by default: the renderer does not sample
+    // SceneMgr::environment yet and the precompute takes the whole pool
+    void set_prepare_environment(bool prepare) { m_prepare_environment = prepare; }
+
     void loadLutGGX(const std::string& fileName);
 
     void loadLutCharlie(const std::string& fileName);
 
     void loadLutSheenAlbedoScale(const std::string& fileName);
 
+    /**
+     * @brief feed the three LUTs of the scene from brdfLut
+     * @note tables are read from the cache next to the executable or generated on the worker pool
+     *       and written there, the loadLut* above still replace them from files. SceneMgr keeps the
+     *       generated ones installed across clear_scene
+     */
+    void generateLuts(const brdfLut::Options& options = {});
+
     /**
      * @brief load camera from file
      * @note format example:
@@ -37,6 +105,37 @@ public:
      */
     void loadCamera(const std::string& fileName);
 
+protected:
+    void _on_ready()
+    {
+        if (m_ready_func) m_ready_func();
+    }
+
+    void _on_loaded()
+    {
+        if (m_loaded_func) m_loaded_func();
+    }
+
+    void _on_commit()
+    {
+        if (m_commit_func) m_commit_func();
+    }
+
+    void _on_failed()
+    {
+        if (m_failed_func) m_failed_func();
+    }
+
+    // Points image at the BCn mip chain of compressed, false when acre is built without block
+    // formats (USE_KTX2 off)
+    static bool _set_compressed_image(acre::Image* image, const ktx2::Image& compressed);
+
 private:
-    acre::Resource* createImage(const std::string& fileName);
+    // color images are sRGB encoded and get linearized, data (LUTs) is kept as it is
+    acre::Resource* createImage(const std::string& fileName, bool color);
+
+    // content is hash64 of bytes
+    acre::Resource* createImage(const std::string& fileName, const std::vector<unsigned char>& bytes, uint64_t content, bool color);
+
+    void _prepare_environment(const std::string& fileName, std::vector<unsigned char> bytes, uint64_t content);
 };
@@ -0,0 +1,20 @@
+#pragma once
+
+#include <model/environment.h>
+
+#include <cstdint>
+#include <string>
+
+// Precomputed environment maps on disk, one file per content key next to the scene caches
+class EnvironmentCache
+{
+public:
+    // False when missing, of another version or built for another key
+    static bool read(const std::string& fileName, uint64_t key, acre::EnvironmentMap& environment);
+
+    // Writes to a temporary file next to fileName and renames it over
+    static bool write(const std::string& fileName, uint64_t key, const acre::EnvironmentMap& environment);
+
+    // <dir>/<key>.acreenv, dir defaults to the temp directory
+    static std::string path_for(uint64_t key, const std::string& dir);
+};
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <acre/utils/math/math.h>
+#include <model/wrapper/geometryExt.h>
+
+#include <string>
+#include <vector>
+
+// A resolved vertex/index stream, pointing into loader-owned memory or GeometryRecord::storage
+struct AttributeView
+{
+    const unsigned char* data       = nullptr;
+    uint32_t             count      = 0;
+    uint32_t             stride     = 0;
+    uint32_t             size       = 0; // element size, less than stride for interleaved streams
+    int                  type       = 0; // TINYGLTF_COMPONENT_TYPE_*
+    bool                 normalized = false;
+
+    bool valid() const { return data != nullptr; }
+};
+
+// Per-primitive result of the staging phase, committed into the resource tree later on
+struct GeometryRecord
+{
+    int      mesh_idx = -1;
+    int      prim_idx = -1;
+    uint32_t geo_idx  = 0;
+
+    AttributeView index;
+    AttributeView position;
+    AttributeView uv;
+    AttributeView normal;
+    AttributeView tangent;
+    AttributeView joint;
+    AttributeView weight;
+
+    bool             has_box = false;
+    acre::math::box3 box     = acre::math::box3::empty();
+
+    // Streams rewritten while staging (widened/optimized/quantized), moved to the loader once committed
+    std::vector<std::vector<unsigned char>> storage;
+
+    bool     optimized   = false;
+    uint32_t triangles   = 0;
+    float    acmr_before = 0.0f;
+    float    acmr_after  = 0.0f;
+    uint64_t bytes_raw   = 0;
+    uint64_t bytes       = 0;
+
+    // Simplified index buffers, in the format of index
+    std::vector<AttributeView> lods;
+    std::vector<float>         lod_errors;
+
+    meshopt::MeshletSet meshlets;
+
+    acre::GeometryQuantization quantization;
+    uint64_t                   attribute_bytes_raw = 0;
+    uint64_t                   attribute_bytes     = 0;
+
+    std::vector<std::string> warnings;
+};
@@ -1,22 +1,252 @@
 #pragma once
 
 #include <controller/loader.h>
+#include <controller/loader/geometryRecord.h>
+#include <controller/loader/sceneCache.h>
+#include <utils/mappedFile.h>
+#include <utils/mipmap.h>
 
+#include <atomic>
+#include <chrono>
+#include <future>
 #include <map>
+#include <vector>
 
 namespace tinygltf
 {
 class Model;
 class Material;
+struct Accessor;
+class Node;
 class TinyGLTF;
 class Value;
+struct Image;
 } // namespace tinygltf
 
 class GLTFLoader : public Loader
 {
+public:
+    struct Config
+    {
+        // Stage primitives (accessor resolution, strides, bounds, validation) on the worker pool,
+        // the resource tree is still filled on the calling thread in mesh/primitive order
+        bool parallel_geometry = true;
+
+        // Memory-map .glb files, vertex/index/skin/animation data then point straight into the
+        // mapped BIN chunk and the parsed copy of it is released right after parsing
+        bool map_binary = true;
+
+        // Keep images encoded while parsing and decode them on the worker pool afterwards,
+        // ImageID nodes start as 1x1 placeholders and are filled in as each decode completes.
+        // Also required for KTX2 (KHR_texture_basisu), transcoded to BC5 for normal maps and to
+        // BC7 (UASTC) or BC1/BC3 (ETC1S) otherwise
+        bool async_images = true;
+
+        // Reorder triangle lists for the post-transform cache and overdraw, renumber vertices in
+        // fetch order (dropping unreferenced ones) and narrow indices to 16 bits where they fit.
+        // Off by default, it rewrites every stream of the primitive, so vertex buffers shared
+        // between primitives are copied and a mapped glb is no longer used in place
+        bool optimize_meshes = false;
+
+        // Split triangle lists into meshlets with bounding sphere and normal cone, stored in the
+        // GeometryExt of the geometry node. Both limits are capped at 256
+        bool     build_meshlets        = true;
+        uint32_t meshlet_max_vertices  = 64;
+        uint32_t meshlet_max_triangles = 124;
+
+        // Build a chain of quadric error simplified index buffers for primitives with at least
+        // lod_min_triangles, each level halves the previous (lod_ratio) until lod_max_levels or
+        // the error passes lod_max_error (fraction of the box diagonal)
+        bool     build_lods        = true;
+        uint32_t lod_min_triangles = 65536;
+        uint32_t lod_max_levels    = 6;
+        float    lod_ratio         = 0.5f;
+        float    lod_max_error     = 0.05f;
+
+        // Store positions as unorm16 in the object box, normals/tangents octahedral snorm16, uvs as
+        // half and weights as unorm8. Dequantization parameters go to GeometryExt::quantization,
+        // off by default as the renderer has to decode them
+        bool quantize_attributes = false;
+
+        // Expand integer attributes (KHR_mesh_quantization, normalized byte/short) to float with the
+        // SSE kernels of utils/dequantize. Off keeps them as stored and describes their encoding in
+        // GeometryExt::quantization, which skips the passes that need float positions
+        bool expand_quantized = true;
+
+        // Keep the staged geometry and decoded images of every load in a binary cache keyed by the
+        // content of the file (buffers and images included) and the options above, a reload of
+        // unchanged content skips staging and decoding. cache_dir defaults to <temp>/acreEditor
+        bool        scene_cache = true;
+        std::string cache_dir;
+
+        // Return from loadScene once parsing started on the worker pool, the scene is committed
+        // from SceneMgr::process_pending in slices of progressive_budget_ms: materials, geometry,
+        // transforms and draws, then image previews (preview_size), full images and animations
+        bool     progressive           = true;
+        float    progressive_budget_ms = 4.0f;
+        uint32_t preview_size          = 64;
+
+        // With progressive, decode the images (and build their mip chains) on the worker pool too
+        // and commit the whole asset in one main thread step once everything is ready, right after
+        // the commit callback. Nothing of the load is in the scene before, a canceled one leaves it
+        // as it was
+        bool atomic_commit = false;
+
+        // Merge draws of one (geometry, material) pair repeated at least batch_min_instances times
+        // on static nodes (plain or EXT_mesh_gpu_instancing) into world space geometries of up to
+        // batch_max_vertices, one entity per batch. acre has no per-instance transform input, the
+        // packed transforms stay in GeometryExt for renderers that instance instead. Every batched
+        // instance is a world space copy of its vertices, batch_vertex_budget caps the copies of
+        // a load, the draws past it stay one entity each
+        bool     batch_instances     = true;
+        uint32_t batch_min_instances = 8;
+        uint32_t batch_max_vertices  = 1 << 18;
+        uint32_t batch_vertex_budget = 1 << 22;
+
+        // Drop animation keys that interpolating their neighbours reproduces within
+        // animation_tolerance (per component), rotation keys optionally become snorm16 quaternions
+        float animation_tolerance = 1e-4f;
+        bool  quantize_rotations  = false;
+
+        // Build the mip chain of every rgba8 image on the worker pool while it loads. Color
+        // textures are filtered in linear space, base color of MASK materials keeps the share of
+        // texels passing its alphaCutoff. The chains go to the scene cache with the images
+        bool           build_mips = true;
+        mipmap::Filter mip_filter = mipmap::Filter::fKaiser;
+
+        // Hand the mip chains of decoded images to SceneMgr's residency manager, which evicts their
+        // top levels over the texture budget. The encoded images stay in memory to decode them again
+        bool track_residency = true;
+    };
+
+private:
+    // How the materials sample an image: normal maps transcode to BC5, color textures are sRGB
+    // and a MASK base color keeps its alpha test coverage across mips
+    struct ImageUsage
+    {
+        bool  normal_map   = false;
+        bool  srgb         = false;
+        float alpha_cutoff = 0.0f;
+    };
+
     tinygltf::Model*    m_model  = nullptr;
     tinygltf::TinyGLTF* m_loader = nullptr;
 
+    Config m_config;
+
+    MappedFile                        m_mapped;
+    std::vector<const unsigned char*> m_buffer_data;
+    std::vector<size_t>               m_buffer_sizes;
+
+    // Rewritten vertex/index streams of the committed geometry, kept until the next load
+    std::vector<std::vector<unsigned char>> m_geometry_storage;
+
+    // Decoded EXT_meshopt_compression views and draco primitives, appended to m_buffer_data
+    std::vector<std::vector<unsigned char>> m_decoded_buffers;
+
+    // Written by _decode_compressed on the prepare task, the scene's stats are main thread only
+    LoadStats m_decode_stats;
+
+    // Indexed like m_model->images, decoded pixels are owned here until the next load
+    std::vector<std::vector<unsigned char>> m_encoded_images;
+    std::vector<uint64_t>                   m_image_hashes; // of the encoded bytes, 0 when not deferred
+    std::vector<ImageUsage>                 m_image_usage;
+    std::vector<acre::UUID>                 m_image_uuids; // own or shared through SceneMgr::find_image
+    std::vector<unsigned char*>             m_decoded_images; // stbi pixels of images without a mip chain
+    std::vector<std::vector<unsigned char>> m_mip_chains; // until SceneMgr::track_image takes them
+
+    // Encoded bytes of decoded images, the reload source of their tracked chains
+    std::vector<std::shared_ptr<const std::vector<unsigned char>>> m_reload_sources;
+    std::vector<ktx2::Image>                m_compressed_images;
+    std::vector<std::future<void>>          m_image_tasks;
+    std::atomic<bool>                       m_cancel_images = false;
+    uint32_t                                m_load_serial   = 0;
+
+    // Cache hit: records and pixels point into m_cache. Miss: the cache is written once the last
+    // image decode finished, m_cache_records are the staged records without their storage
+    SceneCache                  m_cache;
+    uint64_t                    m_cache_key   = 0; // content, only hashed on a stamp mismatch or a miss
+    uint64_t                    m_cache_stamp = 0; // options and sources, see _source_stamp
+    std::string                 m_cache_path;
+    bool                        m_write_cache = false;
+    std::atomic<uint32_t>       m_cache_pending = 0;
+    std::atomic<bool>           m_cache_written = false; // chains may leave m_mip_chains
+    std::vector<GeometryRecord> m_cache_records;
+
+    // Of the prepare task, for progress()
+    enum class Phase : uint8_t
+    {
+        pParse,
+        pGeometry,
+        pImages,
+    };
+
+    enum class Stage
+    {
+        sIdle,
+        sPrepare,
+        sMaterial,
+        sGeometry,
+        sScene,
+        sTexture,
+        sAnimation,
+    };
+
+    // Decoded image waiting for its commit, no preview when the image is small already and no
+    // size when the decode failed
+    struct ReadyImage
+    {
+        uint32_t index          = 0;
+        uint32_t width          = 0;
+        uint32_t height         = 0;
+        uint32_t preview_width  = 0;
+        uint32_t preview_height = 0;
+    };
+
+    // Local transform of an EXT_mesh_gpu_instancing instance, relative to its node
+    struct InstanceTRS
+    {
+        acre::math::float3 translation = acre::math::float3(0.0f, 0.0f, 0.0f);
+        acre::math::quat   rotation    = acre::math::quat(1.0f, 0.0f, 0.0f, 0.0f);
+        acre::math::float3 scale       = acre::math::float3(1.0f, 1.0f, 1.0f);
+    };
+
+    // Namespace of the resources of the current load, see acre::make_uuid
+    acre::AssetID m_asset = acre::kEditorAsset;
+
+    // Geometry index of each "mesh_primitive"
+    std::map<std::string, int> m_geometry_keys;
+
+    std::string                           m_file_name;
+    std::chrono::steady_clock::time_point m_load_start;
+    uint32_t                              m_load_generation = 0;
+    bool                                  m_progressive     = false;
+    bool                                  m_atomic          = false;
+    Stage                                 m_stage           = Stage::sIdle;
+    std::future<bool>                     m_prepare_task;
+    std::vector<GeometryRecord>           m_records;
+    size_t                                m_record_cursor = 0;
+
+    // Written by the prepare task, units of its current phase
+    std::atomic<Phase>    m_phase       = Phase::pParse;
+    std::atomic<uint32_t> m_phase_done  = 0;
+    std::atomic<uint32_t> m_phase_total = 0;
+
+    // Copied into every queued step and _post task, see busy()
+    std::shared_ptr<int> m_step_token = std::make_shared<int>(0);
+
+    // Atomic loads: image keys taken before the decodes release the encoded bytes, and the sizes
+    // of the decoded images (none when the decode failed)
+    std::vector<uint64_t>   m_image_keys;
+    std::vector<ReadyImage> m_decoded_sizes;
+
+    // Filled on the main thread through SceneMgr::post, previews are committed before full images
+    std::vector<std::vector<unsigned char>> m_preview_images;
+    std::vector<ReadyImage>                 m_ready_images;
+    size_t                                  m_preview_cursor = 0;
+    size_t                                  m_full_cursor    = 0;
+    uint32_t                                m_decode_count   = 0;
+
 public:
     GLTFLoader(SceneMgr*);
 
@@ -24,9 +254,116 @@ public:
 
     virtual void loadScene(const std::string& fileName) override;
 
+    virtual void cancel() override;
+
+    virtual bool busy() const override;
+
+    virtual Progress progress() const override;
+
+    void set_config(const Config& config) { m_config = config; }
+
+    const auto& config() const { return m_config; }
+
 private:
+    // Parse, resolve buffers and look up the scene cache, false when nothing can be loaded
+    bool _prepare_scene(const std::string& fileName);
+
+    acre::UUID _uuid(uint32_t local) const { return acre::make_uuid(m_asset, local); }
+
+    // SceneMgr::post for work of the current load, dropped once the scene was cleared
+    void _post(std::function<void()>&& task);
+
+    void _post_step(uint32_t serial);
+
+    void _step_progressive(uint32_t serial);
+
+    // Atomic loads, everything the prepare task left goes into the scene at once
+    void _commit_atomic();
+
+    bool _commit_ready_image();
+
+    void _post_ready_image(const ReadyImage& ready, uint32_t serial);
+
+    // Points the ImageID node at the decoded mip chain (or pixels) or the compressed one of image_idx
+    void _commit_image(uint32_t image_idx, uint32_t width, uint32_t height);
+
+    // Hands the committed chain of image_idx to SceneMgr::track_image, once the cache write no longer reads it
+    void _track_image(uint32_t image_idx);
+
+    void _finish_load();
+
+    bool _load_binary_mapped(const std::string& fileName, std::string& err, std::string& warn);
+
+    void _resolve_buffers();
+
+    // EXT_meshopt_compression and KHR_draco_mesh_compression (USE_DRACO), in parallel on the worker pool
+    void _decode_compressed();
+
+    uint64_t _options_key() const;
+
+    // Cheap cache key: options, path, size and mtime of the file and its external sources, hash of its first bytes
+    uint64_t _source_stamp(const std::string& fileName) const;
+
+    // Full cache key: options and every byte of the content
+    uint64_t _content_key(const std::string& fileName) const;
+
+    void _open_cache(const std::string& fileName);
+
+    // Called once per decode task and once by loadScene, the last one writes the cache
+    void _release_cache_write(bool on_worker);
+
+    void _write_cache();
+
+    const unsigned char* _buffer_data(int buffer) const { return m_buffer_data[buffer]; }
+
+    // offset + length lies within the buffer (the mapped BIN chunk for buffer 0 of a mapped glb)
+    bool _buffer_range(int buffer, size_t offset, size_t length) const { return offset <= m_buffer_sizes[buffer] && length <= m_buffer_sizes[buffer] - offset; }
+
+    static bool _defer_image_data(tinygltf::Image* image, const int image_idx, std::string* err, std::string* warn, int req_width, int req_height, const unsigned char* bytes, int size, void* user_data);
+
+    // ImageRegistry key of image_idx, 0 when there is nothing to hash
+    uint64_t _image_key(uint32_t image_idx) const;
+
+    mipmap::Options _mip_options(uint32_t image_idx) const;
+
+    void _reserve_images();
+
+    void _decode_images_async();
+
+    // Atomic loads, decodes on the prepare task's worker and the pool until every image is done
+    void _decode_images(uint32_t serial);
+
+    void _decode_image(uint32_t image_idx, uint32_t serial);
+
+    // Pixels of image_idx, shared with an image already in the scene
+    void _release_decoded(uint32_t image_idx);
+
+    void _wait_images();
+
     void _create_geometry();
 
+    // Fills m_records from the scene cache or by staging, safe to run on a worker
+    void _prepare_geometry();
+
+    void _commit_record(GeometryRecord& record);
+
+    void _stage_geometry(std::vector<GeometryRecord>& records);
+
+    void _stage_primitive(GeometryRecord& record);
+
+    // Materializes a sparse accessor into record storage
+    bool _stage_sparse(const tinygltf::Accessor& accessor, GeometryRecord& record, AttributeView& view) const;
+
+    void _optimize_primitive(GeometryRecord& record, bool has_float_position);
+
+    void _build_lods(GeometryRecord& record, bool has_float_position);
+
+    void _build_meshlets(GeometryRecord& record, bool has_float_position);
+
+    void _quantize_primitive(GeometryRecord& record);
+
+    void _commit_geometry(GeometryRecord& record);
+
     void _create_sampler();
 
     void _create_material();
@@ -37,6 +374,22 @@ private:
 
     void _create_component_draw();
 
+    // Float or normalized integer accessor as count * components floats
+    bool _read_floats(int accessor_idx, int components, std::vector<float>& values) const;
+
+    void _read_gpu_instances(const tinygltf::Node& node, std::vector<InstanceTRS>& instances) const;
+
+    acre::Resource* _create_instance_transform(acre::Resource* parentR, const InstanceTRS& instance, uint32_t uuid);
+
+    acre::Resource* _get_draw_material(int material_idx);
+
+    void _create_draw(uint32_t entity_idx, acre::Resource* geo_R, acre::Resource* materialR, acre::Resource* trsR);
+
+    bool _batchable(uint32_t geo_idx) const;
+
+    // Bakes the transforms into one geometry at batch_geo_idx, returns its vertex count (0 on failure)
+    uint32_t _create_batch(uint32_t geo_idx, const acre::math::affine3* worlds, uint32_t count, uint32_t batch_geo_idx);
+
     void _create_animation();
 
     void _create_texture_transform(const std::map<std::string, tinygltf::Value>& map, uint32_t uuid);
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <controller/loader/geometryRecord.h>
+#include <utils/mappedFile.h>
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+// Binary cache of the post-processed parts of a glTF load (staged geometry, decoded images and their mips).
+// Streams are 16 byte aligned in the file, a hit maps the file and points the records into it
+class SceneCache
+{
+    MappedFile m_mapped;
+
+public:
+    // RGBA8 mip chain packed as utils/mipmap builds it, pixels == nullptr for images that are not cached
+    struct Image
+    {
+        const unsigned char* pixels = nullptr;
+        uint32_t             width  = 0;
+        uint32_t             height = 0;
+        uint32_t             levels = 1;
+    };
+
+    SceneCache() = default;
+
+    SceneCache(const SceneCache&)            = delete;
+    SceneCache& operator=(const SceneCache&) = delete;
+
+    /**
+     * @brief maps the cache file, false when missing, of another version or built for other content
+     * @note stamp (options, paths, sizes and mtimes of the sources) is compared first, content_key
+     *       hashes the whole content and only runs when the stamp differs. A matching content
+     *       restamps the file, so the next load of the touched sources skips the hashing again
+     */
+    bool open(const std::string& fileName, uint64_t stamp, const std::function<uint64_t()>& content_key);
+
+    void close() { m_mapped.close(); }
+
+    auto is_open() const { return m_mapped.is_open(); }
+
+    // Views of the records point into the mapping, valid until close()
+    bool read_geometry(std::vector<GeometryRecord>& records) const;
+
+    bool read_images(std::vector<Image>& images) const;
+
+    // Writes to a temporary file next to fileName and renames it over, records need no storage
+    static bool write(const std::string& fileName, uint64_t stamp, uint64_t key, const std::vector<GeometryRecord>& records, const std::vector<Image>& images);
+
+    // <dir>/<hash of sourceName>.acrecache, dir defaults to the temp directory
+    static std::string path_for(const std::string& sourceName, const std::string& dir);
+};
@@ -1,10 +1,80 @@
 #pragma once
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <new>
 #include <vector>
 #include <string>
 
 namespace acre
 {
 
+template <typename T, size_t Alignment = 32>
+struct AlignedAllocator
+{
+    using value_type = T;
+
+    template <typename U>
+    struct rebind
+    {
+        using other = AlignedAllocator<U, Alignment>;
+    };
+
+    AlignedAllocator() = default;
+
+    template <typename U>
+    AlignedAllocator(const AlignedAllocator<U, Alignment>&)
+    {}
+
+    T* allocate(size_t n) { return static_cast<T*>(::operator new(n * sizeof(T), std::align_val_t(Alignment))); }
+
+    void deallocate(T* p, size_t) { ::operator delete(p, std::align_val_t(Alignment)); }
+
+    template <typename U>
+    bool operator==(const AlignedAllocator<U, Alignment>&) const
+    {
+        return true;
+    }
+};
+
+// Keyframe values of one sampler in a single aligned array, key i starts at i * stride. CUBICSPLINE
+// keys hold in-tangent, value and out-tangent. Rotations may be kept as snorm16 quaternions instead
+class KeyframeStore
+{
+public:
+    static constexpr uint32_t kMaxComponents = 4;
+
+    void assign(const float* values, size_t count, uint32_t components, bool tangents);
+
+    auto count() const { return m_count; }
+    auto components() const { return m_components; }
+    auto stride() const { return m_stride; }
+    auto quantized() const { return !m_snorm.empty(); }
+
+    // Float keys, null once quantized
+    const float* data() const { return m_values.empty() ? nullptr : m_values.data(); }
+
+    // components floats of the value (not the tangents) of key
+    void read(size_t key, float* out) const;
+
+    // Keeps the listed keys, in order
+    void keep(const std::vector<uint32_t>& keys);
+
+    // Quaternion keys without tangents to snorm16x4, renormalized when read
+    bool quantize_rotations();
+
+    size_t bytes() const { return m_values.size() * sizeof(float) + m_snorm.size() * sizeof(int16_t); }
+
+private:
+    std::vector<float, AlignedAllocator<float>> m_values;
+    std::vector<int16_t>                        m_snorm;
+
+    size_t   m_count      = 0;
+    uint32_t m_components = 0;
+    uint32_t m_stride     = 0;
+    uint32_t m_offset     = 0; // of the value within a key
+};
+
 struct AnimationChannel
 {
     int         target_node;
@@ -14,23 +84,43 @@ struct AnimationChannel
 
 struct AnimationSampler
 {
-    std::vector<float>              input;         // keyframe times
-    std::vector<std::vector<float>> output;        // keyframe values
-    std::string                     interpolation; // "LINEAR", "STEP", "CUBICSPLINE"
+    std::vector<float> input;         // keyframe times
+    KeyframeStore      output;        // keyframe values
+    std::string        interpolation; // "LINEAR", "STEP", "CUBICSPLINE"
+};
+
+// Import time compression of a clip, bytes count times and values
+struct AnimationReport
+{
+    uint64_t keys_in   = 0;
+    uint64_t keys_out  = 0;
+    uint64_t bytes_in  = 0;
+    uint64_t bytes_out = 0;
+    float    max_error = 0.0f; // largest component deviation at the imported keys
 };
 
 struct Animation
 {
+    uint32_t                      asset = 0; // AssetID of the loaded file, target nodes are local to it
     std::string                   name;
     std::vector<AnimationChannel> channels;
     std::vector<AnimationSampler> samplers;
     float                         duration = 0.0f;
+    AnimationReport               report;
 };
 
+/**
+ * @brief drop keys the remaining ones reproduce within tolerance and optionally quantize rotations
+ * @note LINEAR keys are tested against the component-wise lerp the controller samples with, STEP
+ * keys against the previous key, CUBICSPLINE samplers are left alone
+ */
+void compress_animation(Animation& animation, float tolerance, bool quantize_rotations);
+
 class AnimationSet
 {
 public:
-    std::vector<Animation> animations;
+    // Deque, clips of later loads are appended while one is playing
+    std::deque<Animation> animations;
 
     Animation* animation(const std::string& name);
     Animation* animation(size_t index) { return &animations[index]; }
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace acre
+{
+
+// Image based lighting of an equirect HDR precomputed on the CPU (utils/envmap). A direction maps to
+// the equirect at u = 0.5 + atan2(z, x) / 2pi, v = acos(y) / pi. Cube faces are +X -X +Y -Y +Z -Z,
+// face texel (u, v) in [-1, 1] with v down looks along +X (1, -v, -u), -X (-1, -v, u),
+// +Y (u, 1, v), -Y (u, -1, -v), +Z (u, -v, 1), -Z (-u, -v, -1)
+struct EnvironmentMap
+{
+    // GGX prefiltered radiance as RGBA16F. Level l has faces of face_size >> l and roughness
+    // l / (levels - 1), packed level by level and face by face
+    uint32_t              face_size = 0;
+    uint32_t              levels    = 0;
+    std::vector<uint16_t> specular;
+
+    // Irradiance E(n) = sum sh[i] * Y_i(n) with the cosine lobe convolved in, basis order
+    // 1, y, z, x, xy, yz, 3z^2 - 1, xz, x^2 - y^2
+    float sh[9][3] = {};
+
+    // Importance sampling of the equirect by luminance * sin(theta): a CDF per row (cdf_width + 1
+    // values each) and the marginal CDF over the rows (cdf_height + 1), all ending at 1. integral
+    // is the mean of the sampled function, pdf = f / integral
+    uint32_t           cdf_width  = 0;
+    uint32_t           cdf_height = 0;
+    std::vector<float> conditional_cdf;
+    std::vector<float> marginal_cdf;
+    float              integral = 0.0f;
+
+    // How the map was obtained, for the Info tab
+    double build_ms   = 0.0;
+    bool   from_cache = false;
+
+    // In halves
+    size_t specular_offset(uint32_t level, uint32_t face) const
+    {
+        size_t offset = 0;
+        for (uint32_t l = 0; l < level; ++l)
+            offset += size_t(6) * face_texels(l);
+        return (offset + face * face_texels(level)) * 4;
+    }
+
+    size_t face_texels(uint32_t level) const
+    {
+        auto size = face_size >> level;
+        return size_t(size ? size : 1) * (size ? size : 1);
+    }
+
+    size_t bytes() const
+    {
+        return specular.size() * sizeof(uint16_t) + (conditional_cdf.size() + marginal_cdf.size()) * sizeof(float) + sizeof(sh);
+    }
+};
+
+} // namespace acre
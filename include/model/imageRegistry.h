@@ -0,0 +1,41 @@
+#pragma once
+
+#include <model/wrapper/resource.h>
+
+#include <cstdint>
+#include <unordered_map>
+
+namespace acre
+{
+
+// ImageID nodes by content, the key hashes the encoded bytes (or pixels) together with how they
+// were decoded, so one file embedded in several glTFs or opened twice is decoded and uploaded once
+class ImageRegistry
+{
+public:
+    struct Entry
+    {
+        UUID     uuid  = 0;
+        uint64_t bytes = 0; // decoded size, what a hit saves
+    };
+
+    const Entry* find(uint64_t key) const
+    {
+        auto iter = m_entries.find(key);
+        return iter != m_entries.end() ? &iter->second : nullptr;
+    }
+
+    void add(uint64_t key, UUID uuid, uint64_t bytes) { m_entries[key] = {uuid, bytes}; }
+
+    void erase(uint64_t key) { m_entries.erase(key); }
+
+    // Forgets the images of asset, their pixels are about to be released
+    void release(AssetID asset);
+
+    void clear() { m_entries.clear(); }
+
+private:
+    std::unordered_map<uint64_t, Entry> m_entries;
+};
+
+} // namespace acre
@@ -0,0 +1,130 @@
+#pragma once
+
+#include <model/wrapper/resource.h>
+
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <unordered_map>
+#include <vector>
+
+namespace acre
+{
+
+class ResourceTree;
+
+// Keeps the mip chains of tracked ImageID nodes within a byte budget. Draws stamp the images they
+// sample with the frame and the finest level their screen size needs; over budget the top levels of
+// the least recently used images are dropped, those of unused and far away images first, and come
+// back through the image's reload on the worker pool once a draw wants them and they fit again
+class ImageResidency
+{
+public:
+    // Worker thread, rebuilds the full chain (level 0 first) after its top levels were evicted
+    using Reload = std::function<bool(std::vector<unsigned char>& chain)>;
+
+    // Hands a finished reload back to the main thread
+    using Post = std::function<void(std::function<void()>&&)>;
+
+    struct Stats
+    {
+        uint64_t budget         = 0;
+        uint64_t resident_bytes = 0; // of the tracked images as they are now
+        uint64_t full_bytes     = 0; // with every level resident
+        uint32_t images         = 0;
+        uint32_t reduced_images = 0; // with top levels evicted
+        uint32_t used_images    = 0; // sampled by a draw in the last frame
+        uint32_t loading        = 0; // reloads in flight
+
+        // Since the scene was opened
+        uint64_t evictions      = 0;
+        uint64_t evicted_bytes  = 0;
+        uint64_t reloads        = 0;
+        uint64_t reloaded_bytes = 0;
+    };
+
+    // Levels of at most this size are never evicted, a drawn image always has something to sample
+    static constexpr uint32_t kMinResidentSize = 64;
+
+    // Reloads in flight at once, each briefly holds a full chain
+    static constexpr uint32_t kMaxReloads = 4;
+
+    ImageResidency(uint64_t budget) { m_stats.budget = budget; }
+
+    ~ImageResidency() { _wait(); }
+
+    void set_budget(uint64_t bytes) { m_stats.budget = bytes; }
+
+    const auto& stats() const { return m_stats; }
+
+    /**
+     * @brief takes the packed mip chain the image of node points into
+     * @note main thread, only uncompressed rgba formats are tracked, false leaves the caller owning chain
+     */
+    bool track(Resource* node, std::vector<unsigned char>& chain, Reload reload);
+
+    // The chain lives in memory that outlives node (a mapped cache), evictions only repoint the image
+    bool track_mapped(Resource* node, const unsigned char* chain);
+
+    // Main thread, starts the use pass of a frame
+    void begin_frame() { m_frame++; }
+
+    // A draw samples the image over about pixels screen pixels
+    void use(UUID uuid, float pixels);
+
+    /**
+     * @brief evicts down to the budget and starts the reloads that fit, after the frame's use calls
+     * @note main thread, post must run its task on the main thread
+     */
+    void update(ResourceTree& tree, const Post& post);
+
+    // Forgets every image, reloads still running are dropped when they come back
+    void clear();
+
+private:
+    struct Entry
+    {
+        uint32_t            width  = 0; // of level 0
+        uint32_t            height = 0;
+        uint32_t            levels = 0;
+        uint32_t            texel  = 0; // bytes
+        std::vector<size_t> offsets;    // bytes, levels + 1 entries
+
+        // Levels first_level.. of the chain, empty when mapped holds the full chain
+        std::vector<unsigned char> chain;
+        const unsigned char*       mapped = nullptr;
+        Reload                     reload;
+
+        uint32_t first_level = 0;
+        uint32_t min_level   = 0; // coarsest level to keep
+        uint32_t want_level  = 0; // finest level used in last_use
+        uint32_t last_use    = 0;
+        uint32_t serial      = 0; // reloads of an earlier entry of the same uuid are dropped
+        bool     loading     = false;
+
+        size_t bytes(uint32_t level) const { return offsets[levels] - offsets[level]; }
+    };
+
+    bool _init(Resource* node, Entry& entry);
+
+    // Points the image at levels first_level.. of entry
+    void _apply(ResourceTree& tree, UUID uuid, Entry& entry);
+
+    void _evict(ResourceTree& tree, UUID uuid, Entry& entry, uint32_t level);
+
+    void _reload(ResourceTree& tree, UUID uuid, Entry& entry, uint32_t level, const Post& post);
+
+    void _finish_reload(ResourceTree& tree, UUID uuid, uint32_t serial, uint32_t level, size_t reserved, std::vector<unsigned char>&& chain);
+
+    void _wait();
+
+    std::unordered_map<UUID, Entry> m_entries;
+    std::vector<std::future<void>>  m_tasks;
+
+    uint32_t m_frame    = 0;
+    uint32_t m_serial   = 0;
+    size_t   m_reserved = 0; // bytes the reloads in flight add once they land
+    Stats    m_stats;
+};
+
+} // namespace acre
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <cstdint>
+
+// Filled by the loaders, shown in the state tab of the info widget
+struct LoadStats
+{
+    // Wall time of the last load until it was drawable and until it was complete. Blocking loads
+    // are drawable once complete, their images may still be decoding afterwards
+    double ready_ms   = 0.0;
+    double load_ms    = 0.0;
+    bool   from_cache = false;
+
+    // KTX2 textures committed as BCn, rgba8_bytes is what the same mip chains take uncompressed
+    uint32_t compressed_images      = 0;
+    uint64_t compressed_bytes       = 0;
+    uint64_t compressed_rgba8_bytes = 0;
+
+    // rgba8 images committed with a mip chain (built or from the cache), bytes of the levels below level 0
+    uint32_t mip_images = 0;
+    uint64_t mip_bytes  = 0;
+
+    // Standalone images (Loader::createImage) as RGBA8 or RGBA16F, bytes_f32 is what their chains
+    // took expanded to RGBA32_FLOAT
+    uint32_t native_images          = 0;
+    uint64_t native_image_bytes     = 0;
+    uint64_t native_image_bytes_f32 = 0;
+
+    // Compressed geometry, decode time is summed over the worker threads
+    uint32_t meshopt_views     = 0;
+    uint64_t meshopt_bytes_in  = 0;
+    uint64_t meshopt_bytes_out = 0;
+    double   meshopt_ms        = 0.0;
+    uint32_t draco_primitives  = 0;
+    uint64_t draco_bytes_in    = 0;
+    uint64_t draco_bytes_out   = 0;
+    double   draco_ms          = 0.0;
+
+    // Mesh optimization pass (vertex cache, overdraw, vertex fetch, index narrowing)
+    uint32_t optimized_geometry = 0;
+    uint64_t optimized_triangle = 0;
+    double   acmr_before_sum    = 0.0; // weighted by triangle count
+    double   acmr_after_sum     = 0.0;
+    uint64_t geometry_bytes     = 0;
+    uint64_t geometry_bytes_raw = 0;
+
+    uint32_t meshlet_count = 0;
+
+    // Repeated static draws merged into world space batches, one entity per batch
+    uint32_t batch_count   = 0;
+    uint32_t batched_draws = 0;
+
+    uint32_t lod_geometry = 0;
+    uint32_t lod_levels   = 0; // without the full detail level
+
+    // Attribute quantization, float bytes of the quantized streams and what they take now
+    uint64_t attribute_bytes_raw = 0;
+    uint64_t attribute_bytes     = 0;
+
+    // Image registry lookups by content and the decoded bytes the hits did not decode again
+    uint32_t image_lookups     = 0;
+    uint32_t image_hits        = 0;
+    uint64_t image_bytes_saved = 0;
+
+    // Animation keys before and after curve reduction and rotation quantization, max_error is the
+    // largest deviation over all clips
+    uint64_t animation_keys_in   = 0;
+    uint64_t animation_keys_out  = 0;
+    uint64_t animation_bytes_in  = 0;
+    uint64_t animation_bytes_out = 0;
+    float    animation_max_error = 0.0f;
+
+    double acmr_before() const { return optimized_triangle ? acmr_before_sum / optimized_triangle : 0.0; }
+    double acmr_after() const { return optimized_triangle ? acmr_after_sum / optimized_triangle : 0.0; }
+};
@@ -4,19 +4,74 @@
 #include <model/camera.h>
 #include <model/wrapper/resourceTree.h>
 #include <model/animation.h>
-
+#include <model/loadStats.h>
+#include <model/transformHierarchy.h>
+#include <model/skinPalette.h>
+#include <model/imageRegistry.h>
+#include <model/imageResidency.h>
+#include <model/environment.h>
+#include <utils/brdfLut.h>
+
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
 #include <vector>
 
+// What a loader keeps per file besides its resources: the node hierarchy (TransformID uuid =
+// make_uuid(asset, node index)) and the skins
+struct SceneAsset
+{
+    std::string              name;
+    acre::TransformHierarchy hierarchy;
+    acre::SkinPalette        skins;
+};
+
 class SceneMgr
 {
     acre::Scene*        m_scene;
     acre::ResourceTree* m_tree;
     acre::AnimationSet* m_animation_set = nullptr;
 
+    // Loaded assets by AssetID, ids are never reused so stale work of a cleared scene can not
+    // reach a newer asset
+    std::unordered_map<acre::AssetID, std::unique_ptr<SceneAsset>> m_assets;
+    acre::AssetID                                                  m_next_asset = acre::kEditorAsset + 1;
+
+    acre::ImageRegistry m_images;
+
+    // Tables of Loader::generateLuts, clear_scene removes every texture and installs them again
+    struct GeneratedLut
+    {
+        brdfLut::Kind          kind;
+        acre::UUID             uuid = 0;
+        uint32_t               size = 0;
+        std::vector<uint16_t>* rgba = nullptr; // owned by the image like the loaders' chains
+    };
+    std::vector<GeneratedLut> m_luts;
+
+    // Precomputed lighting of the HDR light, which outlives clear_scene like the LUTs
+    std::shared_ptr<const acre::EnvironmentMap> m_environment;
+    uint64_t                                    m_environment_key = 0;
+
     acre::math::box3 m_box = acre::math::box3::empty();
     acre::Resource*  m_camera;
 
+    LoadStats m_load_stats;
+
+    // Work posted from worker threads, the resource tree is only touched on the main thread
+    std::mutex                         m_pending_mutex;
+    std::vector<std::function<void()>> m_pending;
+    uint32_t                           m_generation = 0;
+
+    // After m_pending, its reloads still post there while it waits for them on destruction
+    acre::ImageResidency m_residency{kDefaultTextureBudget};
+
 public:
+    // Bytes of the mip chains ImageResidency keeps resident until set_texture_budget says otherwise
+    static constexpr uint64_t kDefaultTextureBudget = uint64_t(1) << 30;
+
     SceneMgr(acre::Scene*);
 
     ~SceneMgr();
@@ -24,6 +79,15 @@ public:
     void clear_scene();
     // void clearHDR();
 
+    // Bumped by clear_scene, posted work should drop itself when the scene it was made for is gone
+    auto generation() const { return m_generation; }
+
+    // Thread-safe
+    void post(std::function<void()>&& task);
+
+    // Main thread only, returns true when any posted work ran
+    bool process_pending();
+
     template <typename ID>
     auto create(acre::UUID uuid)
     {
@@ -59,9 +123,17 @@ public:
 
     void create(acre::component::DrawPtr);
 
+    auto&       load_stats() { return m_load_stats; }
+    const auto& load_stats() const { return m_load_stats; }
+
+    // Main thread, switches every geometry with a LOD chain to the coarsest level whose error
+    // projects below threshold pixels for the main camera
+    void select_lods(float viewport_height, float threshold = 1.0f);
+
     auto get_box() { return m_box; }
     void reset_box() { m_box = acre::math::box3::empty(); }
-    void merge_box(acre::math::box3 box) { m_box |= box; }
+    void merge_box(acre::math::box3 box) { merge_box(&box, 1); }
+    void merge_box(const acre::math::box3* boxes, size_t count);
 
     const auto& camera_list() { return m_tree->_getMgr<acre::CameraID>(); }
     const auto& entity_list() { return m_tree->_getMgr<acre::EntityID>(); }
@@ -72,7 +144,7 @@ public:
 
     auto camera_id() { return m_camera->id<acre::CameraID>(); }
     auto main_camera() { return m_camera; }
-    void set_main_camera(uint32_t uuid);
+    void set_main_camera(acre::UUID uuid);
 
     auto entity_count() { return m_tree->_getMgr<acre::EntityID>().size(); }
     void highlight_entity(acre::EntityID id) { m_scene->highlight(id); }
@@ -87,10 +159,25 @@ public:
     auto get_sun_light() { return m_scene->get_sun_light(); }
     void set_hdr_light(acre::HDRLight* light) { m_scene->set_hdr_light(light); }
     auto get_hdr_light() { return m_scene->get_hdr_light(); }
+    // Main thread. begin_environment when the HDR light changes, set_environment only takes the map
+    // precomputed for the current key, a slower earlier HDR can not replace a newer one
+    void begin_environment(uint64_t key)
+    {
+        m_environment_key = key;
+        m_environment.reset();
+    }
+    void set_environment(uint64_t key, std::shared_ptr<const acre::EnvironmentMap> environment)
+    {
+        if (key == m_environment_key) m_environment = std::move(environment);
+    }
+    auto environment() const { return m_environment.get(); }
     void set_lut_ggx(acre::TextureID texture) { m_scene->set_lut_ggx(texture); }
     void set_lut_charlie(acre::TextureID texture) { m_scene->set_lut_charlie(texture); }
     void set_lut_sheen_albedo_scale(acre::TextureID texture) { m_scene->set_lut_sheen_albedo_scale(texture); }
 
+    // size x size RGBA16F table as the LUT of kind, kept across clear_scene
+    void install_lut(brdfLut::Kind kind, acre::UUID uuid, std::vector<uint16_t>* rgba, uint32_t size);
+
     auto vindex_buffer(acre::VIndexID id) { return m_tree->get<acre::VIndexID>(id.idx); }
     auto vposition_buffer(acre::VPositionID id) { return m_tree->get<acre::VPositionID>(id.idx); }
 
@@ -98,7 +185,7 @@ public:
     auto get_geometry(acre::GeometryID id) { return m_tree->get<acre::GeometryID>(id.idx); }
     void highlight_geometry(acre::GeometryID id) { m_scene->highlight(id); }
     void unhighlight_geometry(acre::GeometryID id) { m_scene->unhighlight(id); }
-    void highlight_geometry(uint32_t uuid);
+    void highlight_geometry(acre::UUID uuid);
 
     auto get_texture(acre::TextureID id) { return m_tree->get<acre::TextureID>(id.idx); }
 
@@ -106,7 +193,7 @@ public:
     auto get_material(acre::MaterialID id) { return m_tree->get<acre::MaterialID>(id.idx); }
     void highlight_material(acre::MaterialID id) { m_scene->highlight(id); }
     void unhighlight_material(acre::MaterialID id) { m_scene->unhighlight(id); }
-    void highlight_material(uint32_t uuid);
+    void highlight_material(acre::UUID uuid);
 
     auto transform_count() { return m_tree->_getMgr<acre::TransformID>().size(); }
     auto get_transform(acre::TransformID id) { return m_tree->get<acre::TransformID>(id.idx); }
@@ -116,10 +203,47 @@ public:
 
     auto animation_set() const { return m_animation_set; }
 
+    // Main thread, a new uuid namespace for one loaded file
+    acre::AssetID create_asset(const std::string& name);
+
+    // Null once the scene was cleared
+    SceneAsset* asset(acre::AssetID asset);
+
+    /**
+     * @brief the ImageID node already holding the content of key, counted in the load stats
+     * @note main thread, loaders add_image what they decode themselves
+     */
+    acre::Resource* find_image(uint64_t key);
+
+    void add_image(uint64_t key, acre::UUID uuid, uint64_t bytes) { m_images.add(key, uuid, bytes); }
+
+    void release_images(acre::AssetID asset) { m_images.release(asset); }
+
+    /**
+     * @brief hands the mip chain the image of node points into to the residency manager
+     * @note main thread, reload rebuilds the full chain on a worker once evicted levels are wanted
+     *       again. False when the image is not tracked, chain then stays with the caller
+     */
+    bool track_image(acre::Resource* node, std::vector<unsigned char>& chain, acre::ImageResidency::Reload reload)
+    {
+        return m_residency.track(node, chain, std::move(reload));
+    }
+
+    // The chain stays where it is (a mapped cache) for as long as node lives
+    bool track_mapped_image(acre::Resource* node, const unsigned char* chain) { return m_residency.track_mapped(node, chain); }
+
+    // Main thread, once per frame: stamps the images of every draw by their screen size, then
+    // evicts or reloads mip levels to stay within the texture budget
+    void update_residency(float viewport_height);
+
+    void        set_texture_budget(uint64_t bytes) { m_residency.set_budget(bytes); }
+    const auto& residency_stats() const { return m_residency.stats(); }
+
 private:
     void _init();
 
     void _init_camera();
     void _init_direction_light();
     void _init_point_light();
+    void _init_lut(const GeneratedLut& lut);
 };
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <acre/render/scene.h>
+#include <model/transformHierarchy.h>
+
+#include <cstdint>
+#include <vector>
+
+namespace acre
+{
+
+// Skins imported once per glTF skin, joints and inverse bind matrices of all skins back to back.
+// Skinned mesh nodes are instances referencing a skin, their joint matrices form one contiguous
+// palette: inverse_bind * joint world * inverse(node world)
+class SkinPalette
+{
+public:
+    static constexpr uint32_t kNone = ~0u;
+
+    struct SkinRange
+    {
+        uint32_t first_joint = 0;
+        uint32_t joint_count = 0;
+    };
+
+    struct Instance
+    {
+        uint32_t node         = 0;
+        uint32_t skin         = 0;
+        uint32_t first_matrix = 0;
+
+        math::float4x4 inverse_node_matrix = math::float4x4::identity();
+    };
+
+    std::vector<SkinRange>      skins;
+    std::vector<uint32_t>       joints;        // joint node of each entry
+    std::vector<math::float4x4> inverse_binds; // per entry
+
+    std::vector<Instance>       instances;
+    std::vector<math::float4x4> matrices; // per instance and joint of its skin
+
+    std::vector<uint32_t> skinned_joints; // every joint node once, in the order first used
+
+    /**
+     * @brief add a skin, inverse_binds points at count column-major float4x4 (null: identity)
+     * @return the skin index for add_instance
+     */
+    uint32_t add_skin(const int* joint_nodes, uint32_t count, const unsigned char* inverse_binds);
+
+    void add_instance(uint32_t node, uint32_t skin);
+
+    void clear();
+
+    // Recomputes the palette (and the inverse node matrices) from the hierarchy's world transforms
+    void update(const TransformHierarchy& hierarchy);
+
+    /**
+     * @brief fill the acre skin of a joint node from the first instance using it
+     * @note acre keeps a single SkinID per joint node, instances sharing a skin can not differ there
+     */
+    bool write_skin(uint32_t joint_node, Skin& skin) const;
+
+private:
+    struct JointOwner
+    {
+        uint32_t instance = kNone;
+        uint32_t joint    = 0;
+    };
+
+    // By joint node
+    std::vector<JointOwner> m_owners;
+};
+
+} // namespace acre
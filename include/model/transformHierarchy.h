@@ -0,0 +1,58 @@
+#pragma once
+
+#include <acre/utils/math/math.h>
+
+#include <cstdint>
+#include <vector>
+
+namespace acre
+{
+
+// The node hierarchy flattened at load: every slot comes after its parent, so world transforms are
+// one linear pass over the arrays. Local TRS and world affines are kept as separate arrays indexed
+// by slot, node_slots maps a node index (the TransformID uuid) to its slot
+class TransformHierarchy
+{
+public:
+    static constexpr uint32_t kNoSlot = ~0u;
+
+    std::vector<uint32_t> nodes;      // node index of each slot
+    std::vector<uint32_t> parents;    // parent slot, kNoSlot for roots
+    std::vector<uint32_t> node_slots; // slot of each node
+
+    std::vector<math::float3> translations;
+    std::vector<math::quat>   rotations;
+    std::vector<math::float3> scales;
+
+    // Nodes given as a matrix keep it as their local transform, glTF does not animate those
+    std::vector<uint8_t>       fixed;
+    std::vector<math::affine3> fixed_locals;
+
+    std::vector<math::affine3> worlds;
+
+    /**
+     * @brief order the nodes parents first from the parent node of each node (-1 for roots)
+     * @note local transforms start as identity, nodes caught in a cycle are treated as roots
+     */
+    void build(const std::vector<int>& node_parents);
+
+    void clear();
+
+    auto size() const { return uint32_t(nodes.size()); }
+    auto slot(uint32_t node) const { return node < node_slots.size() ? node_slots[node] : kNoSlot; }
+
+    math::affine3 local(uint32_t slot) const;
+
+    // Marks the local transform of slot as changed for the next update_dirty
+    void mark(uint32_t slot) { m_dirty[slot] = 1; }
+
+    void update();
+
+    // Recomputes the marked slots and everything below them, changed receives those slots in order
+    void update_dirty(std::vector<uint32_t>& changed);
+
+private:
+    std::vector<uint8_t> m_dirty;
+};
+
+} // namespace acre
@@ -0,0 +1,85 @@
+#pragma once
+
+#include "resource.h"
+#include <utils/meshOptimizer.h>
+
+namespace acre
+{
+
+// Integer components of a stream kept as the file stored them (KHR_mesh_quantization), floats are
+// c or, normalized, c / 255, max(c / 127, -1), c / 65535, max(c / 32767, -1)
+struct StreamEncoding
+{
+    int  type       = 0; // glTF component type, 0 for float streams
+    bool normalized = false;
+
+    bool any() const { return type != 0; }
+};
+
+// Which streams of the geometry hold quantized data instead of floats, and how to get floats back
+struct GeometryQuantization
+{
+    bool position = false; // unorm16x4, p = position_offset + q / 65535 * position_scale
+    bool normal   = false; // octahedral snorm16x2
+    bool tangent  = false; // octahedral snorm16x2, handedness snorm16, padding
+    bool uv       = false; // half2
+    bool weight   = false; // unorm8x4
+
+    math::float3 position_offset = math::float3(0.0f, 0.0f, 0.0f);
+    math::float3 position_scale  = math::float3(0.0f, 0.0f, 0.0f);
+
+    // Streams the loader did not touch, only set when GLTFLoader::Config::expand_quantized is off
+    StreamEncoding position_encoding;
+    StreamEncoding normal_encoding;
+    StreamEncoding tangent_encoding;
+    StreamEncoding uv_encoding;
+    StreamEncoding weight_encoding;
+
+    bool any() const
+    {
+        return position || normal || tangent || uv || weight || position_encoding.any() || normal_encoding.any() || tangent_encoding.any() ||
+               uv_encoding.any() || weight_encoding.any();
+    }
+};
+
+struct GeometryLod
+{
+    VIndexID index;
+    uint32_t index_count = 0;
+    float    error       = 0.0f; // object space distance bound to the full detail surface
+};
+
+// A draw of the geometry, sized on screen by the LOD selection and the texture residency
+struct GeometryInstance
+{
+    math::box3 box   = math::box3::empty(); // world space
+    float      scale = 1.0f;                // object to world length scale
+};
+
+// VIndexID uuid of LOD level > 0, the geometry uuid takes the low bits
+static constexpr uint32_t kLodUUIDShift = 24;
+
+// Attached to GeometryID nodes, node->ext<GeometryExt>() is null when no loader drew the geometry
+struct GeometryExt : ResourceExt
+{
+    // Clusters of the full detail index buffer (lods[0]) for CPU culling and mesh shading, read
+    // them through current_meshlets, select_lods may have swapped in a coarser index buffer
+    meshopt::MeshletSet meshlets;
+
+    GeometryQuantization quantization;
+
+    // [0] is the full detail index buffer, coarser levels share its vertices
+    std::vector<GeometryLod>      lods;
+    std::vector<GeometryInstance> instances;
+    uint32_t                      lod_level = 0;
+
+    // Null while a coarser level is drawn or when none were built, the clusters would not match it
+    const meshopt::MeshletSet* current_meshlets() const { return lod_level == 0 && !meshlets.meshlets.empty() ? &meshlets : nullptr; }
+
+    // Set when the loader merged repeated draws of geometry batch_source into this one, the vertices
+    // are in world space already, batch_transforms are the draws' object to world transforms
+    uint32_t                   batch_source = ~0u;
+    std::vector<math::affine3> batch_transforms;
+};
+
+} // namespace acre
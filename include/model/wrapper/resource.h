@@ -51,7 +51,24 @@ constexpr auto index_of_rid()
     return RID((ID)0).index();
 }
 
-using UUID = uint32_t;
+// The high word is the namespace of the asset that created the resource, loaders number their
+// resources in the low word. Asset 0 holds the editor's own (camera, lights, standalone images)
+using UUID    = uint64_t;
+using AssetID = uint32_t;
+
+static constexpr AssetID kEditorAsset = 0;
+
+constexpr UUID make_uuid(AssetID asset, uint32_t local) { return UUID(asset) << 32 | local; }
+
+constexpr AssetID asset_of(UUID uuid) { return AssetID(uuid >> 32); }
+
+constexpr uint32_t local_of(UUID uuid) { return uint32_t(uuid); }
+
+// Editor-side data kept next to an acre resource (e.g. meshlets of a geometry), released with the node
+struct ResourceExt
+{
+    virtual ~ResourceExt() = default;
+};
 
 struct Resource
 {
@@ -68,6 +85,17 @@ struct Resource
     template <typename ID>
     auto ptr() const { return std::get<ID>(rid).ptr; }
 
+    template <typename T>
+    T* ext() const { return static_cast<T*>(extension.get()); }
+
+    template <typename ID>
+    bool is() const { return std::holds_alternative<ID>(rid); }
+
+    // What this node holds, e.g. the geometry and material of an entity or the image of a texture
+    const auto& references() const { return refs; }
+
+    std::unique_ptr<ResourceExt> extension;
+
     // relation tree
     Resource*                     parent = nullptr;
     std::unordered_set<Resource*> children;
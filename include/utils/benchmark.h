@@ -0,0 +1,18 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+// In-app micro benchmarks, reachable from the command line widget ("bench <name> [count]")
+namespace benchmark
+{
+
+std::string bounds(size_t count);
+
+// Integer vertex streams: scalar vs SSE expansion to float, and the copy a quantized stream costs
+std::string attributes(size_t count);
+
+// BRDF LUT generation per kind at 128x128: scalar on one thread vs SSE on the worker pool
+std::string luts(size_t samples);
+
+} // namespace benchmark
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <acre/utils/math/math.h>
+
+#include <cstddef>
+#include <cstdint>
+
+namespace bounds
+{
+
+enum class ComponentType : uint8_t
+{
+    cFloat,
+    cByte,
+    cUByte,
+    cShort,
+    cUShort,
+};
+
+// Three component positions, byteStride apart, possibly quantized (KHR_mesh_quantization)
+struct PositionStream
+{
+    const void*   data       = nullptr;
+    size_t        count      = 0;
+    size_t        stride     = 12;
+    ComponentType type       = ComponentType::cFloat;
+    bool          normalized = false;
+};
+
+acre::math::box3 compute(const PositionStream& stream);
+
+acre::math::box3 compute(const float* data, size_t count, size_t stride = 12);
+
+acre::math::box3 merge(const acre::math::box3* boxes, size_t count);
+
+// Exact bounds of an object box placed by affine (Arvo), without touching the source box
+acre::math::box3 transform(const acre::math::box3& box, const acre::math::affine3& affine);
+
+} // namespace bounds
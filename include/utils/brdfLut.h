@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// BRDF lookup tables of the glTF PBR models, Monte Carlo integrated in process. Column x holds
+// NdotV (x + 0.5) / size, row y roughness (y + 0.5) / size, rows run in parallel on the worker pool
+namespace brdfLut
+{
+
+enum class Kind : uint8_t
+{
+    lGGX,              // rg: split sum scale and bias of F0 (Karis), height correlated Smith
+    lCharlie,          // rgb: integral of D_Charlie * V_Ashikhmin * NdotL, the sheen IBL term
+    lSheenAlbedoScale, // rgb: directional albedo E of the KHR_materials_sheen BRDF
+};
+
+struct Options
+{
+    uint32_t size    = 128;
+    uint32_t samples = 1024; // per texel, Hammersley
+};
+
+const char* name(Kind kind);
+
+// size x size RGBA16F, alpha is 1. GGX integrates four samples at a time with SSE
+void generate(Kind kind, const Options& options, std::vector<uint16_t>& rgba);
+
+// Reference on the calling thread without SIMD, the baseline of the benchmark
+void generate_scalar(Kind kind, const Options& options, std::vector<uint16_t>& rgba);
+
+// <executable dir>/lut/<name>_<size>_<samples>.acrelut
+std::string cache_path(Kind kind, const Options& options);
+
+// False when missing or written for other options
+bool read_cache(const std::string& fileName, Kind kind, const Options& options, std::vector<uint16_t>& rgba);
+
+bool write_cache(const std::string& fileName, Kind kind, const Options& options, const std::vector<uint16_t>& rgba);
+
+} // namespace brdfLut
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Integer vertex streams (KHR_mesh_quantization, normalized attributes) back to float, src streams
+// have any byte stride, dst is packed. Normalized values follow glTF: c / 255, max(c / 127, -1), ...
+namespace dequantize
+{
+
+enum class Component : uint8_t
+{
+    cByte,
+    cUByte,
+    cShort,
+    cUShort,
+};
+
+// 1 to 4 components per element, SSE2 where available
+void to_float(float* dst, const unsigned char* src, size_t count, size_t stride, size_t components, Component type, bool normalized);
+
+// Reference loop, also the tail of to_float
+void to_float_scalar(float* dst, const unsigned char* src, size_t count, size_t stride, size_t components, Component type, bool normalized);
+
+// ubyte joint indices to ushort
+void widen_u8_u16(uint16_t* dst, const unsigned char* src, size_t count, size_t stride, size_t components);
+
+} // namespace dequantize
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <model/environment.h>
+
+#include <cstdint>
+
+// Image based lighting precompute of an equirect HDR: cube conversion, GGX prefiltered specular
+// chain, SH irradiance and the importance sampling CDF. Texels run in parallel on the worker pool
+namespace envmap
+{
+
+struct Options
+{
+    uint32_t face_size = 512;  // of the specular level 0, at most a quarter of the equirect width
+    uint32_t levels    = 6;    // roughness 0 to 1 in even steps
+    uint32_t samples   = 64;   // GGX samples per texel of the rough levels
+    uint32_t cdf_width = 1024; // larger equirects are box averaged down, the height follows
+};
+
+// Part of the environment cache key
+uint64_t options_key(const Options& options);
+
+// rgba is the linear rgba32f equirect
+void build(const float* rgba, uint32_t width, uint32_t height, const Options& options, acre::EnvironmentMap& environment);
+
+} // namespace envmap
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+// IEEE 754 binary16 conversion, round to nearest even, keeps inf/nan and denormals
+namespace half
+{
+
+inline uint16_t from_float(float value)
+{
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+
+    uint32_t sign     = (bits >> 16) & 0x8000;
+    uint32_t exponent = (bits >> 23) & 0xff;
+    uint32_t mantissa = bits & 0x7fffff;
+
+    if (exponent == 0xff) return uint16_t(sign | 0x7c00 | (mantissa ? 0x200 : 0));
+
+    int32_t e = int32_t(exponent) - 127 + 15;
+    if (e >= 0x1f) return uint16_t(sign | 0x7c00);
+
+    if (e <= 0)
+    {
+        if (e < -10) return uint16_t(sign);
+
+        mantissa |= 0x800000;
+        uint32_t shift   = uint32_t(14 - e);
+        uint32_t result  = mantissa >> shift;
+        uint32_t rest    = mantissa & ((1u << shift) - 1);
+        uint32_t halfway = 1u << (shift - 1);
+        if (rest > halfway || (rest == halfway && (result & 1))) result++;
+        return uint16_t(sign | result);
+    }
+
+    uint32_t result = sign | (uint32_t(e) << 10) | (mantissa >> 13);
+    uint32_t rest   = mantissa & 0x1fff;
+    if (rest > 0x1000 || (rest == 0x1000 && (result & 1))) result++; // may carry into the exponent, which is correct
+    return uint16_t(result);
+}
+
+inline float to_float(uint16_t value)
+{
+    uint32_t sign     = uint32_t(value & 0x8000) << 16;
+    uint32_t exponent = (value >> 10) & 0x1f;
+    uint32_t mantissa = value & 0x3ff;
+
+    uint32_t bits;
+    if (exponent == 0x1f)
+    {
+        bits = sign | 0x7f800000 | (mantissa << 13);
+    }
+    else if (exponent != 0)
+    {
+        bits = sign | ((exponent + 127 - 15) << 23) | (mantissa << 13);
+    }
+    else if (mantissa == 0)
+    {
+        bits = sign;
+    }
+    else
+    {
+        // denormal, normalize it
+        exponent = 127 - 15 + 1;
+        while (!(mantissa & 0x400))
+        {
+            mantissa <<= 1;
+            exponent--;
+        }
+        bits = sign | (exponent << 23) | ((mantissa & 0x3ff) << 13);
+    }
+
+    float result;
+    memcpy(&result, &bits, sizeof(result));
+    return result;
+}
+
+// from_float over an array, eight values at a time with F16C or SSE2. Same results, F16C keeps
+// the payload of NaNs
+void from_floats(const float* src, uint16_t* dst, size_t count);
+
+} // namespace half
@@ -0,0 +1,12 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// XXH64, for content keys (caches, deduplication), not for security
+uint64_t hash64(const void* data, size_t size, uint64_t seed = 0);
+
+inline uint64_t hash_combine(uint64_t seed, uint64_t value)
+{
+    return seed ^ (value + 0x9e3779b97f4a7c15ull + (seed << 6) + (seed >> 2));
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// KTX2 containers (KHR_texture_basisu), 2D textures only. Basis Universal payloads are transcoded
+// with the basisu transcoder (USE_KTX2), BCn payloads without supercompression are taken as is
+namespace ktx2
+{
+
+enum class Format
+{
+    fBC1_RGB,
+    fBC3_RGBA,
+    fBC5_RG,
+    fBC7_RGBA,
+};
+
+struct Level
+{
+    uint64_t offset            = 0;
+    uint64_t size              = 0;
+    uint64_t uncompressed_size = 0;
+};
+
+// Parsed header, levels point into the bytes given to read
+struct Texture
+{
+    const unsigned char* data = nullptr;
+    size_t               size = 0;
+
+    uint32_t vk_format        = 0; // 0 for Basis Universal
+    uint32_t width            = 0;
+    uint32_t height           = 0;
+    uint32_t supercompression = 0;
+    uint32_t color_model      = 0; // KHR_DF_MODEL_*, 163 ETC1S, 166 UASTC
+    bool     has_alpha        = false;
+    bool     srgb             = false;
+
+    std::vector<Level> levels; // largest first
+};
+
+// Compressed mip chain, largest level first and tightly packed in data
+struct Image
+{
+    Format   format = Format::fBC7_RGBA;
+    uint32_t width  = 0;
+    uint32_t height = 0;
+    bool     srgb   = false;
+
+    std::vector<unsigned char> data;
+    std::vector<size_t>        level_offsets;
+};
+
+bool is_ktx2(const unsigned char* bytes, size_t size);
+
+bool read(const unsigned char* bytes, size_t size, Texture& texture);
+
+// BC5 for normal maps, BC7 for UASTC, BC1/BC3 for ETC1S depending on alpha
+Format choose_format(const Texture& texture, bool normal_map);
+
+size_t level_size(Format format, uint32_t width, uint32_t height);
+
+// Levels are transcoded in parallel on the worker pool
+bool transcode(const Texture& texture, bool normal_map, Image& image);
+
+} // namespace ktx2
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Read-only memory mapping of a whole file
+class MappedFile
+{
+    const unsigned char* m_data = nullptr;
+    size_t               m_size = 0;
+
+#ifdef _WIN32
+    void* m_file    = nullptr;
+    void* m_mapping = nullptr;
+#else
+    int m_fd = -1;
+#endif
+
+public:
+    enum class Advice
+    {
+        aNormal,
+        aSequential,
+        aWillNeed,
+    };
+
+    MappedFile() = default;
+
+    ~MappedFile();
+
+    MappedFile(const MappedFile&)            = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool open(const std::string& fileName);
+
+    void close();
+
+    // Hint the OS about the access pattern of [offset, offset + size)
+    void advise(size_t offset, size_t size, Advice advice) const;
+
+    auto data() const { return m_data; }
+    auto size() const { return m_size; }
+    auto is_open() const { return m_data != nullptr; }
+};
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Index/vertex reordering for indexed triangle lists, indices are widened to 32 bits by the caller
+namespace meshopt
+{
+
+// Forsyth's linear-speed vertex cache optimization, tuned for a 32 entry LRU cache
+void optimize_vertex_cache(uint32_t* dst, const uint32_t* indices, size_t index_count, size_t vertex_count);
+
+// Splits a cache optimized index buffer into clusters at cache resets and sorts the clusters so that
+// outward facing ones come first. Keeps the input order when the ACMR grows past input * threshold
+void optimize_overdraw(uint32_t* dst, const uint32_t* indices, size_t index_count, const float* positions, size_t vertex_count, size_t position_stride, float threshold = 1.05f);
+
+// Numbers vertices in first-use order, remap[old] = new or ~0u for unreferenced vertices.
+// Returns the referenced vertex count
+size_t optimize_vertex_fetch_remap(uint32_t* remap, const uint32_t* indices, size_t index_count, size_t vertex_count);
+
+void remap_index_buffer(uint32_t* indices, size_t index_count, const uint32_t* remap);
+
+// Gathers vertex_size bytes of each referenced vertex into a tightly packed dst, vertex_stride is the source stride
+void remap_vertex_buffer(void* dst, const void* vertices, size_t vertex_count, size_t vertex_size, size_t vertex_stride, const uint32_t* remap);
+
+struct Meshlet
+{
+    uint32_t vertex_offset   = 0; // into MeshletSet::vertices
+    uint32_t triangle_offset = 0; // into MeshletSet::triangles, 3 bytes per triangle
+    uint32_t vertex_count    = 0;
+    uint32_t triangle_count  = 0;
+};
+
+struct MeshletBounds
+{
+    float center[3] = {0.0f, 0.0f, 0.0f};
+    float radius    = 0.0f;
+
+    // Backface cone: cull when dot(normalize(apex - eye), axis) >= cutoff, cutoff 1 never culls
+    float cone_apex[3] = {0.0f, 0.0f, 0.0f};
+    float cone_axis[3] = {0.0f, 0.0f, 0.0f};
+    float cone_cutoff  = 1.0f;
+};
+
+struct MeshletSet
+{
+    std::vector<Meshlet>       meshlets;
+    std::vector<MeshletBounds> bounds;
+    std::vector<uint32_t>      vertices;  // geometry vertex index
+    std::vector<uint8_t>       triangles; // meshlet local vertex index
+};
+
+// Splits the index buffer in order into meshlets of at most max_vertices/max_triangles, run it on
+// a vertex cache optimized buffer for good locality. max_vertices and max_triangles are capped at 256
+void build_meshlets(MeshletSet& result, const uint32_t* indices, size_t index_count, size_t max_vertices = 64, size_t max_triangles = 124);
+
+void compute_meshlet_bounds(MeshletSet& meshlets, const float* positions, size_t position_stride);
+
+// Quadric error edge collapse (Garland-Heckbert) onto existing vertices, stops at target_index_count
+// or when the next collapse would move the surface more than target_error (object space distance).
+// Border and seam vertices are locked. Returns the new index count, result_error gets the max error
+size_t simplify(uint32_t* dst, const uint32_t* indices, size_t index_count, const float* positions, size_t vertex_count, size_t position_stride, size_t target_index_count, float target_error, float* result_error = nullptr);
+
+// Transformed vertices per triangle on a FIFO post-transform cache, 0.5 is the ideal for large meshes
+float analyze_acmr(const uint32_t* indices, size_t index_count, size_t vertex_count, uint32_t cache_size = 16);
+
+} // namespace meshopt
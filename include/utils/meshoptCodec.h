@@ -0,0 +1,25 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Decoders of the EXT_meshopt_compression bitstreams (vertex codec v0, index codec v0/v1, index
+// sequence v1) and its filters. All of them return false on malformed input
+namespace meshopt
+{
+
+// ATTRIBUTES mode, vertex_size is a multiple of 4 up to 256
+bool decode_vertex_buffer(void* dst, size_t vertex_count, size_t vertex_size, const unsigned char* buffer, size_t buffer_size);
+
+// TRIANGLES mode, index_size is 2 or 4
+bool decode_index_buffer(void* dst, size_t index_count, size_t index_size, const unsigned char* buffer, size_t buffer_size);
+
+// INDICES mode, index_size is 2 or 4
+bool decode_index_sequence(void* dst, size_t index_count, size_t index_size, const unsigned char* buffer, size_t buffer_size);
+
+// In place on decoded data, stride is the byteStride of the buffer view
+void decode_filter_oct(void* data, size_t count, size_t stride);
+void decode_filter_quat(void* data, size_t count, size_t stride);
+void decode_filter_exp(void* data, size_t count, size_t stride);
+
+} // namespace meshopt
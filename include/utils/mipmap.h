@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// CPU mip chains packed level after level, level 0 first, the layout acre reads for KTX2 chains.
+// Each level is filtered from the unquantized float level above it, rows in parallel on the worker pool
+namespace mipmap
+{
+
+enum class Filter : uint8_t
+{
+    fBox,    // 2x2 average
+    fKaiser, // Kaiser windowed sinc over 8 taps per axis, keeps detail the box blurs away
+};
+
+struct Options
+{
+    Filter filter = Filter::fKaiser;
+    bool   srgb   = false; // rgb is sRGB encoded, filtered in linear space (rgba8 only)
+    // Alpha test threshold of masked materials, > 0 rescales the alpha of every level so the share
+    // of texels passing the test stays that of level 0
+    float alpha_cutoff = 0.0f;
+};
+
+// Levels down to 1x1
+uint32_t level_count(uint32_t width, uint32_t height);
+
+// Pixels of the packed chain, offsets (optional) receives the first pixel of each level
+size_t chain_pixels(uint32_t width, uint32_t height, uint32_t levels, std::vector<size_t>* offsets = nullptr);
+
+// dst receives the full chain of the rgba8 image, level 0 copied as is, returns the level count
+uint32_t build_rgba8(const unsigned char* src, uint32_t width, uint32_t height, const Options& options, std::vector<unsigned char>& dst);
+
+// Same for linear rgba32f, srgb is ignored
+uint32_t build_rgba32f(const float* src, uint32_t width, uint32_t height, const Options& options, std::vector<float>& dst);
+
+} // namespace mipmap
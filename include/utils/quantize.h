@@ -0,0 +1,29 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Float vertex streams to compact encodings, src streams are float with any byte stride
+namespace quantize
+{
+
+// unorm16x4 (w = 0), p = offset + q / 65535 * scale
+void positions_unorm16(uint16_t* dst, const unsigned char* src, size_t count, size_t stride, const float offset[3], const float scale[3]);
+
+// octahedral snorm16x2
+void normals_oct16(int16_t* dst, const unsigned char* src, size_t count, size_t stride);
+
+// octahedral snorm16x2 + handedness as snorm16, padded to x4
+void tangents_oct16(int16_t* dst, const unsigned char* src, size_t count, size_t stride);
+
+// half2
+void uvs_half(uint16_t* dst, const unsigned char* src, size_t count, size_t stride);
+
+// unorm8x4, renormalized so the four weights still sum to exactly 255
+void weights_unorm8(uint8_t* dst, const unsigned char* src, size_t count, size_t stride);
+
+void encode_octahedral(const float n[3], int16_t out[2]);
+
+void decode_octahedral(const int16_t in[2], float n[3]);
+
+} // namespace quantize
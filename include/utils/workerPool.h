@@ -0,0 +1,52 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class WorkerPool
+{
+    std::vector<std::thread>          m_threads;
+    std::deque<std::function<void()>> m_tasks;
+    std::mutex                        m_mutex;
+    std::condition_variable           m_cv;
+    bool                              m_stop = false;
+
+public:
+    // count == 0 means hardware_concurrency - 1 (the caller thread also works in parallel_for)
+    explicit WorkerPool(uint32_t count = 0);
+
+    ~WorkerPool();
+
+    static WorkerPool& global();
+
+    auto thread_count() const { return uint32_t(m_threads.size()); }
+
+    template <typename Func>
+    auto submit(Func&& func)
+    {
+        using Result = std::invoke_result_t<Func>;
+
+        auto task   = std::make_shared<std::packaged_task<Result()>>(std::forward<Func>(func));
+        auto future = task->get_future();
+        _push([task]() { (*task)(); });
+        return future;
+    }
+
+    /**
+     * @brief run func(i) for i in [0, count), blocks until all items are done
+     * @note the calling thread takes part in the work, so it is safe to call from a worker
+     */
+    void parallel_for(size_t count, const std::function<void(size_t)>& func);
+
+private:
+    void _push(std::function<void()>&& task);
+
+    void _worker_loop();
+};
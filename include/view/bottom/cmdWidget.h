@@ -8,6 +8,7 @@
 #include <QCompleter>
 
 #include <functional>
+#include <string>
 
 class SceneMgr;
 class CmdController;
@@ -36,6 +37,8 @@ public:
 
     void set_saveframe_callback(std::function<void()> func);
 
+    void set_load_callback(std::function<bool(const std::string&, const std::string&)> func);
+
 private:
     void _init_cmd();
 
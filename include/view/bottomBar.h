@@ -4,6 +4,7 @@
 #include <QVBoxLayout>
 
 #include <functional>
+#include <string>
 
 class SceneMgr;
 class InfoWidget;
@@ -27,6 +28,8 @@ public:
 
     void set_pickpixel_callback(std::function<void(uint32_t, uint32_t)> func);
 
+    void set_load_callback(std::function<bool(const std::string&, const std::string&)> func);
+
     void flush_state();
 
     void show_profiler(const std::string& profiler);
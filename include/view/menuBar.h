@@ -4,20 +4,27 @@
 #include <QAction>
 
 #include <functional>
+#include <memory>
+#include <vector>
 
 class SceneMgr;
 class Loader;
+class LoadController;
 class MenuBar : QMenuBar
 {
     SceneMgr* m_scene  = nullptr;
     Loader*   m_loader = nullptr;
 
-    std::function<void()>                            m_renderframe_func;
-    std::function<void()>                            m_flushstate_func;
-    std::function<void()>                            m_resetview_func;
-    std::function<void(const std::string& fileName)> m_saveframe_func;
-    std::function<void(const std::string& fileName)> m_start_record_func;
-    std::function<void()>                            m_stop_record_func;
+    // Scene files load as background jobs, the controller owns their loaders
+    std::unique_ptr<LoadController> m_load_controller;
+
+    std::function<void()>                                        m_renderframe_func;
+    std::function<void()>                                        m_flushstate_func;
+    std::function<void()>                                        m_resetview_func;
+    std::function<void(const std::string& fileName)>             m_saveframe_func;
+    std::function<void(const std::string& fileName)>             m_start_record_func;
+    std::function<void()>                                        m_stop_record_func;
+    std::function<void(const std::string& message, int timeout)> m_loadstatus_func;
 
     QMenu*   m_menu_file;
     QMenu*   m_menu_file_scene;
@@ -27,11 +34,13 @@ class MenuBar : QMenuBar
     QAction* m_action_close_scene;
     QAction* m_action_add_scene;
     QAction* m_action_save_scene;
+    QAction* m_action_cancel_load;
     QAction* m_action_save_frame;
     QAction* m_action_start_record;
     QAction* m_action_stop_record;
     QAction* m_action_open_image;
     QAction* m_action_open_hdr;
+    QAction* m_action_prepare_environment;
     QAction* m_action_open_lut_ggx;
     QAction* m_action_open_lut_charlie;
     QAction* m_action_open_lut_sheen_albedo_scale;
@@ -56,6 +65,8 @@ class MenuBar : QMenuBar
 public:
     explicit MenuBar(SceneMgr* scene, QWidget* parent = nullptr);
 
+    ~MenuBar();
+
     auto getMenuBar() { return static_cast<QMenuBar*>(this); }
 
     void set_renderframe_callback(std::function<void()> func) { m_renderframe_func = func; }
@@ -70,8 +81,17 @@ public:
 
     void set_stop_record_callback(std::function<void()> func) { m_stop_record_func = func; }
 
+    // Status bar text of the load jobs, timeout in ms (0 while the job runs)
+    void set_loadstatus_callback(std::function<void(const std::string& message, int timeout)> func) { m_loadstatus_func = func; }
+
     void save_frame() { _on_save_frame(); }
 
+    /**
+     * @brief open, add or cancel scene loads from the command line
+     * @note mode is "scene" (replaces the scene), "add" or "cancel" (fileName unused), false for an unknown mode
+     */
+    bool load(const std::string& mode, const std::string& fileName);
+
 private:
     void _init_file_menu();
     void _init_edit_menu();
@@ -86,6 +106,7 @@ private:
     void _on_open_lut_charlie();
     void _on_open_lut_sheen_albedo_scale();
     void _on_save_scene();
+    void _on_cancel_load();
     void _on_save_frame();
     void _on_start_record();
     void _on_stop_record();
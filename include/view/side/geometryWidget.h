@@ -1,6 +1,7 @@
 #pragma once
 
 #include <acre/render/scene/geometry.h>
+#include <model/wrapper/resource.h>
 
 #include <QWidget>
 #include <QCheckBox>
@@ -37,7 +38,7 @@ public:
 
     ~GeometryWidget();
 
-    void set_geometry(uint32_t uuid);
+    void set_geometry(acre::UUID uuid);
 
     void update_properties();
 
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <acre/render/scene/light.h>
+#include <model/wrapper/resource.h>
 
 #include <QWidget>
 #include <QLabel>
@@ -72,7 +73,7 @@ public:
 
     void set_renderframe_callback(std::function<void()> func) { m_renderframe_func = func; }
 
-    void set_light(uint32_t uuid);
+    void set_light(acre::UUID uuid);
 
     void enable_sun();
     void disable_sun();
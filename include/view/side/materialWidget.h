@@ -1,6 +1,7 @@
 #pragma once
 
 #include <acre/render/scene/material.h>
+#include <model/wrapper/resource.h>
 
 #include <QWidget>
 #include <QLabel>
@@ -68,7 +69,7 @@ public:
 
     void set_renderframe_callback(std::function<void()> func) { m_renderframe_func = func; }
 
-    void set_material(uint32_t uuid);
+    void set_material(acre::UUID uuid);
 
     void update_properties();
 
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <acre/render/scene/transform.h>
+#include <model/wrapper/resource.h>
 
 #include <QWidget>
 #include <QLabel>
@@ -37,7 +38,7 @@ public:
 
     ~TransformWidget();
 
-    void set_transform(uint32_t uuid);
+    void set_transform(acre::UUID uuid);
 
     void update_properties();
 
@@ -1,7 +1,4 @@
 #include <controller/animationController.h>
-#include <unordered_set>
-#include <unordered_map>
-#include <algorithm>
 
 AnimationController::AnimationController(SceneMgr* scene) :
     m_scene(scene), m_current(nullptr), m_time(0.0f)
@@ -9,8 +6,9 @@ AnimationController::AnimationController(SceneMgr* scene) :
 
 void AnimationController::play(const std::string& name)
 {
-    m_current = m_scene->animation_set()->animation(name);
-    m_time    = 0.0f;
+    m_current    = m_scene->animation_set()->animation(name);
+    m_time       = 0.0f;
+    m_generation = m_scene->generation();
 }
 
 void AnimationController::stop()
@@ -26,6 +24,14 @@ void AnimationController::stop()
 
 void AnimationController::update(float delta_time)
 {
+    // The clips went with the scene they were loaded into, the next scene's first clip plays
+    if (m_generation != m_scene->generation())
+    {
+        m_generation = m_scene->generation();
+        m_current    = nullptr;
+        m_time       = 0.0f;
+    }
+
     if (!m_current) _try_play();
     if (!m_current) return;
 
@@ -60,12 +66,12 @@ void AnimationController::_try_play()
 
 void AnimationController::_update_sampled_values()
 {
-    // Sample and cache each channel's animation value (linear interpolation only)
+    // Sample and cache each channel's animation value (linear or step, cubic splines sample linearly)
     m_sampled_values.clear();
     for (const auto& channel : m_current->channels)
     {
         const auto& sampler    = m_current->samplers[channel.sampler_idx];
-        size_t      frameCount = sampler.input.size();
+        size_t      frameCount = std::min(sampler.input.size(), sampler.output.count());
         if (frameCount < 2)
         {
             m_sampled_values.push_back({});
@@ -77,14 +83,16 @@ void AnimationController::_update_sampled_values()
             ++idx;
         if (idx >= frameCount - 1) idx = frameCount - 2;
 
-        float       t0     = sampler.input[idx];
-        float       t1     = sampler.input[idx + 1];
-        const auto& v0     = sampler.output[idx];
-        const auto& v1     = sampler.output[idx + 1];
-        float       localT = (t1 > t0) ? (m_time - t0) / (t1 - t0) : 0.0f;
+        float t0     = sampler.input[idx];
+        float t1     = sampler.input[idx + 1];
+        float localT = (t1 > t0 && sampler.interpolation != "STEP") ? (m_time - t0) / (t1 - t0) : 0.0f;
+
+        float v0[acre::KeyframeStore::kMaxComponents], v1[acre::KeyframeStore::kMaxComponents];
+        sampler.output.read(idx, v0);
+        sampler.output.read(idx + 1, v1);
 
-        std::vector<float> value(v0.size());
-        for (size_t i = 0; i < v0.size(); ++i)
+        std::vector<float> value(sampler.output.components());
+        for (size_t i = 0; i < value.size(); ++i)
             value[i] = v0[i] + (v1[i] - v0[i]) * localT;
 
         m_sampled_values.push_back(value);
@@ -93,140 +101,98 @@ void AnimationController::_update_sampled_values()
 
 void AnimationController::_update_scene()
 {
-    const auto& channels = m_current->channels;
+    auto asset = m_scene->asset(m_current->asset);
+    if (!asset) return;
 
-    // First pass: apply sampled components into each node's local TRS fields
+    const auto& channels  = m_current->channels;
+    auto&       hierarchy = asset->hierarchy;
+
+    // Sampled components go into the local TRS arrays, the solver then recomputes the marked
+    // nodes and everything below them in one pass
     for (size_t idx = 0; idx < channels.size(); ++idx)
     {
         const auto& channel = channels[idx];
         const auto& value   = sampled_value(idx);
-        if (value.empty()) continue;
-        auto node = m_scene->find<acre::TransformID>(channel.target_node);
-        if (!node) continue;
-        auto trs = node->ptr<acre::TransformID>();
-        if (!trs) continue;
+        if (value.empty() || channel.target_node < 0) continue;
+
+        auto slot = hierarchy.slot(channel.target_node);
+        if (slot == acre::TransformHierarchy::kNoSlot) continue;
 
         if (channel.target_path == "scale" && value.size() >= 3)
         {
-            trs->scale = acre::math::float3(value[0], value[1], value[2]);
+            hierarchy.scales[slot] = acre::math::float3(value[0], value[1], value[2]);
         }
         else if (channel.target_path == "rotation" && value.size() >= 4)
         {
-            trs->rotation = acre::math::quat(value[3], value[0], value[1], value[2]);
+            hierarchy.rotations[slot] = acre::math::quat(value[3], value[0], value[1], value[2]);
         }
         else if (channel.target_path == "translation" && value.size() >= 3)
         {
-            trs->translation = acre::math::float3(value[0], value[1], value[2]);
+            hierarchy.translations[slot] = acre::math::float3(value[0], value[1], value[2]);
         }
-    }
-
-    // Second pass: collect affected nodes, deduplicate and process from root-to-leaf
-    std::unordered_set<int> affected_nodes;
-    for (const auto& ch : channels)
-        affected_nodes.insert(ch.target_node);
-
-    std::vector<int> nodes(affected_nodes.begin(), affected_nodes.end());
-    // cache depths to avoid repeated scene lookups
-    std::unordered_map<int, int> depth_cache;
-    auto                         compute_depth = [&](int nid) -> int {
-        auto it = depth_cache.find(nid);
-        if (it != depth_cache.end()) return it->second;
-        int  d = 0;
-        auto n = m_scene->find<acre::TransformID>(nid);
-        while (n && n->parent)
+        else
         {
-            ++d;
-            n = m_scene->find<acre::TransformID>(n->parent->uuid());
+            continue;
         }
-        depth_cache[nid] = d;
-        return d;
-    };
+        hierarchy.mark(slot);
+    }
 
-    std::sort(nodes.begin(), nodes.end(), [&](int a, int b) {
-        return compute_depth(a) < compute_depth(b);
-    });
+    hierarchy.update_dirty(m_changed);
 
-    for (int node_idx : nodes)
+    for (auto slot : m_changed)
     {
-        auto node = m_scene->find<acre::TransformID>(node_idx);
+        auto node = m_scene->find<acre::TransformID>(acre::make_uuid(m_current->asset, hierarchy.nodes[slot]));
         if (!node) continue;
-        auto trs = node->ptr<acre::TransformID>();
-        if (!trs) continue;
 
-        // Compose local affine from stored local TRS
-        auto local = acre::math::affine3::identity();
-        local *= acre::math::scaling(trs->scale);
-        local *= trs->rotation.toAffine();
-        local *= acre::math::translation(trs->translation);
+        auto trs         = node->ptr<acre::TransformID>();
+        trs->scale       = hierarchy.scales[slot];
+        trs->rotation    = hierarchy.rotations[slot];
+        trs->translation = hierarchy.translations[slot];
+        trs->affine      = hierarchy.worlds[slot];
+        trs->matrix      = acre::math::affineToHomogeneous(trs->affine);
+        m_scene->update(node);
 
-        auto world = local;
-        if (node->parent)
-        {
-            auto parent = m_scene->find<acre::TransformID>(node->parent->uuid());
-            if (parent)
-            {
-                world = local * parent->ptr<acre::TransformID>()->affine;
-            }
-        }
+        _update_attached(hierarchy, node);
+    }
 
-        // Update Transform matrix (world)
-        trs->affine = world;
-        trs->matrix = acre::math::affineToHomogeneous(world);
-        m_scene->update(node);
+    if (!m_changed.empty()) _update_skins(*asset);
+}
 
-        auto skin = m_scene->find<acre::SkinID>(node_idx);
-        if (skin)
-        {
-            auto skinptr             = skin->ptr<acre::SkinID>();
-            auto inverse_node_matrix = skinptr->inverse_node_matrix;
-            auto inverse_bind_matrix = skinptr->inverse_bind_matrix;
-            skinptr->joint_matrix    = inverse_bind_matrix * trs->matrix * inverse_node_matrix;
-            skinptr->joint_affine    = acre::math::homogeneousToAffine(skinptr->joint_matrix);
-            m_scene->update(skin);
-        }
+void AnimationController::_update_skins(SceneAsset& asset)
+{
+    auto& palette = asset.skins;
+    if (palette.instances.empty()) return;
 
-        // Propagate to children (compute child's global from child's local * parent_global)
-        _update_children(node);
+    // Joints and skinned nodes both move the palette, it is recomputed as a whole
+    palette.update(asset.hierarchy);
+
+    for (auto joint_node : palette.skinned_joints)
+    {
+        auto skin = m_scene->find<acre::SkinID>(acre::make_uuid(m_current->asset, joint_node));
+        if (!skin || !palette.write_skin(joint_node, *skin->ptr<acre::SkinID>())) continue;
+
+        m_scene->update(skin);
     }
 }
 
-void AnimationController::_update_children(acre::Resource* node)
+void AnimationController::_update_attached(const acre::TransformHierarchy& hierarchy, acre::Resource* node)
 {
-    if (!node) return;
-
     auto node_trs = node->ptr<acre::TransformID>();
-    auto children = node->children;
-    if (children.empty()) return;
 
-    for (auto child : children)
+    // Transforms parented to a node outside of the hierarchy (EXT_mesh_gpu_instancing instances)
+    for (auto child : node->children)
     {
-        if (!child) continue;
+        if (!child || hierarchy.slot(acre::local_of(child->uuid())) != acre::TransformHierarchy::kNoSlot) continue;
 
         auto child_trs = child->ptr<acre::TransformID>();
 
-        // Compose child's local affine from stored local TRS
         auto local = acre::math::affine3::identity();
         local *= acre::math::scaling(child_trs->scale);
         local *= child_trs->rotation.toAffine();
         local *= acre::math::translation(child_trs->translation);
 
-        // global = local * parent_global (matches loader convention)
         child_trs->affine = local * node_trs->affine;
         child_trs->matrix = acre::math::affineToHomogeneous(child_trs->affine);
-
         m_scene->update(child);
-
-        auto skin = m_scene->find<acre::SkinID>(child->uuid());
-        if (skin)
-        {
-            auto inverse_node_matrix                = skin->ptr<acre::SkinID>()->inverse_node_matrix;
-            auto inverse_bind_matrix                = skin->ptr<acre::SkinID>()->inverse_bind_matrix;
-            skin->ptr<acre::SkinID>()->joint_matrix = inverse_bind_matrix * child_trs->matrix * inverse_node_matrix;
-            skin->ptr<acre::SkinID>()->joint_affine = acre::math::homogeneousToAffine(skin->ptr<acre::SkinID>()->joint_matrix);
-            m_scene->update(skin);
-        }
-
-        // Recurse
-        _update_children(child);
     }
 }
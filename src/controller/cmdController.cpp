@@ -1,7 +1,10 @@
 #include <controller/cmdController.h>
 
 #include <model/sceneMgr.h>
+#include <utils/benchmark.h>
 
+#include <algorithm>
+#include <charconv>
 #include <sstream>
 #include <tuple>
 #include <map>
@@ -25,6 +28,8 @@ static std::map<std::string, CmdController::CmdType> g_cmdTypeMap = {
     {"rotate", CmdController::CmdType::cRotate},
     {"reset_alive", CmdController::CmdType::cUnAlive},
     {"load", CmdController::CmdType::cLoad},
+    {"bench", CmdController::CmdType::cBench},
+    {"residency", CmdController::CmdType::cResidency},
 };
 
 static auto findCmdType(const std::string& token)
@@ -61,9 +66,29 @@ static auto splitCommand(const std::string& input)
     return std::make_tuple(cmd, params);
 }
 
-static uint32_t toID(std::string entity)
+static constexpr acre::UUID kInvalidUUID = ~acre::UUID(0);
+
+// "<uuid>" as a 64 bit number or "<asset>:<local>", kInvalidUUID when it is neither
+static acre::UUID toID(const std::string& entity)
 {
-    return std::stoi(entity);
+    auto parse = [](const char* first, const char* last, auto& value) {
+        auto [end, error] = std::from_chars(first, last, value);
+        return error == std::errc() && end == last;
+    };
+
+    auto first = entity.data();
+    auto last  = entity.data() + entity.size();
+    auto colon = std::find(first, last, ':');
+    if (colon == last)
+    {
+        acre::UUID uuid = 0;
+        return parse(first, last, uuid) ? uuid : kInvalidUUID;
+    }
+
+    acre::AssetID asset = 0;
+    uint32_t      local = 0;
+    if (!parse(first, colon, asset) || !parse(colon + 1, last, local)) return kInvalidUUID;
+    return acre::make_uuid(asset, local);
 }
 
 CmdController::CmdStatus CmdController::execute(const std::string& command)
@@ -92,6 +117,8 @@ CmdController::CmdStatus CmdController::execute(const std::string& command)
         case CmdController::CmdType::cRotate: status = rotate(params); break;
         case CmdController::CmdType::cUnAlive: status = reset_alive(params); break;
         case CmdController::CmdType::cLoad: status = load(params); break;
+        case CmdController::CmdType::cBench: status = bench(params); break;
+        case CmdController::CmdType::cResidency: status = residency(params); break;
     }
 
     std::string result = ">> ";
@@ -191,21 +218,24 @@ CmdController::CmdStatus CmdController::hightlight(const std::vector<std::string
     if (params.size() != 2) return CmdStatus::eInvalidParam;
 
     auto id = toID(params[1]);
-    if (id == RESOURCE_ID_VALID) return CmdStatus::eInvalidID;
+    if (id == kInvalidUUID) return CmdStatus::eInvalidID;
 
     if (params[0] == "entity")
     {
         auto node = m_scene->find<acre::EntityID>(id);
+        if (!node) return CmdStatus::eInvalidID;
         m_scene->highlight_entity(node->id<acre::EntityID>());
     }
     else if (params[0] == "geometry")
     {
         auto node = m_scene->find<acre::GeometryID>(id);
+        if (!node) return CmdStatus::eInvalidID;
         m_scene->highlight_geometry(node->id<acre::GeometryID>());
     }
     else if (params[0] == "material")
     {
         auto node = m_scene->find<acre::MaterialID>(id);
+        if (!node) return CmdStatus::eInvalidID;
         m_scene->highlight_material(node->id<acre::MaterialID>());
     }
     else
@@ -221,21 +251,24 @@ CmdController::CmdStatus CmdController::unhighlight(const std::vector<std::strin
     if (params.size() != 2) return CmdStatus::eInvalidParam;
 
     auto id = toID(params[1]);
-    if (id == RESOURCE_ID_VALID) return CmdStatus::eInvalidID;
+    if (id == kInvalidUUID) return CmdStatus::eInvalidID;
 
     if (params[0] == "entity")
     {
         auto node = m_scene->find<acre::EntityID>(id);
+        if (!node) return CmdStatus::eInvalidID;
         m_scene->unhighlight_entity(node->id<acre::EntityID>());
     }
     else if (params[0] == "geometry")
     {
         auto node = m_scene->find<acre::GeometryID>(id);
+        if (!node) return CmdStatus::eInvalidID;
         m_scene->unhighlight_geometry(node->id<acre::GeometryID>());
     }
     else if (params[0] == "material")
     {
         auto node = m_scene->find<acre::MaterialID>(id);
+        if (!node) return CmdStatus::eInvalidID;
         m_scene->unhighlight_material(node->id<acre::MaterialID>());
     }
     else
@@ -251,21 +284,24 @@ CmdController::CmdStatus CmdController::remove(const std::vector<std::string>& p
     if (params.size() != 2) return CmdStatus::eInvalidParam;
 
     auto id = toID(params[1]);
-    if (id == RESOURCE_ID_VALID) return CmdStatus::eInvalidID;
+    if (id == kInvalidUUID) return CmdStatus::eInvalidID;
 
     if (params[0] == "entity")
     {
         auto node = m_scene->find<acre::EntityID>(id);
+        if (!node) return CmdStatus::eInvalidID;
         m_scene->remove(node);
     }
     else if (params[0] == "geometry")
     {
         auto node = m_scene->find<acre::GeometryID>(id);
+        if (!node) return CmdStatus::eInvalidID;
         m_scene->remove(node);
     }
     else if (params[0] == "material")
     {
         auto node = m_scene->find<acre::MaterialID>(id);
+        if (!node) return CmdStatus::eInvalidID;
         m_scene->remove(node);
     }
     else
@@ -281,7 +317,7 @@ CmdController::CmdStatus CmdController::move(const std::vector<std::string>& par
     if (params.size() != 3) return CmdStatus::eInvalidParam;
 
     auto id = toID(params[1]);
-    if (id == RESOURCE_ID_VALID) return CmdStatus::eInvalidID;
+    if (id == kInvalidUUID) return CmdStatus::eInvalidID;
 
     if (params[0] == "entity")
     {
@@ -305,7 +341,7 @@ CmdController::CmdStatus CmdController::rotate(const std::vector<std::string>& p
     if (params.size() != 3) return CmdStatus::eInvalidParam;
 
     auto id = toID(params[1]);
-    if (id == RESOURCE_ID_VALID) return CmdStatus::eInvalidID;
+    if (id == kInvalidUUID) return CmdStatus::eInvalidID;
 
     if (params[0] == "entity")
     {
@@ -329,11 +365,12 @@ CmdController::CmdStatus CmdController::active(const std::vector<std::string>& p
     if (params.size() != 2) return CmdStatus::eInvalidParam;
 
     auto id = toID(params[1]);
-    if (id == RESOURCE_ID_VALID) return CmdStatus::eInvalidID;
+    if (id == kInvalidUUID) return CmdStatus::eInvalidID;
 
     if (params[0] == "entity")
     {
         auto node = m_scene->find<acre::EntityID>(id);
+        if (!node) return CmdStatus::eInvalidID;
         m_scene->alive_entity(node->id<acre::EntityID>());
     }
     else
@@ -349,11 +386,12 @@ CmdController::CmdStatus CmdController::reset_alive(const std::vector<std::strin
     if (params.size() != 2) return CmdStatus::eInvalidParam;
 
     auto id = toID(params[1]);
-    if (id == RESOURCE_ID_VALID) return CmdStatus::eInvalidID;
+    if (id == kInvalidUUID) return CmdStatus::eInvalidID;
 
     if (params[0] == "entity")
     {
         auto node = m_scene->find<acre::EntityID>(id);
+        if (!node) return CmdStatus::eInvalidID;
         m_scene->unalive_entity(node->id<acre::EntityID>());
     }
     else
@@ -366,22 +404,52 @@ CmdController::CmdStatus CmdController::reset_alive(const std::vector<std::strin
 
 CmdController::CmdStatus CmdController::load(const std::vector<std::string>& params)
 {
-    if (params.size() != 3) return CmdStatus::eInvalidParam;
+    if (params.empty() || !m_load_func) return CmdStatus::eInvalidParam;
 
-    auto id = toID(params[1]);
-    if (id == RESOURCE_ID_VALID) return CmdStatus::eInvalidID;
+    // load scene <file>, load add <file>, load cancel. Loads run in the background, the status bar
+    // follows them
+    if (params[0] == "scene" || params[0] == "add")
+    {
+        if (params.size() != 2) return CmdStatus::eInvalidParam;
 
-    if (params[0] == "image")
+        m_load_func(params[0], params[1]);
+    }
+    else if (params[0] == "cancel")
     {
+        if (params.size() != 1) return CmdStatus::eInvalidParam;
+
+        m_load_func(params[0], "");
     }
-    else if (params[0] == "scene")
+    else
     {
+        return CmdStatus::eUnSupportedParam;
     }
-    else if (params[0] == "obj")
+
+    return CmdStatus::eSuccess;
+}
+
+CmdController::CmdStatus CmdController::bench(const std::vector<std::string>& params)
+{
+    if (params.size() < 1 || params.size() > 2) return CmdStatus::eInvalidParam;
+
+    size_t count = 10'000'000;
+    if (params.size() == 2)
     {
+        count = std::stoull(params[1]);
+        if (count == 0) return CmdStatus::eInvalidParam;
     }
-    else if (params[0] == "gltf")
+
+    if (params[0] == "bounds")
     {
+        m_history.append(benchmark::bounds(count));
+    }
+    else if (params[0] == "attributes")
+    {
+        m_history.append(benchmark::attributes(count));
+    }
+    else if (params[0] == "luts")
+    {
+        m_history.append(benchmark::luts(params.size() == 2 ? count : 1024));
     }
     else
     {
@@ -390,3 +458,30 @@ CmdController::CmdStatus CmdController::load(const std::vector<std::string>& par
 
     return CmdStatus::eSuccess;
 }
+
+// "residency [budget_mb]": the texture residency stats, after setting the budget when given
+CmdController::CmdStatus CmdController::residency(const std::vector<std::string>& params)
+{
+    if (params.size() > 1) return CmdStatus::eInvalidParam;
+
+    if (params.size() == 1)
+    {
+        auto budget = std::stoull(params[0]);
+        if (budget == 0) return CmdStatus::eInvalidParam;
+
+        m_scene->set_texture_budget(uint64_t(budget) << 20);
+    }
+
+    const auto& stats = m_scene->residency_stats();
+
+    char line[256];
+    snprintf(line, sizeof(line), "textures %.1f / %.1f MB resident (budget %.1f MB), %u images, %u reduced, %u drawn, %u loading\n",
+             stats.resident_bytes / (1024.0 * 1024.0), stats.full_bytes / (1024.0 * 1024.0), stats.budget / (1024.0 * 1024.0), stats.images,
+             stats.reduced_images, stats.used_images, stats.loading);
+    m_history.append(line);
+    snprintf(line, sizeof(line), "%llu evictions (%.1f MB), %llu reloads (%.1f MB)\n", (unsigned long long)stats.evictions,
+             stats.evicted_bytes / (1024.0 * 1024.0), (unsigned long long)stats.reloads, stats.reloaded_bytes / (1024.0 * 1024.0));
+    m_history.append(line);
+
+    return CmdStatus::eSuccess;
+}
@@ -0,0 +1,228 @@
+#include <controller/loadController.h>
+
+#include <model/sceneMgr.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+
+LoadController::LoadController(SceneMgr* scene) :
+    m_scene(scene)
+{
+}
+
+LoadController::~LoadController()
+{
+    // No callbacks into a view that may be gone, the loader destructors wait for their worker tasks
+    m_status_func    = nullptr;
+    m_ready_func     = nullptr;
+    m_committed_func = nullptr;
+    cancel_all();
+    m_retired.clear();
+    m_loaders.clear();
+}
+
+uint32_t LoadController::open(const std::string& fileName)
+{
+    // The new scene supersedes whatever was still loading
+    cancel_all();
+    return _push(fileName, true);
+}
+
+uint32_t LoadController::add(const std::string& fileName)
+{
+    return _push(fileName, false);
+}
+
+uint32_t LoadController::_push(const std::string& fileName, bool replace)
+{
+    auto& job     = m_jobs.emplace_back();
+    job.id        = m_next_job++;
+    job.file_name = fileName;
+    job.replace   = replace;
+    job.start     = std::chrono::steady_clock::now();
+
+    // An add committed before the open it follows would be cleared with the old scene
+    auto after_open = std::any_of(m_jobs.begin(), m_jobs.end() - 1, [](const Job& other) { return other.replace; });
+    auto id         = job.id;
+    if (after_open)
+        job.state = State::sQueued;
+    else
+        _start(job);
+
+    _schedule_poll();
+    return id;
+}
+
+void LoadController::_start(Job& job)
+{
+    // An open swaps the scenes in one step, an add commits in one step only when config asks for
+    // it and otherwise shows its geometry, previews and full images as they come in
+    auto config          = m_config;
+    config.progressive   = true;
+    config.atomic_commit = job.replace || m_config.atomic_commit;
+
+    auto loader = std::make_unique<GLTFLoader>(m_scene);
+    loader->set_config(config);
+
+    auto id = job.id;
+    if (job.replace) loader->set_commit_callback([this]() { _replace_scene(); });
+    if (!config.atomic_commit) loader->set_ready_callback([this, id]() { _ready(id); });
+    loader->set_loaded_callback([this, id]() { _end(id, State::sCommitted); });
+    loader->set_failed_callback([this, id]() { _end(id, State::sFailed); });
+
+    job.state  = State::sRunning;
+    job.atomic = config.atomic_commit;
+    job.start  = std::chrono::steady_clock::now();
+    job.loader = std::move(loader);
+    job.loader->loadScene(job.file_name);
+}
+
+LoadController::Job* LoadController::_find(uint32_t job)
+{
+    auto iter = std::find_if(m_jobs.begin(), m_jobs.end(), [job](const Job& item) { return item.id == job; });
+    return iter == m_jobs.end() ? nullptr : &*iter;
+}
+
+void LoadController::_replace_scene()
+{
+    m_scene->clear_scene();
+    m_loaders.clear();
+}
+
+void LoadController::_end(uint32_t id, State state)
+{
+    auto job = _find(id);
+    if (!job) return;
+
+    // The loader may be the one calling, it is moved rather than destroyed. What a canceled
+    // progressive add committed stays in the scene, its loader with it
+    job->state  = state;
+    auto status = _status(*job);
+    auto keep   = state == State::sCommitted || (state == State::sCanceled && !job->atomic);
+    if (job->loader) (keep ? m_loaders : m_retired).push_back(std::move(job->loader));
+    m_jobs.erase(m_jobs.begin() + (job - m_jobs.data()));
+
+    // Adds held back by an open start once it ended, whichever way
+    if (status.replace)
+    {
+        for (auto& other : m_jobs)
+        {
+            if (other.state == State::sQueued) _start(other);
+        }
+    }
+
+    if (m_status_func) m_status_func(status);
+    if (state == State::sCommitted && m_committed_func) m_committed_func(status);
+}
+
+void LoadController::_ready(uint32_t id)
+{
+    auto job = _find(id);
+    if (job && m_ready_func) m_ready_func(_status(*job));
+}
+
+bool LoadController::cancel(uint32_t job)
+{
+    auto item = _find(job);
+    if (!item) return false;
+
+    if (item->loader) item->loader->cancel();
+    _end(job, State::sCanceled);
+    return true;
+}
+
+void LoadController::cancel_all()
+{
+    // Newest first, adds queued behind an open would start once it ends
+    while (!m_jobs.empty())
+        cancel(m_jobs.back().id);
+}
+
+void LoadController::clear()
+{
+    cancel_all();
+    m_loaders.clear();
+    _reap();
+}
+
+LoadController::Status LoadController::_status(const Job& job) const
+{
+    Status status;
+    status.job        = job.id;
+    status.file_name  = job.file_name;
+    status.replace    = job.replace;
+    status.state      = job.state;
+    status.elapsed_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - job.start).count();
+    if (job.loader) status.progress = job.loader->progress();
+    return status;
+}
+
+void LoadController::_schedule_poll()
+{
+    if (m_polling) return;
+
+    // Once a frame through SceneMgr::process_pending, while a job runs or a loader waits to be destroyed
+    m_polling = true;
+    m_scene->post([this]() { _poll(); });
+}
+
+void LoadController::_poll()
+{
+    m_polling = false;
+    _reap();
+
+    // Collected first, the callbacks may start or cancel jobs
+    std::vector<Status> changed;
+    for (auto& job : m_jobs)
+    {
+        if (job.state != State::sRunning) continue;
+
+        auto        status = _status(job);
+        const auto& last   = job.reported;
+        if (status.progress.stage == last.stage && status.progress.done == last.done && status.progress.total == last.total) continue;
+
+        job.reported = status.progress;
+        changed.push_back(std::move(status));
+    }
+
+    if (m_status_func)
+    {
+        for (const auto& status : changed)
+            m_status_func(status);
+    }
+
+    if (!m_jobs.empty() || !m_retired.empty()) _schedule_poll();
+}
+
+void LoadController::_reap()
+{
+    // A canceled loader may still be parsing, or have a step queued in the scene
+    std::erase_if(m_retired, [](const auto& loader) { return !loader->busy(); });
+}
+
+std::string LoadController::describe(const Status& status)
+{
+    auto name = std::filesystem::path(status.file_name).filename().string();
+
+    char message[512];
+    switch (status.state)
+    {
+        case State::sQueued: snprintf(message, sizeof(message), "Queued %s", name.c_str()); break;
+        case State::sCommitted: snprintf(message, sizeof(message), "Loaded %s in %.1f s", name.c_str(), status.elapsed_ms / 1000.0); break;
+        case State::sCanceled: snprintf(message, sizeof(message), "Canceled loading %s", name.c_str()); break;
+        case State::sFailed: snprintf(message, sizeof(message), "Failed to load %s", name.c_str()); break;
+        default:
+        {
+            const auto& progress = status.progress;
+            if (!progress.stage)
+                snprintf(message, sizeof(message), "Loading %s", name.c_str());
+            else if (progress.total)
+                snprintf(message, sizeof(message), "Loading %s: %s %u/%u", name.c_str(), progress.stage, progress.done, progress.total);
+            else
+                snprintf(message, sizeof(message), "Loading %s: %s", name.c_str(), progress.stage);
+            break;
+        }
+    }
+    return message;
+}
@@ -1,7 +1,18 @@
 #include <controller/loader.h>
+#include <controller/loader/environmentCache.h>
+#include <utils/brdfLut.h>
+#include <utils/envmap.h>
+#include <utils/half.h>
+#include <utils/hash.h>
+#include <utils/mipmap.h>
+#include <utils/workerPool.h>
 
 #include <stb/stb_image.h>
+#include <chrono>
+#include <cmath>
+#include <cstring>
 #include <fstream>
+#include <iterator>
 #include <sstream>
 
 static auto splitSimpleText(const std::string& line)
@@ -16,6 +27,27 @@ static auto splitSimpleText(const std::string& line)
     return tokens;
 }
 
+// ImageRegistry keys of the standalone decodes, glTF images decode to rgba8 and never match. The
+// same file loaded as color and as data decodes differently
+static constexpr uint64_t kColorImage = 0x10;
+static constexpr uint64_t kKTX2Image  = 0x11;
+static constexpr uint64_t kDataImage  = 0x12;
+
+// stbi_loadf linearizes 8 bit images with this gamma unless stbi_ldr_to_hdr_gamma changes it
+static constexpr float kImageGamma = 2.2f;
+
+// Standalone images and LUTs belong to the editor, keyed by their path
+static auto fileUUID(const std::string& fileName)
+{
+    return acre::make_uuid(acre::kEditorAsset, uint32_t(std::hash<std::string>{}(fileName)));
+}
+
+static auto readBytes(const std::string& fileName)
+{
+    std::ifstream file(fileName, std::ios::binary);
+    return std::vector<unsigned char>((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+}
+
 static auto splitCameraParameter(const std::string& line)
 {
     std::stringstream        ss(line);
@@ -31,43 +63,179 @@ static auto splitCameraParameter(const std::string& line)
 Loader::Loader(SceneMgr* scene) :
     m_scene(scene) {}
 
-acre::Resource* Loader::createImage(const std::string& fileName)
+Loader::~Loader()
+{
+    for (auto& task : m_environment_tasks)
+        task.wait();
+}
+
+bool Loader::_set_compressed_image(acre::Image* image, const ktx2::Image& compressed)
+{
+#ifdef USE_KTX2
+    switch (compressed.format)
+    {
+        case ktx2::Format::fBC1_RGB: image->format = compressed.srgb ? acre::Image::Format::BC1_UNORM_SRGB : acre::Image::Format::BC1_UNORM; break;
+        case ktx2::Format::fBC3_RGBA: image->format = compressed.srgb ? acre::Image::Format::BC3_UNORM_SRGB : acre::Image::Format::BC3_UNORM; break;
+        case ktx2::Format::fBC5_RG: image->format = acre::Image::Format::BC5_UNORM; break;
+        case ktx2::Format::fBC7_RGBA: image->format = compressed.srgb ? acre::Image::Format::BC7_UNORM_SRGB : acre::Image::Format::BC7_UNORM; break;
+    }
+
+    image->data    = (void*)compressed.data.data();
+    image->width   = compressed.width;
+    image->height  = compressed.height;
+    image->mipmaps = uint32_t(compressed.level_offsets.size());
+    return true;
+#else
+    return false;
+#endif
+}
+
+acre::Resource* Loader::createImage(const std::string& fileName, bool color)
+{
+    auto bytes = readBytes(fileName);
+    return createImage(fileName, bytes, hash64(bytes.data(), bytes.size()), color);
+}
+
+acre::Resource* Loader::createImage(const std::string& fileName, const std::vector<unsigned char>& bytes, uint64_t content, bool color)
 {
-    auto node  = m_scene->create<acre::ImageID>(std::hash<std::string>{}(fileName));
+    if (bytes.empty())
+    {
+        printf("Failed to load %s\n", fileName.c_str());
+        return nullptr;
+    }
+
+    // Same content, same image: a file opened twice (or under another path) is decoded once
+    auto is_ktx2 = ktx2::is_ktx2(bytes.data(), bytes.size());
+    auto key     = hash_combine(content, is_ktx2 ? kKTX2Image : color ? kColorImage : kDataImage);
+    if (auto shared = m_scene->find_image(key)) return shared;
+
+    auto node  = m_scene->create<acre::ImageID>(fileUUID(fileName));
     auto image = node->ptr<acre::ImageID>();
 
-    int  width;
-    int  height;
-    int  channels;
-    int  desired   = 4;
-    auto imageData = stbi_loadf(fileName.c_str(), &width, &height, &channels, desired);
-    if (!imageData) return nullptr;
+    if (is_ktx2)
+    {
+        // Note: owned by the image like the mip chains below
+        ktx2::Texture texture;
+        auto          compressed = new ktx2::Image;
+        if (!ktx2::read(bytes.data(), bytes.size(), texture) || !ktx2::transcode(texture, false, *compressed) || !_set_compressed_image(image, *compressed))
+        {
+            printf("Failed to load %s\n", fileName.c_str());
+            delete compressed;
+            return nullptr;
+        }
+
+        image->name = fileName.c_str();
+        m_scene->add_image(key, node->uuid(), compressed->data.size());
+        return node;
+    }
+
+    int width    = 0;
+    int height   = 0;
+    int channels = 0;
+    if (!stbi_info_from_memory(bytes.data(), int(bytes.size()), &width, &height, &channels))
+    {
+        printf("Failed to load %s\n", fileName.c_str());
+        return nullptr;
+    }
+
+    // Data (LUTs) is kept as it is: 8 bit as RGBA8, 16 bit as RGBA16F. acre has no sRGB RGBA8
+    // format, so 8 and 16 bit color is linearized with the gamma stbi_loadf applies and stored as
+    // RGBA16F, as are HDR sources. acre has no one to three channel formats, grey is replicated and
+    // a missing alpha is 1. Mips are box filtered, HDR sources ring under the negative lobes of the
+    // Kaiser filter
+    mipmap::Options options;
+    options.filter = mipmap::Filter::fBox;
+
+    auto     hdr    = stbi_is_hdr_from_memory(bytes.data(), int(bytes.size())) != 0;
+    auto     wide   = !hdr && stbi_is_16_bit_from_memory(bytes.data(), int(bytes.size())) != 0;
+    uint32_t levels = 0;
+    size_t   size   = 0;
+    if (!hdr && !wide && !color)
+    {
+        auto imageData = stbi_load_from_memory(bytes.data(), int(bytes.size()), &width, &height, &channels, 4);
+        if (!imageData) return nullptr;
+
+        // Note: owned by the image like the compressed chain above
+        auto chain = new std::vector<unsigned char>;
+        levels     = mipmap::build_rgba8(imageData, uint32_t(width), uint32_t(height), options, *chain);
+        stbi_image_free(imageData);
+
+        image->data   = chain->data();
+        image->format = acre::Image::Format::RGBA8_UNORM;
+        size          = chain->size();
+    }
+    else
+    {
+        std::vector<float> linear(size_t(width) * height * 4);
+        if (wide)
+        {
+            auto imageData = stbi_load_16_from_memory(bytes.data(), int(bytes.size()), &width, &height, &channels, 4);
+            if (!imageData) return nullptr;
+
+            for (size_t i = 0; i < linear.size(); ++i)
+            {
+                auto value = float(imageData[i]) / 65535.0f;
+                linear[i]  = color && i % 4 != 3 ? std::pow(value, kImageGamma) : value;
+            }
+            stbi_image_free(imageData);
+        }
+        else
+        {
+            // Linear as it is for HDR, 8 bit color goes through kImageGamma
+            auto imageData = stbi_loadf_from_memory(bytes.data(), int(bytes.size()), &width, &height, &channels, 4);
+            if (!imageData) return nullptr;
+
+            memcpy(linear.data(), imageData, linear.size() * sizeof(float));
+            stbi_image_free(imageData);
+        }
+
+        std::vector<float> chain;
+        levels = mipmap::build_rgba32f(linear.data(), uint32_t(width), uint32_t(height), options, chain);
+
+        auto halves = new std::vector<uint16_t>(chain.size());
+        half::from_floats(chain.data(), halves->data(), chain.size());
+
+        image->data   = halves->data();
+        image->format = acre::Image::Format::RGBA16_FLOAT;
+        size          = halves->size() * sizeof(uint16_t);
+    }
 
     image->name    = fileName.c_str();
-    image->data    = (imageData);
     image->width   = width;
     image->height  = height;
-    image->format  = desired == 3 ? acre::Image::Format::RGB32_FLOAT : acre::Image::Format::RGBA32_FLOAT;
-    image->mipmaps = log2(width >= height ? width : height);
+    image->mipmaps = levels;
+
+    // What the same chain took expanded to RGBA32_FLOAT before
+    auto& stats = m_scene->load_stats();
+    stats.native_images++;
+    stats.native_image_bytes += size;
+    stats.native_image_bytes_f32 += mipmap::chain_pixels(uint32_t(width), uint32_t(height), levels) * 4 * sizeof(float);
 
+    m_scene->add_image(key, node->uuid(), size);
     return node;
 }
 
 void Loader::loadImage(const std::string& fileName)
 {
-    auto node    = m_scene->create<acre::TextureID>(std::hash<std::string>{}(fileName));
-    auto texture = node->ptr<acre::TextureID>();
+    auto imageR = createImage(fileName, true);
+    if (!imageR) return;
 
-    auto imageR    = createImage(fileName);
+    auto node      = m_scene->create<acre::TextureID>(fileUUID(fileName));
+    auto texture   = node->ptr<acre::TextureID>();
     texture->image = imageR->id<acre::ImageID>();
 }
 
 void Loader::loadHDR(const std::string& fileName)
 {
-    auto node    = m_scene->create<acre::TextureID>(std::hash<std::string>{}(fileName));
-    auto texture = node->ptr<acre::TextureID>();
+    // Read and hashed once, for the image and the environment precompute
+    auto bytes   = readBytes(fileName);
+    auto content = hash64(bytes.data(), bytes.size());
+
+    auto imageR = createImage(fileName, bytes, content, true);
+    if (!imageR) return;
 
-    auto imageR    = createImage(fileName);
+    auto node      = m_scene->create<acre::TextureID>(fileUUID(fileName));
+    auto texture   = node->ptr<acre::TextureID>();
     texture->image = imageR->id<acre::ImageID>();
 
     auto light    = new acre::HDRLight;
@@ -75,14 +243,62 @@ void Loader::loadHDR(const std::string& fileName)
     light->enable = true;
 
     m_scene->set_hdr_light(light);
+
+    if (m_prepare_environment) _prepare_environment(fileName, std::move(bytes), content);
+}
+
+void Loader::_prepare_environment(const std::string& fileName, std::vector<unsigned char> bytes, uint64_t content)
+{
+    if (bytes.empty()) return;
+
+    envmap::Options options;
+
+    auto key  = hash_combine(content, envmap::options_key(options));
+    auto path = EnvironmentCache::path_for(key, {});
+    m_scene->begin_environment(key);
+
+    auto start       = std::chrono::steady_clock::now();
+    auto environment = std::make_shared<acre::EnvironmentMap>();
+    if (EnvironmentCache::read(path, key, *environment))
+    {
+        environment->from_cache = true;
+        environment->build_ms   = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        m_scene->set_environment(key, std::move(environment));
+        return;
+    }
+
+    std::erase_if(m_environment_tasks, [](const auto& task) { return task.wait_for(std::chrono::seconds(0)) == std::future_status::ready; });
+
+    // The HDR light shows the equirect meanwhile
+    auto scene = m_scene;
+    m_environment_tasks.emplace_back(WorkerPool::global().submit([scene, bytes = std::move(bytes), key, path, options, environment, start, fileName]() {
+        int  width     = 0;
+        int  height    = 0;
+        int  channels  = 0;
+        auto imageData = stbi_loadf_from_memory(bytes.data(), int(bytes.size()), &width, &height, &channels, 4);
+        if (!imageData)
+        {
+            printf("Failed to prefilter %s\n", fileName.c_str());
+            return;
+        }
+
+        envmap::build(imageData, uint32_t(width), uint32_t(height), options, *environment);
+        stbi_image_free(imageData);
+
+        environment->build_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        if (!EnvironmentCache::write(path, key, *environment)) printf("Failed to write environment cache %s\n", path.c_str());
+
+        scene->post([scene, key, environment]() { scene->set_environment(key, environment); });
+    }));
 }
 
 void Loader::loadLutGGX(const std::string& fileName)
 {
-    auto node    = m_scene->create<acre::TextureID>(std::hash<std::string>{}(fileName));
-    auto texture = node->ptr<acre::TextureID>();
+    auto imageR = createImage(fileName, false);
+    if (!imageR) return;
 
-    auto imageR    = createImage(fileName);
+    auto node      = m_scene->create<acre::TextureID>(fileUUID(fileName));
+    auto texture   = node->ptr<acre::TextureID>();
     texture->image = imageR->id<acre::ImageID>();
 
     m_scene->set_lut_ggx(node->id<acre::TextureID>());
@@ -90,10 +306,11 @@ void Loader::loadLutGGX(const std::string& fileName)
 
 void Loader::loadLutCharlie(const std::string& fileName)
 {
-    auto node    = m_scene->create<acre::TextureID>(std::hash<std::string>{}(fileName));
-    auto texture = node->ptr<acre::TextureID>();
+    auto imageR = createImage(fileName, false);
+    if (!imageR) return;
 
-    auto imageR    = createImage(fileName);
+    auto node      = m_scene->create<acre::TextureID>(fileUUID(fileName));
+    auto texture   = node->ptr<acre::TextureID>();
     texture->image = {imageR->ptr<acre::ImageID>(), imageR->idx()};
 
     m_scene->set_lut_charlie(node->id<acre::TextureID>());
@@ -101,15 +318,39 @@ void Loader::loadLutCharlie(const std::string& fileName)
 
 void Loader::loadLutSheenAlbedoScale(const std::string& fileName)
 {
-    auto node    = m_scene->create<acre::TextureID>(std::hash<std::string>{}(fileName));
-    auto texture = node->ptr<acre::TextureID>();
+    auto image = createImage(fileName, false);
+    if (!image) return;
 
-    auto image     = createImage(fileName);
+    auto node      = m_scene->create<acre::TextureID>(fileUUID(fileName));
+    auto texture   = node->ptr<acre::TextureID>();
     texture->image = image->id<acre::ImageID>();
 
     m_scene->set_lut_sheen_albedo_scale(node->id<acre::TextureID>());
 }
 
+void Loader::generateLuts(const brdfLut::Options& options)
+{
+    for (auto kind : {brdfLut::Kind::lGGX, brdfLut::Kind::lCharlie, brdfLut::Kind::lSheenAlbedoScale})
+    {
+        auto path  = brdfLut::cache_path(kind, options);
+        auto start = std::chrono::steady_clock::now();
+
+        // Note: owned by the image like the standalone mip chains
+        auto rgba   = new std::vector<uint16_t>;
+        auto cached = brdfLut::read_cache(path, kind, options, *rgba);
+        if (!cached)
+        {
+            brdfLut::generate(kind, options, *rgba);
+            if (!brdfLut::write_cache(path, kind, options, *rgba)) printf("Failed to write LUT cache %s\n", path.c_str());
+        }
+
+        auto ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        printf("LUT %s %ux%u %s in %.1f ms\n", brdfLut::name(kind), options.size, options.size, cached ? "read" : "generated", ms);
+
+        m_scene->install_lut(kind, fileUUID(path), rgba, options.size);
+    }
+}
+
 void Loader::loadCamera(const std::string& fileName)
 {
     auto node   = m_scene->main_camera();
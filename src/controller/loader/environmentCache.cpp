@@ -0,0 +1,122 @@
+#include <controller/loader/environmentCache.h>
+#include <utils/mappedFile.h>
+
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+static constexpr char     g_magic[8] = {'A', 'C', 'R', 'E', 'E', 'N', 'V', 'M'};
+static constexpr uint32_t g_version  = 1;
+
+// On-disk layout: header, then specular halves, conditional and marginal CDFs back to back
+struct EnvironmentHeader
+{
+    char     magic[8];
+    uint32_t version;
+    uint32_t face_size;
+    uint64_t key;
+    uint64_t file_size;
+    uint32_t levels;
+    uint32_t cdf_width;
+    uint32_t cdf_height;
+    float    integral;
+    uint64_t specular_count;
+    float    sh[9][3];
+    uint32_t reserved;
+};
+
+static uint64_t fileSize(const EnvironmentHeader& head)
+{
+    auto cdf = uint64_t(head.cdf_height) * (head.cdf_width + 1) + head.cdf_height + 1;
+    return sizeof(EnvironmentHeader) + head.specular_count * sizeof(uint16_t) + cdf * sizeof(float);
+}
+
+bool EnvironmentCache::read(const std::string& fileName, uint64_t key, acre::EnvironmentMap& environment)
+{
+    MappedFile mapped;
+    if (!std::filesystem::exists(fileName) || !mapped.open(fileName)) return false;
+
+    EnvironmentHeader head;
+    if (mapped.size() < sizeof(head)) return false;
+    memcpy(&head, mapped.data(), sizeof(head));
+
+    bool valid = memcmp(head.magic, g_magic, sizeof(g_magic)) == 0 && head.version == g_version && head.key == key;
+    valid      = valid && head.file_size == mapped.size() && fileSize(head) == mapped.size();
+    if (!valid) return false;
+
+    environment.face_size = head.face_size;
+    environment.levels    = head.levels;
+    if (environment.specular_offset(head.levels, 0) != head.specular_count) return false;
+
+    const auto* data = mapped.data() + sizeof(head);
+    environment.specular.resize(head.specular_count);
+    memcpy(environment.specular.data(), data, head.specular_count * sizeof(uint16_t));
+    data += head.specular_count * sizeof(uint16_t);
+
+    environment.cdf_width  = head.cdf_width;
+    environment.cdf_height = head.cdf_height;
+    environment.conditional_cdf.resize(size_t(head.cdf_height) * (head.cdf_width + 1));
+    memcpy(environment.conditional_cdf.data(), data, environment.conditional_cdf.size() * sizeof(float));
+    data += environment.conditional_cdf.size() * sizeof(float);
+    environment.marginal_cdf.resize(head.cdf_height + 1);
+    memcpy(environment.marginal_cdf.data(), data, environment.marginal_cdf.size() * sizeof(float));
+
+    environment.integral = head.integral;
+    memcpy(environment.sh, head.sh, sizeof(head.sh));
+    return true;
+}
+
+bool EnvironmentCache::write(const std::string& fileName, uint64_t key, const acre::EnvironmentMap& environment)
+{
+    std::error_code error;
+    std::filesystem::create_directories(std::filesystem::path(fileName).parent_path(), error);
+
+    EnvironmentHeader head = {};
+    memcpy(head.magic, g_magic, sizeof(g_magic));
+    head.version        = g_version;
+    head.face_size      = environment.face_size;
+    head.key            = key;
+    head.levels         = environment.levels;
+    head.cdf_width      = environment.cdf_width;
+    head.cdf_height     = environment.cdf_height;
+    head.integral       = environment.integral;
+    head.specular_count = environment.specular.size();
+    head.file_size      = fileSize(head);
+    memcpy(head.sh, environment.sh, sizeof(head.sh));
+
+    auto temporary = fileName + ".tmp";
+    {
+        std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+        file.write(reinterpret_cast<const char*>(&head), sizeof(head));
+        file.write(reinterpret_cast<const char*>(environment.specular.data()), environment.specular.size() * sizeof(uint16_t));
+        file.write(reinterpret_cast<const char*>(environment.conditional_cdf.data()), environment.conditional_cdf.size() * sizeof(float));
+        file.write(reinterpret_cast<const char*>(environment.marginal_cdf.data()), environment.marginal_cdf.size() * sizeof(float));
+        if (!file.good())
+        {
+            file.close();
+            std::filesystem::remove(temporary, error);
+            return false;
+        }
+    }
+
+    std::filesystem::rename(temporary, fileName, error);
+    if (error)
+    {
+        std::filesystem::remove(temporary, error);
+        return false;
+    }
+
+    return true;
+}
+
+std::string EnvironmentCache::path_for(uint64_t key, const std::string& dir)
+{
+    std::error_code error;
+
+    auto root = dir.empty() ? std::filesystem::temp_directory_path(error) / "acreEditor" : std::filesystem::path(dir);
+
+    char name[32];
+    snprintf(name, sizeof(name), "%016llx.acreenv", (unsigned long long)key);
+    return (root / name).string();
+}
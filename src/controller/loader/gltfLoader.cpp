@@ -1,8 +1,26 @@
 #include <controller/loader/gltfLoader.h>
 #include <acre/render/renderer.h>
+#include <utils/workerPool.h>
+#include <utils/bounds.h>
+#include <utils/meshOptimizer.h>
+#include <utils/quantize.h>
+#include <utils/dequantize.h>
+#include <utils/hash.h>
+#include <utils/meshoptCodec.h>
+#include <model/wrapper/geometryExt.h>
 
 #define TINYGLTF_IMPLEMENTATION
 #include <tinygltf/tiny_gltf.h>
+#include <stb/stb_image.h>
+
+#ifdef USE_DRACO
+#    include <draco/compression/decode.h>
+#endif
+
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
 
 #define REUSE_GLTF_SHEEN_AS_DWAFABRIC 0
 #define REUSE_GLTF_MTL_AS_MSCLOTH     0
@@ -34,13 +52,6 @@ static auto vec4ToQuat(T& vec)
     return acre::math::quat(vec[3], vec[0], vec[1], vec[2]);
 }
 
-static auto bufToFloat4x4(unsigned char* buf)
-{
-    acre::math::float4x4 mat;
-    memcpy(mat.m_data, buf, sizeof(mat));
-    return mat;
-}
-
 static auto toStride(int componentType, int type, int stride = 0)
 {
     int componentCount = 0;
@@ -73,6 +84,75 @@ static auto toStride(int componentType, int type, int stride = 0)
     return std::max(componentCount * elementSize, stride);
 }
 
+static auto toBoundsComponent(int componentType)
+{
+    switch (componentType)
+    {
+        case TINYGLTF_COMPONENT_TYPE_BYTE: return bounds::ComponentType::cByte;
+        case TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE: return bounds::ComponentType::cUByte;
+        case TINYGLTF_COMPONENT_TYPE_SHORT: return bounds::ComponentType::cShort;
+        case TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT: return bounds::ComponentType::cUShort;
+        default: return bounds::ComponentType::cFloat;
+    }
+}
+
+static auto toDequantizeComponent(int componentType)
+{
+    switch (componentType)
+    {
+        case TINYGLTF_COMPONENT_TYPE_BYTE: return dequantize::Component::cByte;
+        case TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE: return dequantize::Component::cUByte;
+        case TINYGLTF_COMPONENT_TYPE_SHORT: return dequantize::Component::cShort;
+        default: return dequantize::Component::cUShort;
+    }
+}
+
+// Accessor type and component types of each attribute in core glTF and KHR_mesh_quantization
+static bool isValidAttribute(const std::string& name, const tinygltf::Accessor& accessor)
+{
+    auto type        = accessor.componentType;
+    auto is_float    = type == TINYGLTF_COMPONENT_TYPE_FLOAT;
+    auto is_signed   = type == TINYGLTF_COMPONENT_TYPE_BYTE || type == TINYGLTF_COMPONENT_TYPE_SHORT;
+    auto is_unsigned = type == TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE || type == TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT;
+    auto is_integer  = is_signed || is_unsigned;
+    auto is_snorm    = accessor.normalized && is_signed;
+    auto is_unorm    = accessor.normalized && is_unsigned;
+
+    if (name == "POSITION") return accessor.type == TINYGLTF_TYPE_VEC3 && (is_float || is_integer);
+    if (name == "NORMAL") return accessor.type == TINYGLTF_TYPE_VEC3 && (is_float || is_snorm);
+    if (name == "TANGENT") return accessor.type == TINYGLTF_TYPE_VEC4 && (is_float || is_snorm);
+    if (name == "TEXCOORD_0") return accessor.type == TINYGLTF_TYPE_VEC2 && (is_float || is_integer);
+    if (name == "JOINTS_0") return accessor.type == TINYGLTF_TYPE_VEC4 && !accessor.normalized && is_unsigned;
+    if (name == "WEIGHTS_0") return accessor.type == TINYGLTF_TYPE_VEC4 && (is_float || is_unorm);
+
+    return false;
+}
+
+// Integer stream to packed float in record storage
+static void expandAttribute(GeometryRecord& record, AttributeView& view, uint32_t components)
+{
+    if (view.type == TINYGLTF_COMPONENT_TYPE_FLOAT) return;
+
+    auto& buffer = record.storage.emplace_back(size_t(view.count) * components * sizeof(float));
+    dequantize::to_float((float*)buffer.data(), view.data, view.count, view.stride, components, toDequantizeComponent(view.type), view.normalized);
+
+    view.data       = buffer.data();
+    view.stride     = components * sizeof(float);
+    view.size       = components * sizeof(float);
+    view.type       = TINYGLTF_COMPONENT_TYPE_FLOAT;
+    view.normalized = false;
+}
+
+// Largest length scale of an affine, for distances measured in object space
+static auto maxScale(const acre::math::affine3& affine)
+{
+    auto origin = affine.transformPoint(acre::math::float3(0.0f, 0.0f, 0.0f));
+    auto x      = acre::math::length(affine.transformPoint(acre::math::float3(1.0f, 0.0f, 0.0f)) - origin);
+    auto y      = acre::math::length(affine.transformPoint(acre::math::float3(0.0f, 1.0f, 0.0f)) - origin);
+    auto z      = acre::math::length(affine.transformPoint(acre::math::float3(0.0f, 0.0f, 1.0f)) - origin);
+    return std::max(x, std::max(y, z));
+}
+
 static auto toImageFormat(int component, int bits)
 {
     if (component == 3)
@@ -111,7 +191,143 @@ static auto toImageFormat(int component, int bits)
 
 
 using namespace tinygltf;
-std::map<std::string, int> g_geometry;
+
+// KHR_texture_basisu textures reference their KTX2 image through the extension, source is the
+// fallback. Without USE_KTX2 acre has no block formats to sample the KTX2 image with, the fallback
+// goes first then
+static int textureSource(const tinygltf::Texture& texture)
+{
+    auto ext   = texture.extensions.find("KHR_texture_basisu");
+    auto basis = ext != texture.extensions.end() && ext->second.Has("source") ? ext->second.Get("source").GetNumberAsInt() : -1;
+
+#ifdef USE_KTX2
+    return basis >= 0 ? basis : texture.source;
+#else
+    return texture.source >= 0 ? texture.source : basis;
+#endif
+}
+
+// Usage of every image over the materials, an image used both ways takes the normal map (BC5) and
+// sRGB path, a cutoff of several MASK materials the lowest
+template <typename Usage>
+static auto findImageUsage(const tinygltf::Model& model)
+{
+    std::vector<Usage> usage(model.images.size());
+    auto               use = [&](int texture_idx) -> Usage* {
+        if (texture_idx < 0 || texture_idx >= model.textures.size()) return nullptr;
+
+        auto image_idx = textureSource(model.textures[texture_idx]);
+        return image_idx >= 0 && image_idx < usage.size() ? &usage[image_idx] : nullptr;
+    };
+    auto extensionTexture = [](const tinygltf::Material& mat, const char* extension, const char* texture) {
+        auto ext = mat.extensions.find(extension);
+        if (ext == mat.extensions.end() || !ext->second.Has(texture)) return -1;
+        return ext->second.Get(texture).Get("index").GetNumberAsInt();
+    };
+
+    for (const auto& mat : model.materials)
+    {
+        if (auto normal = use(mat.normalTexture.index)) normal->normal_map = true;
+
+        int colors[] = {mat.pbrMetallicRoughness.baseColorTexture.index, mat.emissiveTexture.index,
+                        extensionTexture(mat, "KHR_materials_specular", "specularColorTexture"),
+                        extensionTexture(mat, "KHR_materials_sheen", "sheenColorTexture")};
+        for (auto texture_idx : colors)
+        {
+            if (auto color = use(texture_idx)) color->srgb = true;
+        }
+
+        auto base = use(mat.pbrMetallicRoughness.baseColorTexture.index);
+        if (base && mat.alphaMode == "MASK")
+        {
+            auto cutoff        = float(mat.alphaCutoff);
+            base->alpha_cutoff = base->alpha_cutoff > 0.0f ? std::min(base->alpha_cutoff, cutoff) : cutoff;
+        }
+    }
+    return usage;
+}
+
+// Registry keys tell apart how the same bytes were decoded
+enum class ImageDecode : uint64_t
+{
+    dRGBA8 = 1,
+    dBC5,
+    dPixels,
+};
+
+// Decoded images carry the mip chain of their options, 0 without
+static uint64_t mipKey(const GLTFLoader::Config& config, const mipmap::Options& options)
+{
+    if (!config.build_mips) return 0;
+
+    auto key = hash_combine(uint64_t(options.filter) + 1, options.srgb);
+    return hash_combine(key, hash64(&options.alpha_cutoff, sizeof(float)));
+}
+
+// Shown until the decode of an image finished
+static unsigned char g_placeholder_pixel[4] = {255, 255, 255, 255};
+
+static void countMips(LoadStats& stats, uint32_t width, uint32_t height, uint32_t levels)
+{
+    if (levels < 2) return;
+
+    stats.mip_images++;
+    stats.mip_bytes += (mipmap::chain_pixels(width, height, levels) - size_t(width) * height) * 4;
+}
+
+// Compressed geometry counters of _decode_compressed
+static void addDecodeStats(LoadStats& stats, const LoadStats& decode)
+{
+    stats.meshopt_views += decode.meshopt_views;
+    stats.meshopt_bytes_in += decode.meshopt_bytes_in;
+    stats.meshopt_bytes_out += decode.meshopt_bytes_out;
+    stats.meshopt_ms += decode.meshopt_ms;
+    stats.draco_primitives += decode.draco_primitives;
+    stats.draco_bytes_in += decode.draco_bytes_in;
+    stats.draco_bytes_out += decode.draco_bytes_out;
+    stats.draco_ms += decode.draco_ms;
+}
+
+// TransformID uuids of EXT_mesh_gpu_instancing instances and draw batches, node transforms take
+// the node index
+static constexpr uint32_t g_instance_transform_bit = 0x80000000u;
+
+// Box filter by the smallest power of two that brings the larger side to max_size
+static std::pair<uint32_t, uint32_t> downsampleRGBA8(const unsigned char* pixels, int width, int height, uint32_t max_size, std::vector<unsigned char>& dst)
+{
+    int factor = 1;
+    while (std::max(width, height) / factor > int(max_size))
+        factor *= 2;
+
+    auto dst_width  = std::max(width / factor, 1);
+    auto dst_height = std::max(height / factor, 1);
+    dst.resize(size_t(dst_width) * dst_height * 4);
+
+    for (int y = 0; y < dst_height; ++y)
+    {
+        for (int x = 0; x < dst_width; ++x)
+        {
+            uint32_t sum[4] = {0, 0, 0, 0};
+            uint32_t count  = 0;
+            for (int sy = y * factor; sy < std::min((y + 1) * factor, height); ++sy)
+            {
+                for (int sx = x * factor; sx < std::min((x + 1) * factor, width); ++sx)
+                {
+                    auto src = pixels + (size_t(sy) * width + sx) * 4;
+                    for (int c = 0; c < 4; ++c)
+                        sum[c] += src[c];
+                    count++;
+                }
+            }
+
+            auto out = dst.data() + (size_t(y) * dst_width + x) * 4;
+            for (int c = 0; c < 4; ++c)
+                out[c] = (unsigned char)((sum[c] + count / 2) / count);
+        }
+    }
+
+    return {uint32_t(dst_width), uint32_t(dst_height)};
+}
 
 GLTFLoader::GLTFLoader(SceneMgr* scene) :
     Loader(scene)
@@ -122,11 +338,71 @@ GLTFLoader::GLTFLoader(SceneMgr* scene) :
 
 GLTFLoader::~GLTFLoader()
 {
+    _wait_images();
+
     delete m_model;
     delete m_loader;
 }
 
 void GLTFLoader::loadScene(const std::string& fileName)
+{
+    // Previous decodes (and cache writes) still point into the old model
+    _wait_images();
+    m_cache.close();
+    m_cache_records.clear();
+    m_geometry_keys.clear();
+
+    // The pixels of the previous load are released, later loads must not share them
+    if (m_asset != acre::kEditorAsset) m_scene->release_images(m_asset);
+    m_geometry_storage.clear();
+    m_decoded_buffers.clear();
+
+    // Every load is additive in its own uuid namespace, opening a scene clears the old one first.
+    // An atomic load takes its namespace when it commits, the scene may be replaced until then
+    m_file_name       = fileName;
+    m_load_start      = std::chrono::steady_clock::now();
+    m_load_generation = m_scene->generation();
+    m_progressive     = m_config.progressive;
+    m_atomic          = m_progressive && m_config.atomic_commit;
+    m_asset           = m_atomic ? acre::kEditorAsset : m_scene->create_asset(fileName);
+    m_phase           = Phase::pParse;
+    m_phase_done      = 0;
+    m_phase_total     = 0;
+
+    if (!m_progressive)
+    {
+        if (!_prepare_scene(fileName)) return;
+
+        _create_sampler();
+        _create_material();
+        _create_geometry();
+        _create_transform();
+        _create_skin();
+        _create_component_draw();
+        _create_animation();
+
+        _finish_load();
+        _on_ready();
+        _on_loaded();
+        return;
+    }
+
+    // Parsing and staging run on the worker pool, everything else is committed by _step_progressive.
+    // Atomic loads decode their images there as well
+    auto serial    = m_load_serial;
+    m_stage        = Stage::sPrepare;
+    m_prepare_task = WorkerPool::global().submit([this, fileName, serial]() {
+        if (!_prepare_scene(fileName)) return false;
+
+        if (!m_cancel_images) _prepare_geometry();
+        if (!m_cancel_images && m_atomic) _decode_images(serial);
+        return true;
+    });
+
+    _post_step(serial);
+}
+
+bool GLTFLoader::_prepare_scene(const std::string& fileName)
 {
     std::string warn;
     std::string err;
@@ -134,19 +410,30 @@ void GLTFLoader::loadScene(const std::string& fileName)
     size_t      dotIndex  = fileName.find_last_of('.');
     std::string extension = fileName.substr(dotIndex + 1);
 
+    if (m_config.async_images)
+        m_loader->SetImageLoader(&GLTFLoader::_defer_image_data, this);
+    else
+        m_loader->SetImageLoader(&tinygltf::LoadImageData, nullptr);
+
     bool ret = false;
     if (extension == "gltf")
     {
+        m_mapped.close();
         ret = m_loader->LoadASCIIFromFile(m_model, &err, &warn, fileName.c_str());
     }
+    else if (extension == "glb" && m_config.map_binary)
+    {
+        ret = _load_binary_mapped(fileName, err, warn);
+    }
     else if (extension == "glb")
     {
+        m_mapped.close();
         ret = m_loader->LoadBinaryFromFile(m_model, &err, &warn, fileName.c_str());
     }
     else
     {
         printf("Unsupported file format");
-        return;
+        return false;
     }
 
     if (!warn.empty())
@@ -164,464 +451,2373 @@ void GLTFLoader::loadScene(const std::string& fileName)
         printf("Failed to parse glTF\n");
     }
 
+    _resolve_buffers();
+
+    m_write_cache   = false;
+    m_cache_written = false;
+    m_cache_pending = 1;
+    if (ret && m_config.scene_cache) _open_cache(fileName);
+
+    if (ret) _decode_compressed();
+
+    return ret;
+}
+
+void GLTFLoader::_post(std::function<void()>&& task)
+{
+    // The generation is checked before the task touches the loader, loaders of added assets are
+    // destroyed with the scene they loaded into. The token keeps busy() up until the task ran or
+    // was dropped, a retired loader is not destroyed under a task still queued
+    m_scene->post([scene = m_scene, generation = m_load_generation, token = m_step_token, task = std::move(task)]() {
+        if (scene->generation() == generation) task();
+    });
+}
+
+void GLTFLoader::_post_step(uint32_t serial)
+{
+    // Until an atomic load commits it has nothing in the scene, clearing the scene does not drop
+    // its steps. The token keeps busy() up while a step is queued, _post adds it itself
+    if (m_atomic && m_stage == Stage::sPrepare)
+        m_scene->post([this, serial, token = m_step_token]() { _step_progressive(serial); });
+    else
+        _post([this, serial]() { _step_progressive(serial); });
+}
+
+void GLTFLoader::_step_progressive(uint32_t serial)
+{
+    auto detached = m_atomic && m_stage == Stage::sPrepare;
+    if (serial != m_load_serial || (!detached && m_load_generation != m_scene->generation()))
+    {
+        m_stage = Stage::sIdle;
+        return;
+    }
+
+    auto budget   = std::chrono::duration<float, std::milli>(m_config.progressive_budget_ms);
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::duration_cast<std::chrono::steady_clock::duration>(budget);
+
+    // One unit of work at least, so a tiny budget still makes progress
+    bool waiting = false;
+    do
+    {
+        switch (m_stage)
+        {
+            case Stage::sIdle: return;
+            case Stage::sPrepare:
+                if (m_prepare_task.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+                {
+                    waiting = true;
+                    break;
+                }
+                if (!m_prepare_task.get())
+                {
+                    m_stage = Stage::sIdle;
+                    _on_failed();
+                    return;
+                }
+                if (m_atomic)
+                {
+                    _commit_atomic();
+                    return;
+                }
+                m_stage = Stage::sMaterial;
+                break;
+            case Stage::sMaterial:
+                _create_sampler();
+                _create_material();
+                m_record_cursor = 0;
+                m_stage         = Stage::sGeometry;
+                break;
+            case Stage::sGeometry:
+                if (m_record_cursor < m_records.size())
+                {
+                    _commit_record(m_records[m_record_cursor++]);
+                    break;
+                }
+                m_stage = Stage::sScene;
+                break;
+            case Stage::sScene:
+                _create_transform();
+                _create_skin();
+                _create_component_draw();
+                m_scene->load_stats().ready_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - m_load_start).count();
+                _on_ready();
+                m_stage = Stage::sTexture;
+                break;
+            case Stage::sTexture:
+                if (!_commit_ready_image())
+                {
+                    if (m_full_cursor < m_decode_count)
+                    {
+                        waiting = true;
+                        break;
+                    }
+                    m_stage = Stage::sAnimation;
+                }
+                break;
+            case Stage::sAnimation:
+                _create_animation();
+                m_stage = Stage::sIdle;
+                _finish_load();
+                _on_loaded();
+                return;
+        }
+    } while (!waiting && std::chrono::steady_clock::now() < deadline);
+
+    _post_step(serial);
+}
+
+void GLTFLoader::_commit_atomic()
+{
+    // The commit callback (replacing the scene) and the whole asset go in within one step, no frame
+    // shows a part of it
+    _on_commit();
+    m_load_generation = m_scene->generation();
+    m_asset           = m_scene->create_asset(m_file_name);
+
     _create_sampler();
     _create_material();
-    _create_geometry();
+    for (auto& record : m_records)
+        _commit_record(record);
     _create_transform();
     _create_skin();
     _create_component_draw();
     _create_animation();
+
+    m_stage                        = Stage::sIdle;
+    m_scene->load_stats().ready_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - m_load_start).count();
+    _finish_load();
+    _on_ready();
+    _on_loaded();
 }
 
-void GLTFLoader::_create_sampler()
+void GLTFLoader::cancel()
 {
-    // {
-    //     auto sR = m_scene->create<acre::SamplerID>(0);
-    //     auto s  = sR->ptr<acre::SamplerID>();
-
-    //     s->mag_filter = false;
-    //     s->min_filter = false;
-    //     s->mip_filter = false;
-    //     s->address_u  = acre::Sampler::AddressMode::ClampToEdge;
-    //     s->address_v  = acre::Sampler::AddressMode::ClampToEdge;
-    //     s->address_w  = acre::Sampler::AddressMode::ClampToEdge;
-
-    //     m_scene->update(sR);
-    // }
+    if (m_stage == Stage::sIdle) return;
 
-    // {
-    //     auto sR = m_scene->create<acre::SamplerID>(1);
-    //     auto s  = sR->ptr<acre::SamplerID>();
+    // The prepare task and the decodes stop at their next check, queued steps see the serial
+    m_cancel_images = true;
+    m_load_serial++;
+    m_stage = Stage::sIdle;
+    printf("[gltf][loader] Canceled loading %s\n", m_file_name.c_str());
+}
 
-    //     s->mag_filter = false;
-    //     s->min_filter = false;
-    //     s->mip_filter = false;
-    //     s->address_u  = acre::Sampler::AddressMode::Repeat;
-    //     s->address_v  = acre::Sampler::AddressMode::Repeat;
-    //     s->address_w  = acre::Sampler::AddressMode::Repeat;
+bool GLTFLoader::busy() const
+{
+    auto running = [](const auto& task) { return task.valid() && task.wait_for(std::chrono::seconds(0)) != std::future_status::ready; };
 
-    //     m_scene->update(sR);
-    // }
+    if (m_step_token.use_count() > 1 || running(m_prepare_task)) return true;
+    return std::any_of(m_image_tasks.begin(), m_image_tasks.end(), running);
+}
 
+Loader::Progress GLTFLoader::progress() const
+{
+    switch (m_stage)
     {
-        auto sR = m_scene->create<acre::SamplerID>(0);
-        auto s  = sR->ptr<acre::SamplerID>();
-
-        s->mag_filter     = true;
-        s->min_filter     = true;
-        s->mip_filter     = true;
-        s->max_anisotropy = 8;
-        s->address_u      = acre::Sampler::AddressMode::Repeat;
-        s->address_v      = acre::Sampler::AddressMode::Repeat;
-        s->address_w      = acre::Sampler::AddressMode::Repeat;
-
-        m_scene->update(sR);
+        case Stage::sPrepare:
+            switch (m_phase.load())
+            {
+                case Phase::pParse: return {"parsing"};
+                case Phase::pGeometry: return {"staging geometry", m_phase_done, m_phase_total};
+                case Phase::pImages: return {"decoding images", m_phase_done, m_phase_total};
+            }
+            break;
+        case Stage::sMaterial: return {"materials"};
+        case Stage::sGeometry: return {"geometry", uint32_t(m_record_cursor), uint32_t(m_records.size())};
+        case Stage::sScene: return {"scene"};
+        case Stage::sTexture: return {"textures", uint32_t(m_full_cursor), m_decode_count};
+        case Stage::sAnimation: return {"animations"};
+        default: break;
     }
+    return {};
 }
 
-void GLTFLoader::_create_material()
+bool GLTFLoader::_commit_ready_image()
 {
-    uint32_t uuid = 0;
-    for (const auto& img : m_model->images)
+    // Every preview that is available goes out before the next full resolution image
+    if (m_preview_cursor < m_ready_images.size())
     {
-        auto node     = m_scene->create<acre::ImageID>(uuid++);
-        auto image    = node->ptr<acre::ImageID>();
-        image->data   = (void*)img.image.data();
-        image->width  = img.width;
-        image->height = img.height;
-        image->name   = img.name.c_str();
-        image->format = toImageFormat(img.component, img.bits);
+        const auto& ready = m_ready_images[m_preview_cursor++];
+        if (!ready.preview_width) return true;
+
+        auto node = m_scene->find<acre::ImageID>(_uuid(ready.index));
+        if (!node) return true;
+
+        auto image     = node->ptr<acre::ImageID>();
+        image->data    = m_preview_images[ready.index].data();
+        image->width   = ready.preview_width;
+        image->height  = ready.preview_height;
+        image->mipmaps = 1;
+        image->format  = acre::Image::Format::RGBA8_UNORM;
+        m_scene->update(node);
+        return true;
     }
 
-    uuid = 0;
-    for (auto& tex : m_model->textures)
+    if (m_full_cursor < m_preview_cursor)
     {
-        std::unordered_set<acre::Resource*> refs;
+        const auto& ready = m_ready_images[m_full_cursor++];
+        if (!ready.width) return true;
 
-        auto node        = m_scene->create<acre::TextureID>(uuid++);
-        auto texture     = node->ptr<acre::TextureID>();
-        texture->image   = _get_image_id(refs, tex.source);
-        texture->sampler = _get_sampler_id(refs, 0);
-        m_scene->update(node, std::move(refs));
+        _commit_image(ready.index, ready.width, ready.height);
+        return true;
     }
 
-    uuid = 0;
-    for (const auto& mat : m_model->materials)
-    {
-        std::unordered_set<acre::Resource*> refs;
+    return false;
+}
 
-        auto materialR = m_scene->create<acre::MaterialID>(uuid++);
-        auto material  = materialR->ptr<acre::MaterialID>();
+void GLTFLoader::_finish_load()
+{
+    // Draws are created, the records only served the batching
+    m_records.clear();
+    _release_cache_write(false);
 
-#if REUSE_GLTF_SHEEN_AS_DWAFABRIC
-        const auto& exts = mat.extensions;
-        if (exts.find("KHR_materials_sheen") != exts.end())
-        {
-            material->type  = acre::MaterialModel::mDwaFabric;
-            material->model = acre::DwaFabric();
-            _config_dwafabric_model(std::get<acre::DwaFabric>(material->model), material->alpha, material->alpha_idx, refs, mat);
-        }
-        else
-#endif
+    auto& stats = m_scene->load_stats();
+    addDecodeStats(stats, m_decode_stats);
+    m_decode_stats = LoadStats();
 
-#if REUSE_GLTF_MTL_AS_MSCLOTH
-        {
-            material->type  = acre::MaterialModel::mMSCloth;
-            material->model = acre::MSCloth();
-            _config_mscloth_model(std::get<acre::MSCloth>(material->model), material->alpha, material->alpha_idx, refs, mat);
-        }
-#else
-        {
-            material->type  = acre::MaterialModel::mStandard;
-            material->model = acre::StandardModel();
-            _config_standard_model(std::get<acre::StandardModel>(material->model), material->alpha, material->alpha_idx, refs, mat);
-        }
-#endif
+    stats.from_cache = m_cache.is_open();
+    stats.load_ms    = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - m_load_start).count();
+    printf("[gltf][loader] Loaded %s in %.1f ms%s\n", m_file_name.c_str(), stats.load_ms, stats.from_cache ? " (cache)" : "");
+}
 
-        if (mat.alphaMode == "OPAQUE" || mat.alphaMode == "MASK")
-            material->alpha = 1.0f;
+uint64_t GLTFLoader::_options_key() const
+{
+    const auto& config = m_config;
+
+    uint64_t key = 0;
+    key          = hash_combine(key, config.optimize_meshes);
+    key          = hash_combine(key, config.build_meshlets);
+    key          = hash_combine(key, config.meshlet_max_vertices);
+    key          = hash_combine(key, config.meshlet_max_triangles);
+    key          = hash_combine(key, config.build_lods);
+    key          = hash_combine(key, config.lod_min_triangles);
+    key          = hash_combine(key, config.lod_max_levels);
+    key          = hash_combine(key, hash64(&config.lod_ratio, sizeof(float)));
+    key          = hash_combine(key, hash64(&config.lod_max_error, sizeof(float)));
+    key          = hash_combine(key, config.quantize_attributes);
+    key          = hash_combine(key, config.expand_quantized);
+    key          = hash_combine(key, config.build_mips);
+    key          = hash_combine(key, uint64_t(config.mip_filter));
+    return key;
+}
 
-        m_scene->update(materialR, std::move(refs));
+uint64_t GLTFLoader::_source_stamp(const std::string& fileName) const
+{
+    // First bytes of the file, the glb header and the start of the JSON
+    static constexpr size_t kHeadBytes = 64 * 1024;
+
+    auto key = hash_combine(_options_key(), hash64(fileName.data(), fileName.size()));
+    if (m_mapped.is_open())
+    {
+        key = hash_combine(key, hash64(m_mapped.data(), std::min(m_mapped.size(), kHeadBytes)));
+    }
+    else
+    {
+        std::vector<char> head(kHeadBytes);
+        std::ifstream     file(fileName, std::ios::binary);
+        file.read(head.data(), std::streamsize(head.size()));
+        key = hash_combine(key, hash64(head.data(), size_t(file.gcount())));
+    }
+
+    // Size and mtime of the file and of every external buffer and image it references
+    auto directory = std::filesystem::path(fileName).parent_path();
+    auto add_file  = [&](const std::filesystem::path& path) {
+        std::error_code error;
+        auto            size = std::filesystem::file_size(path, error);
+        key                  = hash_combine(key, error ? 0 : uint64_t(size));
+        auto time            = std::filesystem::last_write_time(path, error);
+        key                  = hash_combine(key, error ? 0 : uint64_t(time.time_since_epoch().count()));
+    };
+    add_file(fileName);
+
+    auto external = [](const std::string& uri) { return !uri.empty() && uri.rfind("data:", 0) != 0; };
+    for (const auto& buffer : m_model->buffers)
+    {
+        if (external(buffer.uri)) add_file(directory / buffer.uri);
     }
+    for (const auto& image : m_model->images)
+    {
+        if (external(image.uri)) add_file(directory / image.uri);
+    }
+    return key;
 }
 
-void GLTFLoader::_create_geometry()
+uint64_t GLTFLoader::_content_key(const std::string& fileName) const
 {
-    g_geometry.clear();
+    auto key = _options_key();
 
-    int geo_idx = 0;
-    for (int meshIndex = 0; meshIndex < m_model->meshes.size(); ++meshIndex)
+    // A mapped glb covers its BIN chunk, other buffers are still in the model
+    if (m_mapped.is_open())
     {
-        const auto& mesh = m_model->meshes[meshIndex];
-        for (int prim_idx = 0; prim_idx < mesh.primitives.size(); ++prim_idx)
-        {
-            std::unordered_set<acre::Resource*> refs;
+        key = hash_combine(key, hash64(m_mapped.data(), m_mapped.size()));
+    }
+    else
+    {
+        MappedFile file;
+        if (file.open(fileName)) key = hash_combine(key, hash64(file.data(), file.size()));
+    }
 
-            const auto& primitive = mesh.primitives[prim_idx];
-            auto        geo_R     = m_scene->create<acre::GeometryID>(geo_idx);
-            auto        geometry  = geo_R->ptr<acre::GeometryID>();
+    for (const auto& buffer : m_model->buffers)
+        key = hash_combine(key, hash64(buffer.data.data(), buffer.data.size()));
 
-            if (primitive.indices > -1)
-            {
-                const auto& accessor   = m_model->accessors[primitive.indices];
-                const auto& bufferView = m_model->bufferViews[accessor.bufferView];
-                const auto& addr       = m_model->buffers[bufferView.buffer].data.data();
+    for (const auto& encoded : m_encoded_images)
+        key = hash_combine(key, hash64(encoded.data(), encoded.size()));
+    for (const auto& image : m_model->images)
+        key = hash_combine(key, hash64(image.image.data(), image.image.size()));
 
-                if (accessor.componentType != TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT &&
-                    accessor.componentType != TINYGLTF_COMPONENT_TYPE_UNSIGNED_INT)
-                {
-                    printf("[gltf][loader] Only support index with ushort or uint\n");
-                }
+    return key;
+}
 
-                auto node = m_scene->create<acre::VIndexID>(geo_idx);
-                refs.emplace(node);
-                auto index_buf    = node->ptr<acre::VIndexID>();
-                index_buf->count  = accessor.count;
-                index_buf->data   = addr + bufferView.byteOffset + accessor.byteOffset;
-                index_buf->stride = toStride(accessor.componentType, accessor.type, bufferView.byteStride);
-                geometry->index   = node->id<acre::VIndexID>();
-            }
-            if (primitive.attributes.find("POSITION") != primitive.attributes.end())
-            {
-                const auto& accessor   = m_model->accessors[primitive.attributes.find("POSITION")->second];
-                const auto& bufferView = m_model->bufferViews[accessor.bufferView];
-                const auto& addr       = m_model->buffers[bufferView.buffer].data.data();
+void GLTFLoader::_open_cache(const std::string& fileName)
+{
+    m_cache_path  = SceneCache::path_for(fileName, m_config.cache_dir);
+    m_cache_stamp = _source_stamp(fileName);
+
+    // Unchanged sources hit on the stamp alone, the content is hashed when they were touched or
+    // the cache has to be written
+    bool hashed   = false;
+    m_write_cache = !m_cache.open(m_cache_path, m_cache_stamp, [&]() {
+        hashed      = true;
+        m_cache_key = _content_key(fileName);
+        return m_cache_key;
+    });
+    if (m_write_cache && !hashed) m_cache_key = _content_key(fileName);
+}
 
-                if (accessor.type != TINYGLTF_TYPE_VEC3 &&
-                    accessor.componentType != TINYGLTF_COMPONENT_TYPE_FLOAT)
-                {
-                    printf("[gltf][loader] Only support position with float3\n");
-                }
+void GLTFLoader::_release_cache_write(bool on_worker)
+{
+    if (--m_cache_pending != 0 || !m_write_cache || m_cancel_images) return;
 
-                auto node = m_scene->create<acre::VPositionID>(geo_idx);
-                refs.emplace(node);
-                auto position      = node->ptr<acre::VPositionID>();
-                position->data     = addr + bufferView.byteOffset + accessor.byteOffset;
-                position->count    = accessor.count;
-                position->stride   = toStride(accessor.componentType, accessor.type, bufferView.byteStride);
-                geometry->position = node->id<acre::VPositionID>();
-
-                // Evaluate object objBox and scene objBox
-                acre::math::box3 box = acre::math::box3::empty();
-                for (auto i = 0; i < accessor.count; i += 3)
-                {
-                    acre::math::float3* pos = (acre::math::float3*)(position->data) + i;
-                    box |= *pos;
-                }
-                geometry->box = box;
-            }
-            if (primitive.attributes.find("TEXCOORD_0") != primitive.attributes.end())
-            {
-                const auto& accessor   = m_model->accessors[primitive.attributes.find("TEXCOORD_0")->second];
-                const auto& bufferView = m_model->bufferViews[accessor.bufferView];
-                const auto& addr       = m_model->buffers[bufferView.buffer].data.data();
+    if (on_worker)
+        _write_cache();
+    else
+        m_image_tasks.emplace_back(WorkerPool::global().submit([this]() { _write_cache(); }));
+}
 
-                if (accessor.type != TINYGLTF_TYPE_VEC2 &&
-                    accessor.componentType != TINYGLTF_COMPONENT_TYPE_FLOAT)
-                {
-                    printf("[gltf][loader] Only support uv with float2\n");
-                }
+void GLTFLoader::_write_cache()
+{
+    if (m_cancel_images) return;
 
-                auto node = m_scene->create<acre::VUVID>(geo_idx);
-                refs.emplace(node);
-                auto uv      = node->ptr<acre::VUVID>();
-                uv->data     = addr + bufferView.byteOffset + accessor.byteOffset;
-                uv->count    = accessor.count;
-                uv->stride   = toStride(accessor.componentType, accessor.type, bufferView.byteStride);
-                geometry->uv = node->id<acre::VUVID>();
-            }
-            if (primitive.attributes.find("NORMAL") != primitive.attributes.end())
-            {
-                const auto& accessor   = m_model->accessors[primitive.attributes.find("NORMAL")->second];
-                const auto& bufferView = m_model->bufferViews[accessor.bufferView];
-                const auto& addr       = m_model->buffers[bufferView.buffer].data.data();
+    std::vector<SceneCache::Image> images(m_model->images.size());
+    for (size_t image_idx = 0; image_idx < images.size(); ++image_idx)
+    {
+        const auto& img   = m_model->images[image_idx];
+        auto&       image = images[image_idx];
+        image.width       = img.width;
+        image.height      = img.height;
 
-                if (accessor.type != TINYGLTF_TYPE_VEC3 &&
-                    accessor.componentType != TINYGLTF_COMPONENT_TYPE_FLOAT)
+        if (image_idx < m_mip_chains.size() && !m_mip_chains[image_idx].empty())
+        {
+            image.pixels = m_mip_chains[image_idx].data();
+            image.levels = mipmap::level_count(img.width, img.height);
+        }
+        else if (image_idx < m_decoded_images.size() && m_decoded_images[image_idx])
+            image.pixels = m_decoded_images[image_idx];
+        else if (img.component == 4 && img.bits == 8 && img.image.size() == size_t(img.width) * img.height * 4)
+            image.pixels = img.image.data();
+    }
+
+    if (!SceneCache::write(m_cache_path, m_cache_stamp, m_cache_key, m_cache_records, images))
+        printf("[gltf][loader] Failed to write scene cache %s\n", m_cache_path.c_str());
+
+    // The chains committed meanwhile can go to the residency manager now
+    m_cache_written = true;
+    _post([this, serial = m_load_serial]() {
+        if (serial != m_load_serial) return;
+
+        for (uint32_t image_idx = 0; image_idx < m_reload_sources.size(); ++image_idx)
+            _track_image(image_idx);
+    });
+}
+
+bool GLTFLoader::_load_binary_mapped(const std::string& fileName, std::string& err, std::string& warn)
+{
+    if (!m_mapped.open(fileName))
+    {
+        err = "Failed to map file: " + fileName;
+        return false;
+    }
+
+    // Note: glb stores its total length in 32 bits, so larger files are invalid anyway
+    if (m_mapped.size() > UINT32_MAX)
+    {
+        err = "File too large for glb: " + fileName;
+        return false;
+    }
+
+    m_mapped.advise(0, m_mapped.size(), MappedFile::Advice::aSequential);
+
+    auto dirEnd  = fileName.find_last_of("/\\");
+    auto baseDir = dirEnd == std::string::npos ? std::string() : fileName.substr(0, dirEnd);
+
+    return m_loader->LoadBinaryFromMemory(m_model, &err, &warn, m_mapped.data(), uint32_t(m_mapped.size()), baseDir);
+}
+
+void GLTFLoader::_resolve_buffers()
+{
+    m_buffer_data.resize(m_model->buffers.size());
+    m_buffer_sizes.resize(m_model->buffers.size());
+    for (size_t i = 0; i < m_model->buffers.size(); ++i)
+    {
+        m_buffer_data[i]  = m_model->buffers[i].data.data();
+        m_buffer_sizes[i] = m_model->buffers[i].data.size();
+    }
+
+    // Only the first buffer of a glb may live in the BIN chunk (no uri)
+    if (!m_mapped.is_open() || m_model->buffers.empty() || !m_model->buffers[0].uri.empty()) return;
+
+    // glb layout: 12 bytes header, JSON chunk, BIN chunk, each chunk has 8 bytes (length, type) in front
+    constexpr uint32_t binChunkType = 0x004E4942;
+
+    const auto data = m_mapped.data();
+    const auto size = m_mapped.size();
+
+    uint32_t jsonLength = 0;
+    memcpy(&jsonLength, data + 12, sizeof(uint32_t));
+
+    size_t binHeader = 20 + size_t(jsonLength);
+    if (binHeader + 8 > size) return;
+
+    uint32_t binLength = 0;
+    uint32_t binType   = 0;
+    memcpy(&binLength, data + binHeader, sizeof(uint32_t));
+    memcpy(&binType, data + binHeader + 4, sizeof(uint32_t));
+    if (binType != binChunkType || binHeader + 8 + binLength > size) return;
+
+    m_buffer_data[0]  = data + binHeader + 8;
+    m_buffer_sizes[0] = binLength;
+    m_mapped.advise(binHeader + 8, binLength, MappedFile::Advice::aWillNeed);
+
+    // Embedded images were decoded while parsing, nothing references the parsed copy anymore
+    std::vector<unsigned char>().swap(m_model->buffers[0].data);
+}
+
+#ifdef USE_DRACO
+template <typename T>
+static bool copyDracoAttribute(const draco::PointAttribute* attribute, uint32_t point_count, int components, unsigned char* dst)
+{
+    T value[16];
+    for (uint32_t i = 0; i < point_count; ++i)
+    {
+        if (!attribute->ConvertValue<T>(attribute->mapped_index(draco::PointIndex(i)), int8_t(components), value)) return false;
+        memcpy(dst + size_t(i) * components * sizeof(T), value, components * sizeof(T));
+    }
+
+    return true;
+}
+
+static bool copyDracoAttribute(const draco::PointAttribute* attribute, uint32_t point_count, const tinygltf::Accessor& accessor, unsigned char* dst)
+{
+    auto components = toStride(TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE, accessor.type);
+    switch (accessor.componentType)
+    {
+        case TINYGLTF_COMPONENT_TYPE_FLOAT: return copyDracoAttribute<float>(attribute, point_count, components, dst);
+        case TINYGLTF_COMPONENT_TYPE_BYTE: return copyDracoAttribute<int8_t>(attribute, point_count, components, dst);
+        case TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE: return copyDracoAttribute<uint8_t>(attribute, point_count, components, dst);
+        case TINYGLTF_COMPONENT_TYPE_SHORT: return copyDracoAttribute<int16_t>(attribute, point_count, components, dst);
+        case TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT: return copyDracoAttribute<uint16_t>(attribute, point_count, components, dst);
+        case TINYGLTF_COMPONENT_TYPE_UNSIGNED_INT: return copyDracoAttribute<uint32_t>(attribute, point_count, components, dst);
+        default: return false;
+    }
+}
+#endif
+
+void GLTFLoader::_decode_compressed()
+{
+    m_decode_stats = LoadStats();
+
+    // One job per compressed buffer view or draco primitive, outputs are allocated up front so the
+    // jobs only touch their own buffers
+    struct DecodeJob
+    {
+        bool                 draco  = false;
+        const unsigned char* source = nullptr;
+        size_t               size   = 0;
+
+        // EXT_meshopt_compression
+        int         view   = -1;
+        size_t      count  = 0;
+        size_t      stride = 0;
+        std::string mode;
+        std::string filter;
+
+        // KHR_draco_mesh_compression, accessor -> m_decoded_buffers index, indices first (-1 when absent)
+        const tinygltf::Primitive*                   primitive = nullptr;
+        std::vector<std::pair<int, size_t>>          outputs;
+        std::vector<std::pair<uint32_t, std::string>> attributes; // draco unique id, glTF name
+
+        size_t output = 0;
+        bool   ok     = false;
+        double ms     = 0.0;
+    };
+
+    auto allocate = [&](size_t size) {
+        m_decoded_buffers.emplace_back(size);
+        return m_decoded_buffers.size() - 1;
+    };
+    auto number = [](const tinygltf::Value& value, const char* name, size_t fallback) {
+        return value.Has(name) ? size_t(value.Get(name).GetNumberAsDouble()) : fallback;
+    };
+    auto string = [](const tinygltf::Value& value, const char* name, const char* fallback) {
+        return value.Has(name) ? value.Get(name).Get<std::string>() : std::string(fallback);
+    };
+
+    std::vector<DecodeJob> jobs;
+    for (int view_idx = 0; view_idx < m_model->bufferViews.size(); ++view_idx)
+    {
+        const auto& view = m_model->bufferViews[view_idx];
+        auto        ext  = view.extensions.find("EXT_meshopt_compression");
+        if (ext == view.extensions.end()) continue;
+
+        const auto& value  = ext->second;
+        auto        buffer = int(number(value, "buffer", size_t(-1)));
+        if (buffer < 0 || buffer >= m_model->buffers.size() || !_buffer_data(buffer)) continue;
+
+        // A truncated or malformed file must not send the decoder past the buffer
+        auto offset = number(value, "byteOffset", 0);
+        auto length = number(value, "byteLength", 0);
+        if (!_buffer_range(buffer, offset, length))
+        {
+            printf("[gltf][loader] Skip bufferView[%d], its compressed range is outside buffer[%d]\n", view_idx, buffer);
+            continue;
+        }
+
+        auto& job  = jobs.emplace_back();
+        job.view   = view_idx;
+        job.source = _buffer_data(buffer) + offset;
+        job.size   = length;
+        job.count  = number(value, "count", 0);
+        job.stride = number(value, "byteStride", 0);
+        job.mode   = string(value, "mode", "ATTRIBUTES");
+        job.filter = string(value, "filter", "NONE");
+        job.output = allocate(job.count * job.stride);
+    }
+
+    // Draco only feeds the geometry, which a cache hit does not stage
+    uint32_t draco_skipped = 0;
+    for (auto& mesh : m_model->meshes)
+    {
+        for (auto& primitive : mesh.primitives)
+        {
+            auto ext = primitive.extensions.find("KHR_draco_mesh_compression");
+            if (ext == primitive.extensions.end() || m_cache.is_open()) continue;
+
+#ifdef USE_DRACO
+            const auto& value    = ext->second;
+            auto        view_idx = int(number(value, "bufferView", size_t(-1)));
+            if (view_idx < 0 || view_idx >= m_model->bufferViews.size() || !value.Has("attributes")) continue;
+
+            const auto& view = m_model->bufferViews[view_idx];
+            if (view.buffer < 0 || view.buffer >= m_model->buffers.size() || !_buffer_range(view.buffer, view.byteOffset, view.byteLength))
+            {
+                printf("[gltf][loader] Skip a draco primitive, bufferView[%d] is outside its buffer\n", view_idx);
+                continue;
+            }
+
+            auto& job     = jobs.emplace_back();
+            job.draco     = true;
+            job.primitive = &primitive;
+            job.source    = _buffer_data(view.buffer) + view.byteOffset;
+            job.size      = view.byteLength;
+
+            if (primitive.indices >= 0)
+            {
+                const auto& accessor = m_model->accessors[primitive.indices];
+                job.outputs.emplace_back(primitive.indices, allocate(accessor.count * toStride(accessor.componentType, accessor.type)));
+            }
+            else
+            {
+                job.outputs.emplace_back(-1, 0);
+            }
+
+            const auto& attributes = value.Get("attributes");
+            for (const auto& [name, accessor_idx] : primitive.attributes)
+            {
+                if (!attributes.Has(name)) continue;
+
+                const auto& accessor = m_model->accessors[accessor_idx];
+                job.attributes.emplace_back(uint32_t(attributes.Get(name).GetNumberAsInt()), name);
+                job.outputs.emplace_back(accessor_idx, allocate(accessor.count * toStride(accessor.componentType, accessor.type)));
+            }
+#else
+            draco_skipped++;
+#endif
+        }
+    }
+
+    if (draco_skipped) printf("[gltf][loader] %u primitives use KHR_draco_mesh_compression, build with USE_DRACO to decode them\n", draco_skipped);
+    if (jobs.empty()) return;
+
+    auto decode_meshopt = [&](DecodeJob& job) {
+        auto dst = m_decoded_buffers[job.output].data();
+        if (job.mode == "ATTRIBUTES")
+            job.ok = meshopt::decode_vertex_buffer(dst, job.count, job.stride, job.source, job.size);
+        else if (job.mode == "TRIANGLES")
+            job.ok = meshopt::decode_index_buffer(dst, job.count, job.stride, job.source, job.size);
+        else if (job.mode == "INDICES")
+            job.ok = meshopt::decode_index_sequence(dst, job.count, job.stride, job.source, job.size);
+
+        if (!job.ok) return;
+
+        if (job.filter == "OCTAHEDRAL")
+            meshopt::decode_filter_oct(dst, job.count, job.stride);
+        else if (job.filter == "QUATERNION")
+            meshopt::decode_filter_quat(dst, job.count, job.stride);
+        else if (job.filter == "EXPONENTIAL")
+            meshopt::decode_filter_exp(dst, job.count, job.stride);
+    };
+
+#ifdef USE_DRACO
+    auto decode_draco = [&](DecodeJob& job) {
+        draco::DecoderBuffer buffer;
+        buffer.Init(reinterpret_cast<const char*>(job.source), job.size);
+
+        draco::Decoder decoder;
+        auto           status = decoder.DecodeMeshFromBuffer(&buffer);
+        if (!status.ok()) return;
+
+        auto mesh = std::move(status).value();
+
+        auto [indices_accessor, indices_output] = job.outputs[0];
+        if (indices_accessor >= 0)
+        {
+            const auto& accessor = m_model->accessors[indices_accessor];
+            if (accessor.count != mesh->num_faces() * 3) return;
+
+            auto dst = m_decoded_buffers[indices_output].data();
+            for (draco::FaceIndex face_idx(0); face_idx < mesh->num_faces(); ++face_idx)
+            {
+                const auto& face = mesh->face(face_idx);
+                for (int corner = 0; corner < 3; ++corner)
                 {
-                    printf("[gltf][loader] Only support normal with float3\n");
+                    auto index = face[corner].value();
+                    auto i     = size_t(face_idx.value()) * 3 + corner;
+                    switch (accessor.componentType)
+                    {
+                        case TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE: dst[i] = uint8_t(index); break;
+                        case TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT: ((uint16_t*)dst)[i] = uint16_t(index); break;
+                        default: ((uint32_t*)dst)[i] = index; break;
+                    }
                 }
+            }
+        }
+
+        for (size_t i = 0; i < job.attributes.size(); ++i)
+        {
+            auto [accessor_idx, output] = job.outputs[i + 1];
+            const auto& accessor        = m_model->accessors[accessor_idx];
+
+            auto attribute = mesh->GetAttributeByUniqueId(job.attributes[i].first);
+            if (!attribute || accessor.count != mesh->num_points()) return;
+            if (!copyDracoAttribute(attribute, mesh->num_points(), accessor, m_decoded_buffers[output].data())) return;
+        }
+
+        job.ok = true;
+    };
+#endif
+
+    WorkerPool::global().parallel_for(jobs.size(), [&](size_t i) {
+        auto& job   = jobs[i];
+        auto  start = std::chrono::steady_clock::now();
+#ifdef USE_DRACO
+        if (job.draco)
+            decode_draco(job);
+        else
+#endif
+            decode_meshopt(job);
+        job.ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    });
+
+    // Decoded streams become extra buffers behind m_buffer_data, views and accessors are pointed at them.
+    // This runs on the prepare task, the stats are merged into the scene's by _finish_load
+    auto& stats = m_decode_stats;
+    for (auto& job : jobs)
+    {
+        if (!job.ok)
+        {
+            printf("[gltf][loader] Failed to decode %s\n", job.draco ? "a draco primitive" : ("bufferView[" + std::to_string(job.view) + "]").c_str());
+            continue;
+        }
+
+        if (!job.draco)
+        {
+            auto& view      = m_model->bufferViews[job.view];
+            view.buffer     = int(m_buffer_data.size());
+            view.byteOffset = 0;
+            view.byteLength = job.count * job.stride;
+            view.byteStride = job.mode == "ATTRIBUTES" ? job.stride : 0;
+            m_buffer_data.push_back(m_decoded_buffers[job.output].data());
+            m_buffer_sizes.push_back(m_decoded_buffers[job.output].size());
+
+            stats.meshopt_views++;
+            stats.meshopt_bytes_in += job.size;
+            stats.meshopt_bytes_out += view.byteLength;
+            stats.meshopt_ms += job.ms;
+            continue;
+        }
+
+        for (auto [accessor_idx, output] : job.outputs)
+        {
+            if (accessor_idx < 0) continue;
+
+            tinygltf::BufferView view;
+            view.buffer     = int(m_buffer_data.size());
+            view.byteLength = m_decoded_buffers[output].size();
+            m_buffer_data.push_back(m_decoded_buffers[output].data());
+            m_buffer_sizes.push_back(m_decoded_buffers[output].size());
+
+            auto& accessor      = m_model->accessors[accessor_idx];
+            accessor.bufferView = int(m_model->bufferViews.size());
+            accessor.byteOffset = 0;
+            m_model->bufferViews.push_back(view);
+
+            stats.draco_bytes_out += view.byteLength;
+        }
+
+        stats.draco_primitives++;
+        stats.draco_bytes_in += job.size;
+        stats.draco_ms += job.ms;
+    }
+}
+
+bool GLTFLoader::_defer_image_data(tinygltf::Image* image, const int image_idx, std::string* err, std::string* warn, int req_width, int req_height, const unsigned char* bytes, int size, void* user_data)
+{
+    auto loader = static_cast<GLTFLoader*>(user_data);
+
+    int width    = 0;
+    int height   = 0;
+    int channels = 0;
+
+    // KTX2 (KHR_texture_basisu) only has its header read here, it is transcoded with the other decodes
+    ktx2::Texture texture;
+    if (ktx2::read(bytes, size, texture))
+    {
+        width  = int(texture.width);
+        height = int(texture.height);
+    }
+    else if (!stbi_info_from_memory(bytes, size, &width, &height, &channels))
+    {
+        if (err) *err += "Unknown image format for image[" + std::to_string(image_idx) + "]\n";
+        return false;
+    }
+
+    // Note: always decoded to rgba8 later on
+    image->width     = width;
+    image->height    = height;
+    image->component = 4;
+    image->bits      = 8;
+
+    if (loader->m_encoded_images.size() <= image_idx) loader->m_encoded_images.resize(image_idx + 1);
+    loader->m_encoded_images[image_idx].assign(bytes, bytes + size);
+
+    if (loader->m_image_hashes.size() <= image_idx) loader->m_image_hashes.resize(image_idx + 1, 0);
+    loader->m_image_hashes[image_idx] = hash64(bytes, size);
+
+    return true;
+}
+
+uint64_t GLTFLoader::_image_key(uint32_t image_idx) const
+{
+    const auto& img = m_model->images[image_idx];
+
+    // Encoded bytes as deferred by _defer_image_data, KTX2 normal maps transcode differently
+    if (image_idx < m_image_hashes.size() && m_image_hashes[image_idx])
+    {
+        const auto& encoded = m_encoded_images[image_idx];
+        if (m_image_usage[image_idx].normal_map && ktx2::is_ktx2(encoded.data(), encoded.size()))
+            return hash_combine(m_image_hashes[image_idx], uint64_t(ImageDecode::dBC5));
+
+        return hash_combine(hash_combine(m_image_hashes[image_idx], uint64_t(ImageDecode::dRGBA8)), mipKey(m_config, _mip_options(image_idx)));
+    }
+
+    // Pixels decoded by tinygltf
+    if (img.image.empty()) return 0;
+
+    auto key = hash_combine(hash64(img.image.data(), img.image.size()), uint64_t(ImageDecode::dPixels));
+    key      = hash_combine(key, uint64_t(img.width) << 32 | uint32_t(img.height));
+    key      = hash_combine(key, uint64_t(img.component) << 8 | uint32_t(img.bits));
+    return hash_combine(key, mipKey(m_config, _mip_options(image_idx)));
+}
+
+mipmap::Options GLTFLoader::_mip_options(uint32_t image_idx) const
+{
+    mipmap::Options options;
+    options.filter = m_config.mip_filter;
+    if (image_idx < m_image_usage.size())
+    {
+        options.srgb         = m_image_usage[image_idx].srgb;
+        options.alpha_cutoff = m_image_usage[image_idx].alpha_cutoff;
+    }
+    return options;
+}
+
+void GLTFLoader::_reserve_images()
+{
+    m_decoded_images.resize(m_encoded_images.size(), nullptr);
+    m_reload_sources.resize(m_encoded_images.size());
+    m_compressed_images.resize(m_encoded_images.size());
+    m_preview_images.resize(m_encoded_images.size());
+}
+
+void GLTFLoader::_decode_images_async()
+{
+    _reserve_images();
+
+    auto serial = m_load_serial;
+    for (uint32_t image_idx = 0; image_idx < m_encoded_images.size(); ++image_idx)
+    {
+        if (m_encoded_images[image_idx].empty()) continue;
+
+        m_decode_count++;
+        m_cache_pending++;
+        m_image_tasks.emplace_back(WorkerPool::global().submit([this, image_idx, serial]() { _decode_image(image_idx, serial); }));
+    }
+}
+
+void GLTFLoader::_decode_images(uint32_t serial)
+{
+    // Usage and keys first, the key of a KTX2 normal map needs its encoded bytes
+    m_image_usage = findImageUsage<ImageUsage>(*m_model);
+    m_mip_chains.resize(m_model->images.size());
+    m_image_keys.resize(m_model->images.size());
+    for (uint32_t image_idx = 0; image_idx < m_image_keys.size(); ++image_idx)
+        m_image_keys[image_idx] = _image_key(image_idx);
+
+    _reserve_images();
+    m_decoded_sizes.assign(m_encoded_images.size(), {});
+
+    // Pixels the cache has are not decoded, as in _create_material
+    std::vector<SceneCache::Image> cached;
+    if (m_cache.is_open()) m_cache.read_images(cached);
+
+    std::vector<uint32_t> pending;
+    for (uint32_t image_idx = 0; image_idx < m_encoded_images.size(); ++image_idx)
+    {
+        if (m_encoded_images[image_idx].empty()) continue;
+
+        const auto& img = m_model->images[image_idx];
+        if (image_idx < cached.size() && cached[image_idx].pixels && cached[image_idx].width == img.width && cached[image_idx].height == img.height) continue;
+
+        pending.push_back(image_idx);
+    }
+
+    m_phase_done  = 0;
+    m_phase_total = uint32_t(pending.size());
+    m_phase       = Phase::pImages;
+    m_cache_pending += uint32_t(pending.size());
+
+    // Called from the prepare task, parallel_for runs its share on this worker as well
+    WorkerPool::global().parallel_for(pending.size(), [&](size_t i) {
+        _decode_image(pending[i], serial);
+        m_phase_done++;
+    });
+}
+
+void GLTFLoader::_decode_image(uint32_t image_idx, uint32_t serial)
+{
+    if (m_cancel_images) return;
+
+    const auto& encoded    = m_encoded_images[image_idx];
+    auto        normal_map = image_idx < m_image_usage.size() && m_image_usage[image_idx].normal_map;
+
+    int            width    = 0;
+    int            height   = 0;
+    int            channels = 0;
+    unsigned char* pixels   = nullptr;
+    bool           decoded  = false;
+
+    ktx2::Texture texture;
+    if (ktx2::read(encoded.data(), encoded.size(), texture))
+    {
+#ifdef USE_KTX2
+        decoded = ktx2::transcode(texture, normal_map, m_compressed_images[image_idx]);
+        width   = int(texture.width);
+        height  = int(texture.height);
+#else
+        printf("[gltf][loader] image[%u] is KTX2, build with USE_KTX2 to transcode it, textures with a fallback source use that\n", image_idx);
+#endif
+    }
+    else
+    {
+        pixels  = stbi_load_from_memory(encoded.data(), int(encoded.size()), &width, &height, &channels, 4);
+        decoded = pixels != nullptr;
+    }
+
+    if (!decoded)
+    {
+        printf("[gltf][loader] Failed to decode image[%u]\n", image_idx);
+        _release_cache_write(true);
+        if (m_progressive && !m_atomic) _post_ready_image({image_idx}, serial);
+        return;
+    }
+    // The chain replaces the stbi pixels, level 0 is a copy of them
+    if (pixels && m_config.build_mips)
+    {
+        mipmap::build_rgba8(pixels, uint32_t(width), uint32_t(height), _mip_options(image_idx), m_mip_chains[image_idx]);
+        stbi_image_free(pixels);
+        pixels = m_mip_chains[image_idx].data();
+    }
+    else
+    {
+        m_decoded_images[image_idx] = pixels;
+    }
+
+    if (m_config.track_residency && !m_mip_chains[image_idx].empty())
+        m_reload_sources[image_idx] = std::make_shared<const std::vector<unsigned char>>(std::move(m_encoded_images[image_idx]));
+    else
+        std::vector<unsigned char>().swap(m_encoded_images[image_idx]);
+    _release_cache_write(true);
+
+    // Atomic loads commit every image at once, _create_material picks the sizes up
+    if (m_atomic)
+    {
+        m_decoded_sizes[image_idx] = {image_idx, uint32_t(width), uint32_t(height)};
+        return;
+    }
+
+    // Progressive loads commit a preview first and the full image once _step_progressive gets to it,
+    // compressed mip chains go out as they are
+    if (m_progressive)
+    {
+        ReadyImage ready = {image_idx, uint32_t(width), uint32_t(height)};
+        if (pixels && std::max(width, height) > int(m_config.preview_size))
+        {
+            auto [preview_width, preview_height] = downsampleRGBA8(pixels, width, height, m_config.preview_size, m_preview_images[image_idx]);
+            ready.preview_width                  = preview_width;
+            ready.preview_height                 = preview_height;
+        }
+        _post_ready_image(ready, serial);
+        return;
+    }
+
+    _post([this, image_idx, width, height, serial]() {
+        if (serial != m_load_serial) return;
+
+        _commit_image(image_idx, width, height);
+    });
+}
+
+void GLTFLoader::_commit_image(uint32_t image_idx, uint32_t width, uint32_t height)
+{
+    auto node = m_scene->find<acre::ImageID>(_uuid(image_idx));
+    if (!node) return;
+
+    auto  image      = node->ptr<acre::ImageID>();
+    auto& compressed = m_compressed_images[image_idx];
+    if (!compressed.data.empty())
+    {
+        if (!_set_compressed_image(image, compressed)) return;
+
+        auto& stats = m_scene->load_stats();
+        stats.compressed_images++;
+        stats.compressed_bytes += compressed.data.size();
+        for (size_t level = 0; level < compressed.level_offsets.size(); ++level)
+            stats.compressed_rgba8_bytes += uint64_t(std::max(width >> level, 1u)) * std::max(height >> level, 1u) * 4;
+    }
+    else
+    {
+        const auto& chain = m_mip_chains[image_idx];
+        image->data       = chain.empty() ? m_decoded_images[image_idx] : (void*)chain.data();
+        image->width      = width;
+        image->height     = height;
+        image->mipmaps    = chain.empty() ? 1 : mipmap::level_count(width, height);
+        image->format     = acre::Image::Format::RGBA8_UNORM;
+        countMips(m_scene->load_stats(), width, height, image->mipmaps);
+    }
+    m_scene->update(node);
+
+    // Chains committed while the cache is written are handed over by _write_cache
+    if (!m_write_cache || m_cache_written) _track_image(image_idx);
+}
+
+void GLTFLoader::_track_image(uint32_t image_idx)
+{
+    if (image_idx >= m_reload_sources.size() || !m_reload_sources[image_idx]) return;
+
+    // Not committed yet (a preview or the placeholder), _commit_image comes back for it
+    auto  node  = m_scene->find<acre::ImageID>(_uuid(image_idx));
+    auto& chain = m_mip_chains[image_idx];
+    if (!node || chain.empty() || node->ptr<acre::ImageID>()->data != chain.data()) return;
+
+    // Decodes the image again the way _decode_images_async did
+    auto reload = [source = std::move(m_reload_sources[image_idx]), options = _mip_options(image_idx)](std::vector<unsigned char>& chain) {
+        int  width    = 0;
+        int  height   = 0;
+        int  channels = 0;
+        auto pixels   = stbi_load_from_memory(source->data(), int(source->size()), &width, &height, &channels, 4);
+        if (!pixels) return false;
+
+        mipmap::build_rgba8(pixels, uint32_t(width), uint32_t(height), options, chain);
+        stbi_image_free(pixels);
+        return true;
+    };
+    m_scene->track_image(node, chain, std::move(reload));
+}
+
+void GLTFLoader::_post_ready_image(const ReadyImage& ready, uint32_t serial)
+{
+    _post([this, ready, serial]() {
+        if (serial == m_load_serial) m_ready_images.push_back(ready);
+    });
+}
+
+void GLTFLoader::_release_decoded(uint32_t image_idx)
+{
+    if (image_idx < m_decoded_images.size() && m_decoded_images[image_idx])
+    {
+        stbi_image_free(m_decoded_images[image_idx]);
+        m_decoded_images[image_idx] = nullptr;
+    }
+    if (image_idx < m_mip_chains.size()) std::vector<unsigned char>().swap(m_mip_chains[image_idx]);
+    if (image_idx < m_reload_sources.size()) m_reload_sources[image_idx].reset();
+    if (image_idx < m_compressed_images.size()) m_compressed_images[image_idx] = {};
+}
+
+void GLTFLoader::_wait_images()
+{
+    if (m_prepare_task.valid()) m_prepare_task.wait();
+    m_prepare_task = {};
+    m_stage        = Stage::sIdle;
+    m_records.clear();
+
+    m_cancel_images = true;
+    for (auto& task : m_image_tasks)
+        task.wait();
+    m_image_tasks.clear();
+    m_cancel_images = false;
+
+    for (auto pixels : m_decoded_images)
+    {
+        if (pixels) stbi_image_free(pixels);
+    }
+    m_decoded_images.clear();
+    m_mip_chains.clear();
+    m_reload_sources.clear();
+    m_compressed_images.clear();
+    m_encoded_images.clear();
+    m_image_hashes.clear();
+    m_preview_images.clear();
+    m_ready_images.clear();
+    m_image_keys.clear();
+    m_decoded_sizes.clear();
+    m_preview_cursor = 0;
+    m_full_cursor    = 0;
+    m_decode_count   = 0;
+
+    // Drops commits of the previous load still queued in the scene
+    m_load_serial++;
+}
+
+void GLTFLoader::_create_sampler()
+{
+    // {
+    //     auto sR = m_scene->create<acre::SamplerID>(0);
+    //     auto s  = sR->ptr<acre::SamplerID>();
+
+    //     s->mag_filter = false;
+    //     s->min_filter = false;
+    //     s->mip_filter = false;
+    //     s->address_u  = acre::Sampler::AddressMode::ClampToEdge;
+    //     s->address_v  = acre::Sampler::AddressMode::ClampToEdge;
+    //     s->address_w  = acre::Sampler::AddressMode::ClampToEdge;
+
+    //     m_scene->update(sR);
+    // }
+
+    // {
+    //     auto sR = m_scene->create<acre::SamplerID>(1);
+    //     auto s  = sR->ptr<acre::SamplerID>();
+
+    //     s->mag_filter = false;
+    //     s->min_filter = false;
+    //     s->mip_filter = false;
+    //     s->address_u  = acre::Sampler::AddressMode::Repeat;
+    //     s->address_v  = acre::Sampler::AddressMode::Repeat;
+    //     s->address_w  = acre::Sampler::AddressMode::Repeat;
+
+    //     m_scene->update(sR);
+    // }
+
+    {
+        auto sR = m_scene->create<acre::SamplerID>(_uuid(0));
+        auto s  = sR->ptr<acre::SamplerID>();
+
+        s->mag_filter     = true;
+        s->min_filter     = true;
+        s->mip_filter     = true;
+        s->max_anisotropy = 8;
+        s->address_u      = acre::Sampler::AddressMode::Repeat;
+        s->address_v      = acre::Sampler::AddressMode::Repeat;
+        s->address_w      = acre::Sampler::AddressMode::Repeat;
+
+        m_scene->update(sR);
+    }
+}
+
+void GLTFLoader::_create_material()
+{
+    std::vector<SceneCache::Image> cached;
+    if (m_cache.is_open()) m_cache.read_images(cached);
+
+    m_image_usage = findImageUsage<ImageUsage>(*m_model);
+    m_mip_chains.resize(m_model->images.size());
+    m_image_uuids.assign(m_model->images.size(), 0);
+
+    uint32_t uuid = 0;
+    for (const auto& img : m_model->images)
+    {
+        auto image_idx           = uuid++;
+        m_image_uuids[image_idx] = _uuid(image_idx);
+
+        // Content already in the scene, from this file or an earlier load, is neither decoded nor
+        // uploaded again
+        auto key = image_idx < m_image_keys.size() ? m_image_keys[image_idx] : _image_key(image_idx);
+        if (key)
+        {
+            if (auto shared = m_scene->find_image(key))
+            {
+                m_image_uuids[image_idx] = shared->uuid();
+                if (image_idx < m_encoded_images.size()) std::vector<unsigned char>().swap(m_encoded_images[image_idx]);
+                _release_decoded(image_idx);
+                continue;
+            }
+            m_scene->add_image(key, _uuid(image_idx), uint64_t(img.width) * img.height * 4);
+        }
+
+        // Pixels from the cache need no decode, nor a mip chain built again
+        const unsigned char* pixels = nullptr;
+        uint32_t             levels = 1;
+        if (image_idx < cached.size() && cached[image_idx].width == img.width && cached[image_idx].height == img.height)
+        {
+            pixels = cached[image_idx].pixels;
+            levels = cached[image_idx].levels;
+        }
+        if (pixels && image_idx < m_encoded_images.size()) std::vector<unsigned char>().swap(m_encoded_images[image_idx]);
+
+        auto deferred = image_idx < m_encoded_images.size() && !m_encoded_images[image_idx].empty();
+        auto decoded  = image_idx < m_decoded_sizes.size() && m_decoded_sizes[image_idx].width;
+
+        auto node   = m_scene->create<acre::ImageID>(_uuid(image_idx));
+        auto image  = node->ptr<acre::ImageID>();
+        image->name = img.name.c_str();
+        if (pixels)
+        {
+            image->data    = (void*)pixels;
+            image->width   = img.width;
+            image->height  = img.height;
+            image->mipmaps = levels;
+            image->format  = acre::Image::Format::RGBA8_UNORM;
+            countMips(m_scene->load_stats(), img.width, img.height, levels);
+
+            // The mapping lives as long as the scene, evictions only move the image down the chain
+            if (m_config.track_residency) m_scene->track_mapped_image(node, pixels);
+        }
+        else if (deferred || decoded)
+        {
+            image->data   = g_placeholder_pixel;
+            image->width  = 1;
+            image->height = 1;
+            image->format = acre::Image::Format::RGBA8_UNORM;
+
+            // Decoded while an atomic load prepared
+            if (decoded) _commit_image(image_idx, m_decoded_sizes[image_idx].width, m_decoded_sizes[image_idx].height);
+        }
+        else if (m_config.build_mips && img.component == 4 && img.bits == 8 && img.image.size() == size_t(img.width) * img.height * 4)
+        {
+            // Decoded by tinygltf while parsing, the rows of each level still go wide
+            auto& chain    = m_mip_chains[image_idx];
+            image->mipmaps = mipmap::build_rgba8(img.image.data(), img.width, img.height, _mip_options(image_idx), chain);
+            image->data    = chain.data();
+            image->width   = img.width;
+            image->height  = img.height;
+            image->format  = acre::Image::Format::RGBA8_UNORM;
+            countMips(m_scene->load_stats(), img.width, img.height, image->mipmaps);
+        }
+        else
+        {
+            image->data   = (void*)img.image.data();
+            image->width  = img.width;
+            image->height = img.height;
+            image->format = toImageFormat(img.component, img.bits);
+        }
+    }
+
+    if (!m_atomic) _decode_images_async();
+
+    uuid = 0;
+    for (auto& tex : m_model->textures)
+    {
+        std::unordered_set<acre::Resource*> refs;
+
+        auto node        = m_scene->create<acre::TextureID>(_uuid(uuid++));
+        auto texture     = node->ptr<acre::TextureID>();
+        texture->image   = _get_image_id(refs, textureSource(tex));
+        texture->sampler = _get_sampler_id(refs, 0);
+        m_scene->update(node, std::move(refs));
+    }
+
+    uuid = 0;
+    for (const auto& mat : m_model->materials)
+    {
+        std::unordered_set<acre::Resource*> refs;
+
+        auto materialR = m_scene->create<acre::MaterialID>(_uuid(uuid++));
+        auto material  = materialR->ptr<acre::MaterialID>();
+
+#if REUSE_GLTF_SHEEN_AS_DWAFABRIC
+        const auto& exts = mat.extensions;
+        if (exts.find("KHR_materials_sheen") != exts.end())
+        {
+            material->type  = acre::MaterialModel::mDwaFabric;
+            material->model = acre::DwaFabric();
+            _config_dwafabric_model(std::get<acre::DwaFabric>(material->model), material->alpha, material->alpha_idx, refs, mat);
+        }
+        else
+#endif
+
+#if REUSE_GLTF_MTL_AS_MSCLOTH
+        {
+            material->type  = acre::MaterialModel::mMSCloth;
+            material->model = acre::MSCloth();
+            _config_mscloth_model(std::get<acre::MSCloth>(material->model), material->alpha, material->alpha_idx, refs, mat);
+        }
+#else
+        {
+            material->type  = acre::MaterialModel::mStandard;
+            material->model = acre::StandardModel();
+            _config_standard_model(std::get<acre::StandardModel>(material->model), material->alpha, material->alpha_idx, refs, mat);
+        }
+#endif
+
+        if (mat.alphaMode == "OPAQUE" || mat.alphaMode == "MASK")
+            material->alpha = 1.0f;
+
+        m_scene->update(materialR, std::move(refs));
+    }
+}
+
+void GLTFLoader::_create_geometry()
+{
+    _prepare_geometry();
+
+    for (auto& record : m_records)
+        _commit_record(record);
+}
+
+void GLTFLoader::_prepare_geometry()
+{
+    m_records.clear();
+    if (!m_cache.is_open() || !m_cache.read_geometry(m_records))
+    {
+        m_records.clear();
+        _stage_geometry(m_records);
+    }
+
+    // The cache writer needs the staged streams, which stay alive until the next load
+    if (m_write_cache)
+    {
+        for (auto& record : m_records)
+        {
+            auto storage = std::move(record.storage);
+            m_cache_records.push_back(record);
+            record.storage = std::move(storage);
+        }
+    }
+}
+
+void GLTFLoader::_commit_record(GeometryRecord& record)
+{
+    auto& stats = m_scene->load_stats();
+    stats.meshlet_count += uint32_t(record.meshlets.meshlets.size());
+    _commit_geometry(record);
+
+    auto key = std::to_string(record.mesh_idx) + "_" + std::to_string(record.prim_idx);
+    m_geometry_keys.emplace(key, record.geo_idx);
+
+    if (record.optimized)
+    {
+        stats.optimized_geometry++;
+        stats.optimized_triangle += record.triangles;
+        stats.acmr_before_sum += double(record.acmr_before) * record.triangles;
+        stats.acmr_after_sum += double(record.acmr_after) * record.triangles;
+    }
+    if (!record.lods.empty())
+    {
+        stats.lod_geometry++;
+        stats.lod_levels += uint32_t(record.lods.size());
+    }
+    stats.attribute_bytes_raw += record.attribute_bytes_raw;
+    stats.attribute_bytes += record.attribute_bytes;
+    if (record.bytes_raw > 0)
+    {
+        stats.geometry_bytes_raw += record.bytes_raw;
+        stats.geometry_bytes += record.bytes;
+    }
+
+    for (auto& buffer : record.storage)
+        m_geometry_storage.emplace_back(std::move(buffer));
+}
+
+void GLTFLoader::_stage_geometry(std::vector<GeometryRecord>& records)
+{
+    // Note: geo_idx is assigned up-front in mesh/primitive order, so uuids do not depend on scheduling
+    uint32_t geo_idx = 0;
+    for (int mesh_idx = 0; mesh_idx < m_model->meshes.size(); ++mesh_idx)
+    {
+        const auto& mesh = m_model->meshes[mesh_idx];
+        for (int prim_idx = 0; prim_idx < mesh.primitives.size(); ++prim_idx)
+        {
+            auto& record    = records.emplace_back();
+            record.mesh_idx = mesh_idx;
+            record.prim_idx = prim_idx;
+            record.geo_idx  = geo_idx++;
+        }
+    }
+
+    m_phase_done  = 0;
+    m_phase_total = uint32_t(records.size());
+    m_phase       = Phase::pGeometry;
+
+    // A canceled load skips the rest, its records are never committed
+    auto stage = [&](GeometryRecord& record) {
+        if (m_cancel_images) return;
+
+        _stage_primitive(record);
+        m_phase_done++;
+    };
+
+    if (m_config.parallel_geometry)
+    {
+        WorkerPool::global().parallel_for(records.size(), [&](size_t i) { stage(records[i]); });
+    }
+    else
+    {
+        for (auto& record : records)
+            stage(record);
+    }
+}
+
+void GLTFLoader::_stage_primitive(GeometryRecord& record)
+{
+    const auto& primitive = m_model->meshes[record.mesh_idx].primitives[record.prim_idx];
+
+    auto find_accessor = [&](const char* name) -> const tinygltf::Accessor* {
+        auto iter = primitive.attributes.find(name);
+        if (iter == primitive.attributes.end()) return nullptr;
+
+        return &m_model->accessors[iter->second];
+    };
+
+    auto stage_view = [&](const tinygltf::Accessor& accessor, AttributeView& view) {
+        if (accessor.sparse.isSparse)
+        {
+            if (!_stage_sparse(accessor, record, view)) record.warnings.emplace_back("[gltf][loader] Skip sparse accessor without indices or values");
+            return;
+        }
+
+        if (accessor.bufferView < 0)
+        {
+            record.warnings.emplace_back("[gltf][loader] Skip accessor without bufferView");
+            return;
+        }
+
+        const auto& bufferView = m_model->bufferViews[accessor.bufferView];
+        const auto& addr       = _buffer_data(bufferView.buffer);
+
+        view.data       = addr + bufferView.byteOffset + accessor.byteOffset;
+        view.count      = accessor.count;
+        view.stride     = toStride(accessor.componentType, accessor.type, bufferView.byteStride);
+        view.size       = toStride(accessor.componentType, accessor.type);
+        view.type       = accessor.componentType;
+        view.normalized = accessor.normalized;
+    };
+
+    if (primitive.indices > -1)
+    {
+        const auto& accessor = m_model->accessors[primitive.indices];
+        if (accessor.componentType != TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE &&
+            accessor.componentType != TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT &&
+            accessor.componentType != TINYGLTF_COMPONENT_TYPE_UNSIGNED_INT)
+        {
+            record.warnings.emplace_back("[gltf][loader] Only support index with ubyte, ushort or uint");
+        }
+
+        stage_view(accessor, record.index);
+    }
+
+    // Accessors outside of core glTF and KHR_mesh_quantization are dropped rather than handed on
+    // with a layout the renderer reads differently. Integer streams are expanded to float unless
+    // expand_quantized is off, then GeometryExt::quantization describes them. Joints (components
+    // 0) stay integer
+    auto stage_attribute = [&](const char* name, AttributeView& view, uint32_t components) {
+        auto accessor = find_accessor(name);
+        if (!accessor) return;
+
+        if (!isValidAttribute(name, *accessor))
+        {
+            record.warnings.emplace_back(std::string("[gltf][loader] Skip ") + name + " with unsupported type/componentType");
+            return;
+        }
+
+        stage_view(*accessor, view);
+        if (view.valid() && components && m_config.expand_quantized) expandAttribute(record, view, components);
+    };
+
+    stage_attribute("POSITION", record.position, 3);
+    stage_attribute("TEXCOORD_0", record.uv, 2);
+    stage_attribute("NORMAL", record.normal, 3);
+    stage_attribute("TANGENT", record.tangent, 4);
+    stage_attribute("JOINTS_0", record.joint, 0);
+    stage_attribute("WEIGHTS_0", record.weight, 4);
+
+    // Joints are read as ushort4 in either mode
+    if (record.joint.valid() && record.joint.type == TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE)
+    {
+        auto& buffer = record.storage.emplace_back(size_t(record.joint.count) * 8);
+        dequantize::widen_u8_u16((uint16_t*)buffer.data(), record.joint.data, record.joint.count, record.joint.stride, 4);
+
+        record.joint.data   = buffer.data();
+        record.joint.stride = 8;
+        record.joint.size   = 8;
+        record.joint.type   = TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT;
+    }
+
+    // Evaluate object box, scene box is merged from the placed object boxes at draw creation
+    if (record.position.valid())
+    {
+        bounds::PositionStream stream;
+        stream.data       = record.position.data;
+        stream.count      = record.position.count;
+        stream.stride     = record.position.stride;
+        stream.type       = toBoundsComponent(record.position.type);
+        stream.normalized = record.position.normalized;
+
+        record.box     = bounds::compute(stream);
+        record.has_box = true;
+    }
+
+    auto has_float_position = record.position.valid() && record.position.type == TINYGLTF_COMPONENT_TYPE_FLOAT;
+    _optimize_primitive(record, has_float_position);
+    _build_lods(record, has_float_position);
+    _build_meshlets(record, has_float_position);
+    _quantize_primitive(record);
+}
+
+bool GLTFLoader::_stage_sparse(const tinygltf::Accessor& accessor, GeometryRecord& record, AttributeView& view) const
+{
+    const auto& sparse = accessor.sparse;
+    if (sparse.indices.bufferView < 0 || sparse.values.bufferView < 0) return false;
+
+    // Dense copy of the base view (zeros without one), then the substituted elements
+    auto  element = toStride(accessor.componentType, accessor.type);
+    auto& buffer  = record.storage.emplace_back(size_t(accessor.count) * element);
+    if (accessor.bufferView >= 0)
+    {
+        const auto& base   = m_model->bufferViews[accessor.bufferView];
+        auto        stride = toStride(accessor.componentType, accessor.type, base.byteStride);
+        auto        src    = _buffer_data(base.buffer) + base.byteOffset + accessor.byteOffset;
+        for (size_t i = 0; i < accessor.count; ++i)
+            memcpy(buffer.data() + i * element, src + i * stride, element);
+    }
+
+    const auto& index_view = m_model->bufferViews[sparse.indices.bufferView];
+    const auto& value_view = m_model->bufferViews[sparse.values.bufferView];
+    auto        indices    = _buffer_data(index_view.buffer) + index_view.byteOffset + sparse.indices.byteOffset;
+    auto        values     = _buffer_data(value_view.buffer) + value_view.byteOffset + sparse.values.byteOffset;
+    for (int i = 0; i < sparse.count; ++i)
+    {
+        uint32_t index = 0;
+        switch (sparse.indices.componentType)
+        {
+            case TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE: index = indices[i]; break;
+            case TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT: index = ((const uint16_t*)indices)[i]; break;
+            case TINYGLTF_COMPONENT_TYPE_UNSIGNED_INT: index = ((const uint32_t*)indices)[i]; break;
+            default: return false;
+        }
+        if (index < accessor.count) memcpy(buffer.data() + size_t(index) * element, values + size_t(i) * element, element);
+    }
+
+    view.data       = buffer.data();
+    view.count      = accessor.count;
+    view.stride     = element;
+    view.size       = element;
+    view.type       = accessor.componentType;
+    view.normalized = accessor.normalized;
+    return true;
+}
+
+void GLTFLoader::_optimize_primitive(GeometryRecord& record, bool has_float_position)
+{
+    const auto& primitive = m_model->meshes[record.mesh_idx].primitives[record.prim_idx];
 
-                auto node = m_scene->create<acre::VNormalID>(geo_idx);
-                refs.emplace(node);
-                auto normal      = node->ptr<acre::VNormalID>();
-                normal->data     = addr + bufferView.byteOffset + accessor.byteOffset;
-                normal->count    = accessor.count;
-                normal->stride   = toStride(accessor.componentType, accessor.type, bufferView.byteStride);
-                geometry->normal = node->id<acre::VNormalID>();
-            }
-            if (primitive.attributes.find("TANGENT") != primitive.attributes.end())
-            {
-                const auto& accessor   = m_model->accessors[primitive.attributes.find("TANGENT")->second];
-                const auto& bufferView = m_model->bufferViews[accessor.bufferView];
-                const auto& addr       = m_model->buffers[bufferView.buffer].data.data();
+    auto& index = record.index;
+    if (!index.valid() || !record.position.valid()) return;
 
-                if (accessor.type != TINYGLTF_TYPE_VEC4 &&
-                    accessor.componentType != TINYGLTF_COMPONENT_TYPE_FLOAT)
-                {
-                    printf("[gltf][loader] Only support tangent with float4\n");
-                }
+    auto is_triangles = primitive.mode == TINYGLTF_MODE_TRIANGLES || primitive.mode == -1;
+    auto optimize     = m_config.optimize_meshes && is_triangles && index.count % 3 == 0;
 
-                auto node = m_scene->create<acre::VTangentID>(geo_idx);
-                refs.emplace(node);
-                auto tangent      = node->ptr<acre::VTangentID>();
-                tangent->data     = addr + bufferView.byteOffset + accessor.byteOffset;
-                tangent->count    = accessor.count;
-                tangent->stride   = toStride(accessor.componentType, accessor.type, bufferView.byteStride);
-                geometry->tangent = node->id<acre::VTangentID>();
-            }
-            if (primitive.attributes.find("JOINTS_0") != primitive.attributes.end())
-            {
-                const auto& accessor   = m_model->accessors[primitive.attributes.find("JOINTS_0")->second];
-                const auto& bufferView = m_model->bufferViews[accessor.bufferView];
-                const auto& addr       = m_model->buffers[bufferView.buffer].data.data();
+    // ubyte indices are always widened, the renderer takes 16/32 bit indices only
+    if (!optimize && index.stride != 1) return;
 
-                if (accessor.type != TINYGLTF_TYPE_VEC4 &&
-                    accessor.componentType != TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT)
-                {
-                    printf("[gltf][loader] Only support joints with ushort4\n");
-                }
+    auto vertex_count = record.position.count;
 
-                auto node = m_scene->create<acre::VJointID>(geo_idx);
-                refs.emplace(node);
-                auto joint      = node->ptr<acre::VJointID>();
-                joint->count    = accessor.count;
-                joint->data     = addr + bufferView.byteOffset + accessor.byteOffset;
-                joint->stride   = toStride(accessor.componentType, accessor.type, bufferView.byteStride);
-                geometry->joint = node->id<acre::VJointID>();
-            }
-            if (primitive.attributes.find("WEIGHTS_0") != primitive.attributes.end())
-            {
-                const auto& accessor   = m_model->accessors[primitive.attributes.find("WEIGHTS_0")->second];
-                const auto& bufferView = m_model->bufferViews[accessor.bufferView];
-                const auto& addr       = m_model->buffers[bufferView.buffer].data.data();
+    std::vector<uint32_t> indices(index.count);
+    for (uint32_t i = 0; i < index.count; ++i)
+    {
+        const auto* addr = index.data + i * index.stride;
+        switch (index.stride)
+        {
+            case 1: indices[i] = *addr; break;
+            case 2: indices[i] = *(const uint16_t*)addr; break;
+            default: indices[i] = *(const uint32_t*)addr; break;
+        }
 
-                if (accessor.type != TINYGLTF_TYPE_VEC4 &&
-                    accessor.componentType != TINYGLTF_COMPONENT_TYPE_FLOAT)
-                {
-                    printf("[gltf][loader] Only support weights with float4\n");
-                }
+        if (indices[i] >= vertex_count)
+        {
+            record.warnings.emplace_back("[gltf][loader] Skip mesh optimization, index out of range");
+            return;
+        }
+    }
 
-                auto node = m_scene->create<acre::VWeightID>(geo_idx);
-                refs.emplace(node);
-                auto weight      = node->ptr<acre::VWeightID>();
-                weight->data     = addr + bufferView.byteOffset + accessor.byteOffset;
-                weight->count    = accessor.count;
-                weight->stride   = toStride(accessor.componentType, accessor.type, bufferView.byteStride);
-                geometry->weight = node->id<acre::VWeightID>();
-            }
+    AttributeView* attributes[] = {&record.position, &record.uv, &record.normal, &record.tangent, &record.joint, &record.weight};
+
+    auto stream_bytes = [&]() {
+        // Note: element sizes, interleaved sources are not charged for their padding
+        uint64_t bytes = uint64_t(index.count) * index.stride;
+        for (auto attribute : attributes)
+        {
+            if (attribute->valid()) bytes += uint64_t(attribute->count) * attribute->size;
+        }
+        return bytes;
+    };
+    record.bytes_raw = stream_bytes();
+
+    if (optimize)
+    {
+        record.optimized   = true;
+        record.triangles   = index.count / 3;
+        record.acmr_before = meshopt::analyze_acmr(indices.data(), indices.size(), vertex_count);
+
+        meshopt::optimize_vertex_cache(indices.data(), std::vector<uint32_t>(indices).data(), indices.size(), vertex_count);
+        if (has_float_position)
+        {
+            auto positions = (const float*)record.position.data;
+            meshopt::optimize_overdraw(indices.data(), std::vector<uint32_t>(indices).data(), indices.size(), positions, vertex_count, record.position.stride);
+        }
+
+        record.acmr_after = meshopt::analyze_acmr(indices.data(), indices.size(), vertex_count);
+
+        bool remappable = true;
+        for (auto attribute : attributes)
+        {
+            if (attribute->valid() && attribute->count != vertex_count) remappable = false;
+        }
+
+        if (remappable)
+        {
+            std::vector<uint32_t> remap(vertex_count);
+            vertex_count = uint32_t(meshopt::optimize_vertex_fetch_remap(remap.data(), indices.data(), indices.size(), remap.size()));
+            meshopt::remap_index_buffer(indices.data(), indices.size(), remap.data());
+
+            for (auto attribute : attributes)
+            {
+                if (!attribute->valid()) continue;
 
-            auto key = std::to_string(meshIndex) + "_" + std::to_string(prim_idx);
-            g_geometry.emplace(key, geo_idx++);
-            m_scene->update(geo_R, std::move(refs));
+                auto& buffer = record.storage.emplace_back(size_t(vertex_count) * attribute->size);
+                meshopt::remap_vertex_buffer(buffer.data(), attribute->data, attribute->count, attribute->size, attribute->stride, remap.data());
+                attribute->data   = buffer.data();
+                attribute->count  = vertex_count;
+                attribute->stride = attribute->size;
+            }
         }
+        else
+        {
+            record.warnings.emplace_back("[gltf][loader] Skip vertex fetch remap, attribute counts differ");
+        }
+    }
+
+    // Narrow to 16 bits when every vertex is addressable, 0xffff is left out as it reads as restart
+    auto  width  = vertex_count < 0xffff ? sizeof(uint16_t) : sizeof(uint32_t);
+    auto& buffer = record.storage.emplace_back(indices.size() * width);
+    if (width == sizeof(uint16_t))
+    {
+        auto dst = (uint16_t*)buffer.data();
+        for (size_t i = 0; i < indices.size(); ++i)
+            dst[i] = uint16_t(indices[i]);
+    }
+    else
+    {
+        memcpy(buffer.data(), indices.data(), buffer.size());
     }
+
+    index.data   = buffer.data();
+    index.stride = uint32_t(width);
+    index.size   = uint32_t(width);
+
+    record.bytes = stream_bytes();
 }
 
-void GLTFLoader::_create_transform()
+// Widened (16/32 bit) index stream to uint32, false when an index is out of range
+static bool readIndices(const AttributeView& index, uint32_t vertex_count, std::vector<uint32_t>& indices)
 {
-    for (int nodeIndex = 0; nodeIndex < m_model->nodes.size(); ++nodeIndex)
+    indices.resize(index.count);
+    for (uint32_t i = 0; i < index.count; ++i)
     {
-        auto trsR = m_scene->create<acre::TransformID>(nodeIndex);
-        auto trs  = trsR->ptr<acre::TransformID>();
+        const auto* addr = index.data + i * index.stride;
+        indices[i]       = index.stride == 2 ? *(const uint16_t*)addr : *(const uint32_t*)addr;
+        if (indices[i] >= vertex_count) return false;
+    }
+
+    return true;
+}
+
+static auto isTriangles(const tinygltf::Primitive& primitive)
+{
+    return primitive.mode == TINYGLTF_MODE_TRIANGLES || primitive.mode == -1;
+}
+
+void GLTFLoader::_build_lods(GeometryRecord& record, bool has_float_position)
+{
+    const auto& primitive = m_model->meshes[record.mesh_idx].primitives[record.prim_idx];
+
+    const auto& index = record.index;
+    if (!m_config.build_lods || !index.valid() || !has_float_position || !record.has_box) return;
+    if (!isTriangles(primitive) || index.stride == 1 || index.count / 3 < m_config.lod_min_triangles) return;
+
+    std::vector<uint32_t> indices;
+    if (!readIndices(index, record.position.count, indices)) return;
+
+    const auto* positions    = (const float*)record.position.data;
+    auto        vertex_count = record.position.count;
+    auto        max_error    = acre::math::length(record.box.diagonal()) * m_config.lod_max_error;
+
+    // Each level simplifies the previous one, errors add up to a bound against the full detail
+    float                 error = 0.0f;
+    std::vector<uint32_t> lod(indices.size());
+    for (uint32_t level = 1; level <= m_config.lod_max_levels; ++level)
+    {
+        auto  target      = size_t(double(indices.size() / 3) * m_config.lod_ratio) * 3;
+        float level_error = 0.0f;
+        auto  count       = meshopt::simplify(lod.data(), indices.data(), indices.size(), positions, vertex_count, record.position.stride, target, max_error - error, &level_error);
+
+        // Stalled on locked borders or out of error budget
+        if (count == 0 || count * 20 > indices.size() * 19) break;
 
-        auto node   = m_model->nodes[nodeIndex];
-        auto affine = acre::math::affine3::identity();
-        if (!node.scale.empty())
+        error += level_error;
+        indices.resize(count);
+        meshopt::optimize_vertex_cache(indices.data(), lod.data(), count, vertex_count);
+
+        auto& buffer = record.storage.emplace_back(count * index.stride);
+        if (index.stride == 2)
+        {
+            auto dst = (uint16_t*)buffer.data();
+            for (size_t i = 0; i < count; ++i)
+                dst[i] = uint16_t(indices[i]);
+        }
+        else
+        {
+            memcpy(buffer.data(), indices.data(), buffer.size());
+        }
+
+        auto& view  = record.lods.emplace_back(index);
+        view.data   = buffer.data();
+        view.count  = uint32_t(count);
+        record.lod_errors.push_back(error);
+    }
+}
+
+void GLTFLoader::_build_meshlets(GeometryRecord& record, bool has_float_position)
+{
+    const auto& primitive = m_model->meshes[record.mesh_idx].primitives[record.prim_idx];
+
+    const auto& index = record.index;
+    if (!m_config.build_meshlets || !index.valid() || !has_float_position) return;
+
+    // Indices are already widened (and cache ordered when optimization is on)
+    if (!isTriangles(primitive) || index.stride == 1) return;
+
+    std::vector<uint32_t> indices;
+    if (!readIndices(index, record.position.count, indices)) return;
+
+    meshopt::build_meshlets(record.meshlets, indices.data(), indices.size(), m_config.meshlet_max_vertices, m_config.meshlet_max_triangles);
+    meshopt::compute_meshlet_bounds(record.meshlets, (const float*)record.position.data, record.position.stride);
+}
+
+void GLTFLoader::_quantize_primitive(GeometryRecord& record)
+{
+    if (!m_config.quantize_attributes) return;
+
+    auto& quantization = record.quantization;
+
+    // Quantize one float stream into record storage, views already quantized by the file are kept
+    auto encode = [&](AttributeView& view, uint32_t size, auto&& func) {
+        if (!view.valid() || view.type != TINYGLTF_COMPONENT_TYPE_FLOAT) return false;
+
+        auto& buffer = record.storage.emplace_back(size_t(view.count) * size);
+        func(buffer.data(), view);
+
+        record.attribute_bytes_raw += uint64_t(view.count) * view.size;
+        record.attribute_bytes += buffer.size();
+
+        view.data   = buffer.data();
+        view.stride = size;
+        view.size   = size;
+        return true;
+    };
+
+    if (record.has_box)
+    {
+        const auto& box       = record.box;
+        float       offset[3] = {box.m_mins.x, box.m_mins.y, box.m_mins.z};
+        float       scale[3]  = {box.m_maxs.x - box.m_mins.x, box.m_maxs.y - box.m_mins.y, box.m_maxs.z - box.m_mins.z};
+
+        quantization.position = encode(record.position, 8, [&](unsigned char* dst, const AttributeView& view) {
+            quantize::positions_unorm16((uint16_t*)dst, view.data, view.count, view.stride, offset, scale);
+        });
+        if (quantization.position)
         {
-            trs->scale = vec3ToFloat3(node.scale);
-            affine *= acre::math::scaling(trs->scale);
+            quantization.position_offset = acre::math::float3(offset[0], offset[1], offset[2]);
+            quantization.position_scale  = acre::math::float3(scale[0], scale[1], scale[2]);
         }
-        if (!node.rotation.empty())
+    }
+
+    quantization.normal = encode(record.normal, 4, [](unsigned char* dst, const AttributeView& view) {
+        quantize::normals_oct16((int16_t*)dst, view.data, view.count, view.stride);
+    });
+    quantization.tangent = encode(record.tangent, 8, [](unsigned char* dst, const AttributeView& view) {
+        quantize::tangents_oct16((int16_t*)dst, view.data, view.count, view.stride);
+    });
+    quantization.uv = encode(record.uv, 4, [](unsigned char* dst, const AttributeView& view) {
+        quantize::uvs_half((uint16_t*)dst, view.data, view.count, view.stride);
+    });
+    quantization.weight = encode(record.weight, 4, [](unsigned char* dst, const AttributeView& view) {
+        quantize::weights_unorm8(dst, view.data, view.count, view.stride);
+    });
+}
+
+template <typename ID>
+static auto commitAttribute(SceneMgr* scene, std::unordered_set<acre::Resource*>& refs, acre::UUID uuid, const AttributeView& view)
+{
+    if (!view.valid()) return ID();
+
+    auto node = scene->create<ID>(uuid);
+    refs.emplace(node);
+    auto buffer    = node->template ptr<ID>();
+    buffer->data   = (void*)view.data;
+    buffer->count  = view.count;
+    buffer->stride = view.stride;
+    return node->template id<ID>();
+}
+
+void GLTFLoader::_commit_geometry(GeometryRecord& record)
+{
+    for (const auto& warning : record.warnings)
+        printf("%s\n", warning.c_str());
+
+    std::unordered_set<acre::Resource*> refs;
+
+    auto uuid     = _uuid(record.geo_idx);
+    auto geo_R    = m_scene->create<acre::GeometryID>(uuid);
+    auto geometry = geo_R->ptr<acre::GeometryID>();
+
+    geometry->index    = commitAttribute<acre::VIndexID>(m_scene, refs, uuid, record.index);
+    geometry->position = commitAttribute<acre::VPositionID>(m_scene, refs, uuid, record.position);
+    geometry->uv       = commitAttribute<acre::VUVID>(m_scene, refs, uuid, record.uv);
+    geometry->normal   = commitAttribute<acre::VNormalID>(m_scene, refs, uuid, record.normal);
+    geometry->tangent  = commitAttribute<acre::VTangentID>(m_scene, refs, uuid, record.tangent);
+    geometry->joint    = commitAttribute<acre::VJointID>(m_scene, refs, uuid, record.joint);
+    geometry->weight   = commitAttribute<acre::VWeightID>(m_scene, refs, uuid, record.weight);
+
+    std::vector<acre::GeometryLod> lods;
+    if (!record.lods.empty())
+    {
+        lods.push_back({geometry->index, record.index.count, 0.0f});
+        for (uint32_t level = 1; level <= record.lods.size(); ++level)
         {
-            trs->rotation = vec4ToQuat(node.rotation);
-            affine *= trs->rotation.toAffine();
+            const auto& view = record.lods[level - 1];
+            auto        lod  = _uuid(record.geo_idx | (level << acre::kLodUUIDShift));
+            lods.push_back({commitAttribute<acre::VIndexID>(m_scene, refs, lod, view), view.count, record.lod_errors[level - 1]});
         }
-        if (!node.translation.empty())
+    }
+
+    if (record.has_box) geometry->box = record.box;
+
+    // Streams still in the integer encoding of the file, the loader's own encodings are flagged already
+    auto encoding = [](const AttributeView& view, bool quantized) {
+        acre::StreamEncoding out;
+        if (!view.valid() || quantized || view.type == TINYGLTF_COMPONENT_TYPE_FLOAT) return out;
+
+        out.type       = view.type;
+        out.normalized = view.normalized;
+        return out;
+    };
+    auto& quantization             = record.quantization;
+    quantization.position_encoding = encoding(record.position, quantization.position);
+    quantization.normal_encoding   = encoding(record.normal, quantization.normal);
+    quantization.tangent_encoding  = encoding(record.tangent, quantization.tangent);
+    quantization.uv_encoding       = encoding(record.uv, quantization.uv);
+    quantization.weight_encoding   = encoding(record.weight, quantization.weight);
+
+    geo_R->extension.reset();
+    if (!record.meshlets.meshlets.empty() || record.quantization.any() || !lods.empty())
+    {
+        auto ext          = std::make_unique<acre::GeometryExt>();
+        ext->meshlets     = std::move(record.meshlets);
+        ext->quantization = record.quantization;
+        ext->lods         = std::move(lods);
+        geo_R->extension  = std::move(ext);
+    }
+
+    m_scene->update(geo_R, std::move(refs));
+}
+
+void GLTFLoader::_create_transform()
+{
+    const auto& nodes = m_model->nodes;
+
+    std::vector<int> parents(nodes.size(), -1);
+    for (int node_idx = 0; node_idx < nodes.size(); ++node_idx)
+    {
+        for (auto child : nodes[node_idx].children)
         {
-            trs->translation = vec3ToFloat3(node.translation);
-            affine *= acre::math::translation(trs->translation);
+            if (child >= 0 && child < nodes.size()) parents[child] = node_idx;
         }
+    }
 
+    // Flatten the hierarchy parents first, world transforms are then a single pass
+    auto& hierarchy = m_scene->asset(m_asset)->hierarchy;
+    hierarchy.build(parents);
+    for (uint32_t slot = 0; slot < hierarchy.size(); ++slot)
+    {
+        const auto& node = nodes[hierarchy.nodes[slot]];
+        if (!node.scale.empty()) hierarchy.scales[slot] = vec3ToFloat3(node.scale);
+        if (!node.rotation.empty()) hierarchy.rotations[slot] = vec4ToQuat(node.rotation);
+        if (!node.translation.empty()) hierarchy.translations[slot] = vec3ToFloat3(node.translation);
         if (!node.matrix.empty())
         {
-            trs->matrix = vec16ToFloat4x4(node.matrix);
-            trs->affine = acre::math::homogeneousToAffine(trs->matrix);
+            hierarchy.fixed[slot]        = 1;
+            hierarchy.fixed_locals[slot] = acre::math::homogeneousToAffine(vec16ToFloat4x4(node.matrix));
         }
-        else
+    }
+    hierarchy.update();
+
+    // Slot order creates every parent before its children
+    for (uint32_t slot = 0; slot < hierarchy.size(); ++slot)
+    {
+        auto trsR = m_scene->create<acre::TransformID>(_uuid(hierarchy.nodes[slot]));
+        auto trs  = trsR->ptr<acre::TransformID>();
+
+        trs->scale       = hierarchy.scales[slot];
+        trs->rotation    = hierarchy.rotations[slot];
+        trs->translation = hierarchy.translations[slot];
+        trs->affine      = hierarchy.worlds[slot];
+        trs->matrix      = acre::math::affineToHomogeneous(trs->affine);
+
+        auto parent = hierarchy.parents[slot];
+        if (parent != acre::TransformHierarchy::kNoSlot)
         {
-            trs->affine = affine;
-            trs->matrix = acre::math::affineToHomogeneous(affine);
+            auto parent_trsR = _get_transform(hierarchy.nodes[parent]);
+            parent_trsR->children.emplace(trsR);
+            trsR->parent = parent_trsR;
         }
 
         m_scene->update(trsR);
     }
+}
 
-    for (int nodeIndex = 0; nodeIndex < m_model->nodes.size(); ++nodeIndex)
+void GLTFLoader::_create_skin()
+{
+    auto  asset   = m_scene->asset(m_asset);
+    auto& palette = asset->skins;
+
+    // Every glTF skin goes into the palette once, however many nodes use it
+    std::vector<uint32_t> palette_skins(m_model->skins.size(), acre::SkinPalette::kNone);
+    for (int node_idx = 0; node_idx < m_model->nodes.size(); ++node_idx)
+    {
+        const auto& node = m_model->nodes[node_idx];
+        if (node.mesh == -1 || node.skin < 0 || node.skin >= m_model->skins.size()) continue;
+
+        auto& palette_skin = palette_skins[node.skin];
+        if (palette_skin == acre::SkinPalette::kNone)
+        {
+            const auto& skin = m_model->skins[node.skin];
+
+            // Inverse bind matrices are read where they sit in the buffer, identity without an accessor
+            const unsigned char* inverse_binds = nullptr;
+            if (skin.inverseBindMatrices >= 0)
+            {
+                const auto& accessor = m_model->accessors[skin.inverseBindMatrices];
+                if (accessor.bufferView >= 0 && accessor.count >= skin.joints.size())
+                {
+                    const auto& view = m_model->bufferViews[accessor.bufferView];
+                    inverse_binds    = _buffer_data(view.buffer) + view.byteOffset + accessor.byteOffset;
+                }
+            }
+
+            palette_skin = palette.add_skin(skin.joints.data(), uint32_t(skin.joints.size()), inverse_binds);
+        }
+
+        palette.add_instance(node_idx, palette_skin);
+    }
+
+    palette.update(asset->hierarchy);
+
+    for (auto joint_node : palette.skinned_joints)
+    {
+        auto skinR = m_scene->create<acre::SkinID>(_uuid(joint_node));
+        palette.write_skin(joint_node, *skinR->ptr<acre::SkinID>());
+    }
+}
+
+// Nodes moved by an animation channel, directly or through an ancestor
+static auto findAnimatedNodes(const tinygltf::Model& model)
+{
+    std::vector<int> parents(model.nodes.size(), -1);
+    for (int node_idx = 0; node_idx < model.nodes.size(); ++node_idx)
     {
-        auto node        = m_model->nodes[nodeIndex];
-        auto trs         = _get_transform_id(nodeIndex).ptr;
-        auto parent_trsR = _get_transform(nodeIndex);
-        for (auto childIndex : node.children)
+        for (auto child : model.nodes[node_idx].children)
         {
-            auto child_trsR = _get_transform(childIndex);
-            if (!child_trsR) continue;
+            if (child >= 0 && child < parents.size()) parents[child] = node_idx;
+        }
+    }
 
-            auto child_trs          = child_trsR->ptr<acre::TransformID>();
-            auto child_affine_local = acre::math::affine3::identity();
-            child_affine_local *= acre::math::scaling(child_trs->scale);
-            child_affine_local *= child_trs->rotation.toAffine();
-            child_affine_local *= acre::math::translation(child_trs->translation);
+    std::vector<bool> targeted(model.nodes.size(), false);
+    for (const auto& animation : model.animations)
+    {
+        for (const auto& channel : animation.channels)
+        {
+            if (channel.target_node >= 0 && channel.target_node < targeted.size()) targeted[channel.target_node] = true;
+        }
+    }
 
-            child_trs->affine = child_affine_local * trs->affine;
-            child_trs->matrix = acre::math::affineToHomogeneous(child_trs->affine);
+    std::vector<bool> animated(model.nodes.size(), false);
+    for (int node_idx = 0; node_idx < model.nodes.size(); ++node_idx)
+    {
+        // The depth guard only matters for broken files with cycles
+        for (int ancestor = node_idx, depth = 0; ancestor != -1 && depth < model.nodes.size(); ancestor = parents[ancestor], ++depth)
+        {
+            if (!targeted[ancestor]) continue;
 
-            // link parent -> child
-            parent_trsR->children.emplace(child_trsR);
-            child_trsR->parent = parent_trsR;
+            animated[node_idx] = true;
+            break;
         }
     }
+
+    return animated;
+}
+
+bool GLTFLoader::_read_floats(int accessor_idx, int components, std::vector<float>& values) const
+{
+    if (accessor_idx < 0 || accessor_idx >= m_model->accessors.size()) return false;
+
+    const auto& accessor = m_model->accessors[accessor_idx];
+    if (accessor.bufferView < 0) return false;
+
+    const auto& view   = m_model->bufferViews[accessor.bufferView];
+    auto        stride = toStride(accessor.componentType, accessor.type, int(view.byteStride));
+    auto        data   = _buffer_data(view.buffer) + view.byteOffset + accessor.byteOffset;
+
+    values.resize(accessor.count * components);
+    switch (accessor.componentType)
+    {
+        case TINYGLTF_COMPONENT_TYPE_FLOAT:
+            for (size_t i = 0; i < accessor.count; ++i)
+                memcpy(values.data() + i * components, data + i * stride, components * sizeof(float));
+            return true;
+        case TINYGLTF_COMPONENT_TYPE_BYTE:
+        case TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE:
+        case TINYGLTF_COMPONENT_TYPE_SHORT:
+        case TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT:
+            dequantize::to_float(values.data(), data, accessor.count, stride, components, toDequantizeComponent(accessor.componentType), true);
+            return true;
+        default: return false;
+    }
 }
 
-void GLTFLoader::_create_skin()
+void GLTFLoader::_read_gpu_instances(const tinygltf::Node& node, std::vector<InstanceTRS>& instances) const
 {
-    for (int node_idx = 0; node_idx < m_model->nodes.size(); ++node_idx)
+    instances.clear();
+
+    auto ext = node.extensions.find("EXT_mesh_gpu_instancing");
+    if (ext == node.extensions.end() || !ext->second.Has("attributes")) return;
+
+    const auto& attributes = ext->second.Get("attributes");
+    auto        accessor   = [&](const char* name) { return attributes.Has(name) ? attributes.Get(name).GetNumberAsInt() : -1; };
+
+    std::vector<float> translations, rotations, scales;
+    auto               has_translation = _read_floats(accessor("TRANSLATION"), 3, translations);
+    auto               has_rotation    = _read_floats(accessor("ROTATION"), 4, rotations);
+    auto               has_scale       = _read_floats(accessor("SCALE"), 3, scales);
+
+    // All attributes have the same count per spec, the smallest one wins for broken files
+    size_t count = SIZE_MAX;
+    if (has_translation) count = std::min(count, translations.size() / 3);
+    if (has_rotation) count = std::min(count, rotations.size() / 4);
+    if (has_scale) count = std::min(count, scales.size() / 3);
+    if (count == SIZE_MAX) return;
+
+    instances.resize(count);
+    for (size_t i = 0; i < count; ++i)
+    {
+        auto& instance = instances[i];
+        if (has_translation) instance.translation = acre::math::float3(translations[i * 3], translations[i * 3 + 1], translations[i * 3 + 2]);
+        if (has_rotation) instance.rotation = acre::math::quat(rotations[i * 4 + 3], rotations[i * 4], rotations[i * 4 + 1], rotations[i * 4 + 2]);
+        if (has_scale) instance.scale = acre::math::float3(scales[i * 3], scales[i * 3 + 1], scales[i * 3 + 2]);
+    }
+}
+
+acre::Resource* GLTFLoader::_create_instance_transform(acre::Resource* parentR, const InstanceTRS& instance, uint32_t uuid)
+{
+    auto trsR = m_scene->create<acre::TransformID>(_uuid(g_instance_transform_bit | uuid));
+    auto trs  = trsR->ptr<acre::TransformID>();
+
+    trs->scale       = instance.scale;
+    trs->rotation    = instance.rotation;
+    trs->translation = instance.translation;
+
+    auto local = acre::math::scaling(instance.scale);
+    local *= instance.rotation.toAffine();
+    local *= acre::math::translation(instance.translation);
+
+    trs->affine = parentR ? local * parentR->ptr<acre::TransformID>()->affine : local;
+    trs->matrix = acre::math::affineToHomogeneous(trs->affine);
+
+    if (parentR)
     {
-        auto node = m_model->nodes[node_idx];
-        if (node.mesh == -1 || node.skin == -1) continue;
+        parentR->children.emplace(trsR);
+        trsR->parent = parentR;
+    }
+
+    m_scene->update(trsR);
+    return trsR;
+}
+
+acre::Resource* GLTFLoader::_get_draw_material(int material_idx)
+{
+    auto materialR = _get_material(material_idx);
+    if (materialR) return materialR;
+
+    materialR = _get_material(10086);
+    if (materialR) return materialR;
+
+    materialR        = m_scene->create<acre::MaterialID>(_uuid(10086));
+    auto material    = materialR->ptr<acre::MaterialID>();
+    material->type   = acre::MaterialModel::mStandard;
+    auto model       = acre::StandardModel();
+    model.base_color = acre::math::float3(1.0, 0.0, 0.0);
+    material->model  = model;
+    m_scene->update(materialR);
+    return materialR;
+}
 
-        auto node_transform      = _get_transform_id(node_idx).ptr;
-        auto inverse_node_matrix = acre::math::inverse(node_transform->matrix);
+void GLTFLoader::_create_draw(uint32_t entity_idx, acre::Resource* geo_R, acre::Resource* materialR, acre::Resource* trsR)
+{
+    std::unordered_set<acre::Resource*> refs;
+
+    auto entity    = m_scene->create<acre::EntityID>(_uuid(entity_idx));
+    auto entity_id = entity->id<acre::EntityID>();
+
+    m_scene->create(acre::component::createDraw(entity_id,
+                                                geo_R->id<acre::GeometryID>(),
+                                                materialR->id<acre::MaterialID>(),
+                                                trsR->id<acre::TransformID>()));
+
+    refs.emplace(geo_R);
+    refs.emplace(materialR);
+    refs.emplace(trsR);
+
+    m_scene->update(entity, std::move(refs));
+}
+
+bool GLTFLoader::_batchable(uint32_t geo_idx) const
+{
+    if (geo_idx >= m_records.size()) return false;
+
+    const auto& record    = m_records[geo_idx];
+    const auto& primitive = m_model->meshes[record.mesh_idx].primitives[record.prim_idx];
+    if (record.geo_idx != geo_idx || !isTriangles(primitive)) return false;
+
+    // Float streams only, quantized or skinned data is not baked
+    auto is_float = [](const AttributeView& view, uint32_t size) { return !view.valid() || (view.type == TINYGLTF_COMPONENT_TYPE_FLOAT && view.size == size); };
+    if (!record.position.valid() || record.joint.valid() || record.weight.valid() || record.quantization.any()) return false;
+    if (!is_float(record.position, 12) || !is_float(record.normal, 12) || !is_float(record.tangent, 16) || !is_float(record.uv, 8)) return false;
+
+    // Large meshes gain nothing from fewer draws, and have LODs that are picked per instance
+    return !record.lods.size() && record.position.count <= m_config.batch_max_vertices / m_config.batch_min_instances;
+}
+
+uint32_t GLTFLoader::_create_batch(uint32_t geo_idx, const acre::math::affine3* worlds, uint32_t count, uint32_t batch_geo_idx)
+{
+    const auto& record       = m_records[geo_idx];
+    auto        vertex_count = record.position.count;
 
-        auto skin     = m_model->skins[node.skin];
-        auto accessor = m_model->accessors[skin.inverseBindMatrices];
-        auto view     = m_model->bufferViews[accessor.bufferView];
-        auto buffer   = m_model->buffers[view.buffer].data;
+    std::vector<uint32_t> indices;
+    if (record.index.valid())
+    {
+        if (!readIndices(record.index, vertex_count, indices)) return 0;
+    }
+    else
+    {
+        indices.resize(vertex_count - vertex_count % 3);
+        for (uint32_t i = 0; i < indices.size(); ++i)
+            indices[i] = i;
+    }
 
-        for (int joint_idx = 0; joint_idx < skin.joints.size(); ++joint_idx)
+    auto total_vertices = vertex_count * count;
+    auto index_size     = total_vertices <= 0xffff ? sizeof(uint16_t) : sizeof(uint32_t);
+
+    auto stream = [&](bool valid, int type, uint32_t size, uint32_t elements) {
+        AttributeView out;
+        if (!valid) return out;
+
+        auto& buffer = m_geometry_storage.emplace_back(size_t(elements) * size);
+        out.data     = buffer.data();
+        out.count    = elements;
+        out.stride   = size;
+        out.size     = size;
+        out.type     = type;
+        return out;
+    };
+
+    auto index_type = index_size == sizeof(uint16_t) ? TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT : TINYGLTF_COMPONENT_TYPE_UNSIGNED_INT;
+
+    GeometryRecord batch;
+    batch.geo_idx  = batch_geo_idx;
+    batch.index    = stream(true, index_type, uint32_t(index_size), uint32_t(indices.size()) * count);
+    batch.position = stream(true, TINYGLTF_COMPONENT_TYPE_FLOAT, 12, total_vertices);
+    batch.normal   = stream(record.normal.valid(), TINYGLTF_COMPONENT_TYPE_FLOAT, 12, total_vertices);
+    batch.tangent  = stream(record.tangent.valid(), TINYGLTF_COMPONENT_TYPE_FLOAT, 16, total_vertices);
+    batch.uv       = stream(record.uv.valid(), TINYGLTF_COMPONENT_TYPE_FLOAT, 8, total_vertices);
+    batch.has_box  = true;
+
+    for (uint32_t instance = 0; instance < count; ++instance)
+    {
+        const auto& world = worlds[instance];
+
+        // Basis images of the linear part, their cross products transform normals (cofactor matrix)
+        auto origin = world.transformPoint(acre::math::float3(0.0f, 0.0f, 0.0f));
+        auto axisX  = world.transformPoint(acre::math::float3(1.0f, 0.0f, 0.0f)) - origin;
+        auto axisY  = world.transformPoint(acre::math::float3(0.0f, 1.0f, 0.0f)) - origin;
+        auto axisZ  = world.transformPoint(acre::math::float3(0.0f, 0.0f, 1.0f)) - origin;
+        auto cofX   = acre::math::cross(axisY, axisZ);
+        auto cofY   = acre::math::cross(axisZ, axisX);
+        auto cofZ   = acre::math::cross(axisX, axisY);
+        auto flip   = acre::math::dot(axisX, cofX) < 0.0f;
+        auto sign   = flip ? -1.0f : 1.0f;
+
+        auto base = instance * vertex_count;
+        for (uint32_t v = 0; v < vertex_count; ++v)
         {
-            auto addr                = buffer.data() + accessor.byteOffset + view.byteOffset + joint_idx * 64;
-            auto inverse_bind_matrix = bufToFloat4x4(addr);
+            auto position = (const float*)(record.position.data + size_t(v) * record.position.stride);
+            auto dst      = (float*)batch.position.data + size_t(base + v) * 3;
+            auto p        = world.transformPoint(acre::math::float3(position[0], position[1], position[2]));
+            dst[0]        = p.x;
+            dst[1]        = p.y;
+            dst[2]        = p.z;
+            batch.box |= p;
+
+            if (record.normal.valid())
+            {
+                auto normal = (const float*)(record.normal.data + size_t(v) * record.normal.stride);
+                auto n      = acre::math::normalize((cofX * normal[0] + cofY * normal[1] + cofZ * normal[2]) * sign);
+                auto out    = (float*)batch.normal.data + size_t(base + v) * 3;
+                out[0]      = n.x;
+                out[1]      = n.y;
+                out[2]      = n.z;
+            }
+
+            if (record.tangent.valid())
+            {
+                auto tangent = (const float*)(record.tangent.data + size_t(v) * record.tangent.stride);
+                auto t       = acre::math::normalize(axisX * tangent[0] + axisY * tangent[1] + axisZ * tangent[2]);
+                auto out     = (float*)batch.tangent.data + size_t(base + v) * 4;
+                out[0]       = t.x;
+                out[1]       = t.y;
+                out[2]       = t.z;
+                out[3]       = flip ? -tangent[3] : tangent[3];
+            }
 
-            auto joint_node_idx    = skin.joints[joint_idx];
-            auto joint_node_matrix = _get_transform(joint_node_idx)->ptr<acre::TransformID>()->matrix;
+            if (record.uv.valid())
+                memcpy((unsigned char*)batch.uv.data + size_t(base + v) * 8, record.uv.data + size_t(v) * record.uv.stride, 8);
+        }
 
-            auto skinR                                      = m_scene->create<acre::SkinID>(joint_node_idx);
-            skinR->ptr<acre::SkinID>()->inverse_bind_matrix = inverse_bind_matrix;
-            skinR->ptr<acre::SkinID>()->inverse_node_matrix = inverse_node_matrix;
-            skinR->ptr<acre::SkinID>()->joint_matrix        = inverse_bind_matrix * joint_node_matrix * inverse_node_matrix;
-            skinR->ptr<acre::SkinID>()->joint_affine        = acre::math::homogeneousToAffine(skinR->ptr<acre::SkinID>()->joint_matrix);
+        // Mirroring transforms flip the winding
+        auto dst = (unsigned char*)batch.index.data + size_t(instance) * indices.size() * index_size;
+        for (size_t i = 0; i < indices.size(); ++i)
+        {
+            auto corner = i % 3;
+            auto src    = flip && corner ? i + (corner == 1 ? 1 : -1) : i;
+            auto value  = base + indices[src];
+            if (index_size == sizeof(uint16_t))
+                ((uint16_t*)dst)[i] = uint16_t(value);
+            else
+                ((uint32_t*)dst)[i] = value;
         }
     }
+
+    _commit_geometry(batch);
+
+    auto geo_R = _get_geometry(batch_geo_idx);
+    if (!geo_R->extension) geo_R->extension = std::make_unique<acre::GeometryExt>();
+
+    auto ext          = geo_R->ext<acre::GeometryExt>();
+    ext->batch_source = geo_idx;
+    ext->batch_transforms.assign(worlds, worlds + count);
+
+    return total_vertices;
 }
 
 void GLTFLoader::_create_component_draw()
 {
     m_scene->reset_box();
 
-    auto     sceneBox     = acre::math::box3::empty();
-    uint32_t entity_index = 0;
+    auto animated = findAnimatedNodes(*m_model);
+
+    // Draws of one (geometry, material) pair with static transforms, merged once all nodes are seen
+    struct BatchDraw
+    {
+        int                 node     = -1;
+        int                 instance = -1; // EXT_mesh_gpu_instancing instance of the node
+        acre::math::affine3 world;
+    };
+    std::map<std::pair<uint32_t, int>, std::vector<BatchDraw>> batches;
+
+    std::vector<acre::math::box3> worldBoxes;
+    std::vector<InstanceTRS>      instances;
+    uint32_t                      entity_index   = 0;
+    uint32_t                      instance_index = 0;
+
+    // Instance transforms are shared by all primitives of the mesh and created on first use
+    std::map<std::pair<int, int>, acre::Resource*> instanceTransforms;
+    auto instance_transform = [&](int node_idx, int instance, const InstanceTRS& trs_instance) {
+        auto& trsR = instanceTransforms[{node_idx, instance}];
+        if (!trsR) trsR = _create_instance_transform(_get_transform(node_idx), trs_instance, instance_index++);
+        return trsR;
+    };
+
+    // Every drawn instance, LOD selection and texture residency both size them on screen
+    auto add_instance = [](acre::Resource* geo_R, const acre::math::box3& worldBox, float scale) {
+        if (!geo_R->extension) geo_R->extension = std::make_unique<acre::GeometryExt>();
+        geo_R->ext<acre::GeometryExt>()->instances.push_back({worldBox, scale});
+    };
+
+    auto draw = [&](acre::Resource* trsR, uint32_t geo_idx, int material_idx) {
+        auto geo_R = _get_geometry(geo_idx);
+        auto trs   = trsR->ptr<acre::TransformID>();
+        _create_draw(entity_index++, geo_R, _get_draw_material(material_idx), trsR);
+
+        // The geometry may be shared by several nodes, keep its box in object space
+        const auto& worldBox = worldBoxes.emplace_back(bounds::transform(geo_R->ptr<acre::GeometryID>()->box, trs->affine));
+        add_instance(geo_R, worldBox, maxScale(trs->affine));
+    };
+
     for (int nodeIndex = 0; nodeIndex < m_model->nodes.size(); ++nodeIndex)
     {
         const auto& node = m_model->nodes[nodeIndex];
         if (node.mesh == -1) continue;
 
-        const auto& trsR = _get_transform(nodeIndex);
+        auto        trsR = _get_transform(nodeIndex);
         const auto& trs  = trsR->ptr<acre::TransformID>();
         const auto& mesh = m_model->meshes[node.mesh];
+
+        _read_gpu_instances(node, instances);
+
+        auto is_static = m_config.batch_instances && !animated[nodeIndex] && node.skin == -1;
         for (int prim_idx = 0; prim_idx < mesh.primitives.size(); ++prim_idx)
         {
-            std::unordered_set<acre::Resource*> refs;
-
-            auto key = std::to_string(node.mesh) + "_" + std::to_string(prim_idx);
+            auto key          = std::to_string(node.mesh) + "_" + std::to_string(prim_idx);
+            auto geo_idx      = m_geometry_keys[key];
+            auto material_idx = mesh.primitives[prim_idx].material;
 
-            // auto entity   = m_scene->create<acre::EntityID>(std::hash<std::string>{}(key));
-            auto entity    = m_scene->create<acre::EntityID>(entity_index++);
-            auto entity_id = entity->id<acre::EntityID>();
+            if (is_static && _batchable(geo_idx))
+            {
+                auto& batch = batches[{geo_idx, material_idx}];
+                if (instances.empty()) batch.push_back({nodeIndex, -1, trs->affine});
 
-            auto geo_idx = g_geometry[key];
-            auto geo_R   = _get_geometry(geo_idx);
+                for (int instance = 0; instance < instances.size(); ++instance)
+                {
+                    const auto& trs_instance = instances[instance];
 
-            const auto& primitive = mesh.primitives[prim_idx];
-            auto        materialR = _get_material(primitive.material);
-            if (!materialR)
-            {
-                materialR        = m_scene->create<acre::MaterialID>(10086);
-                auto material    = materialR->ptr<acre::MaterialID>();
-                material->type   = acre::MaterialModel::mStandard;
-                auto model       = acre::StandardModel();
-                model.base_color = acre::math::float3(1.0, 0.0, 0.0);
-                material->model  = model;
-                m_scene->update(materialR);
+                    auto local = acre::math::scaling(trs_instance.scale);
+                    local *= trs_instance.rotation.toAffine();
+                    local *= acre::math::translation(trs_instance.translation);
+                    batch.push_back({nodeIndex, instance, local * trs->affine});
+                }
+                continue;
             }
 
-            m_scene->create(acre::component::createDraw(entity_id,
-                                                        geo_R->id<acre::GeometryID>(),
-                                                        materialR->id<acre::MaterialID>(),
-                                                        trsR->id<acre::TransformID>()));
+            if (instances.empty()) draw(trsR, geo_idx, material_idx);
+
+            for (int instance = 0; instance < instances.size(); ++instance)
+                draw(instance_transform(nodeIndex, instance, instances[instance]), geo_idx, material_idx);
+        }
+    }
+
+    auto draw_single = [&](const BatchDraw& batch_draw, uint32_t geo_idx, int material_idx) {
+        if (batch_draw.instance < 0)
+        {
+            draw(_get_transform(batch_draw.node), geo_idx, material_idx);
+            return;
+        }
+
+        _read_gpu_instances(m_model->nodes[batch_draw.node], instances);
+        draw(instance_transform(batch_draw.node, batch_draw.instance, instances[batch_draw.instance]), geo_idx, material_idx);
+    };
+
+    auto&    stats         = m_scene->load_stats();
+    auto     batch_geo_idx = uint32_t(m_records.size());
+    uint64_t baked         = 0;
+    for (auto& [key, draws] : batches)
+    {
+        auto [geo_idx, material_idx] = key;
+
+        // Too few repeats, one entity per draw as usual
+        if (draws.size() < m_config.batch_min_instances)
+        {
+            for (const auto& batch_draw : draws)
+                draw_single(batch_draw, geo_idx, material_idx);
+            continue;
+        }
 
-            auto& objBox = geo_R->ptr<acre::GeometryID>()->box;
-            objBox       = objBox * trs->affine;
-            sceneBox |= objBox;
+        std::vector<acre::math::affine3> worlds(draws.size());
+        for (size_t i = 0; i < draws.size(); ++i)
+            worlds[i] = draws[i].world;
+
+        // Split so no merged geometry passes batch_max_vertices
+        auto vertex_count = m_records[geo_idx].position.count;
+        auto chunk        = std::max<uint32_t>(m_config.batch_max_vertices / std::max(vertex_count, 1u), 1);
+        for (uint32_t first = 0; first < worlds.size(); first += chunk)
+        {
+            // Past batch_vertex_budget the copies cost more memory than the entities they save
+            auto count = std::min<uint32_t>(chunk, uint32_t(worlds.size()) - first);
+            auto fits  = baked + uint64_t(count) * vertex_count <= m_config.batch_vertex_budget;
+            if (fits) baked += uint64_t(count) * vertex_count;
+            if (!fits || !_create_batch(geo_idx, worlds.data() + first, count, batch_geo_idx))
+            {
+                for (uint32_t i = first; i < first + count; ++i)
+                    draw_single(draws[i], geo_idx, material_idx);
+                continue;
+            }
 
-            refs.emplace(geo_R);
-            refs.emplace(materialR);
-            refs.emplace(trsR);
+            auto geo_R = _get_geometry(batch_geo_idx++);
+            auto trsR  = _create_instance_transform(nullptr, InstanceTRS(), instance_index++);
+            _create_draw(entity_index++, geo_R, _get_draw_material(material_idx), trsR);
+            add_instance(geo_R, worldBoxes.emplace_back(geo_R->ptr<acre::GeometryID>()->box), 1.0f);
 
-            m_scene->update(entity, std::move(refs));
+            stats.batch_count++;
+            stats.batched_draws += count;
         }
     }
 
-    m_scene->merge_box(sceneBox);
+    m_scene->merge_box(worldBoxes.data(), worldBoxes.size());
 }
 
-
 void GLTFLoader::_create_animation()
 {
     auto animationSet = m_scene->animation_set();
     for (const auto& animation : m_model->animations)
     {
         acre::Animation acre_animation;
+        acre_animation.asset    = m_asset;
         acre_animation.name     = animation.name;
         acre_animation.duration = 0.0f;
 
@@ -634,25 +2830,22 @@ void GLTFLoader::_create_animation()
             // input
             const auto&  inputAccessor   = m_model->accessors[sampler.input];
             const auto&  inputBufferView = m_model->bufferViews[inputAccessor.bufferView];
-            const auto&  inputBuffer     = m_model->buffers[inputBufferView.buffer].data;
+            const auto   inputBuffer     = _buffer_data(inputBufferView.buffer);
             const float* inputData       = reinterpret_cast<const float*>(&inputBuffer[inputBufferView.byteOffset + inputAccessor.byteOffset]);
             acre_sampler.input.assign(inputData, inputData + inputAccessor.count);
 
-            // output
+            // output, CUBICSPLINE keys carry an in- and out-tangent around the value
             const auto&  outputAccessor   = m_model->accessors[sampler.output];
             const auto&  outputBufferView = m_model->bufferViews[outputAccessor.bufferView];
-            const auto&  outputBuffer     = m_model->buffers[outputBufferView.buffer].data;
+            const auto   outputBuffer     = _buffer_data(outputBufferView.buffer);
             const float* outputData       = reinterpret_cast<const float*>(&outputBuffer[outputBufferView.byteOffset + outputAccessor.byteOffset]);
-            int          elemSize         = 1;
+            uint32_t     elemSize         = 1;
             if (outputAccessor.type == TINYGLTF_TYPE_VEC3)
                 elemSize = 3;
             else if (outputAccessor.type == TINYGLTF_TYPE_VEC4)
                 elemSize = 4;
-            for (size_t i = 0; i < outputAccessor.count; ++i)
-            {
-                std::vector<float> value(outputData + i * elemSize, outputData + (i + 1) * elemSize);
-                acre_sampler.output.push_back(value);
-            }
+            auto tangents = sampler.interpolation == "CUBICSPLINE";
+            acre_sampler.output.assign(outputData, tangents ? outputAccessor.count / 3 : outputAccessor.count, elemSize, tangents);
             acre_animation.samplers.push_back(acre_sampler);
             if (!acre_sampler.input.empty() && acre_sampler.input.back() > acre_animation.duration)
                 acre_animation.duration = acre_sampler.input.back();
@@ -668,7 +2861,20 @@ void GLTFLoader::_create_animation()
             acre_animation.channels.push_back(acre_channel);
         }
 
-        animationSet->animations.push_back(acre_animation);
+        acre::compress_animation(acre_animation, m_config.animation_tolerance, m_config.quantize_rotations);
+
+        const auto& report = acre_animation.report;
+        printf("[gltf][loader] animation %s: %llu -> %llu keys, %.1f -> %.1f KB, max error %g\n", acre_animation.name.c_str(), (unsigned long long)report.keys_in,
+               (unsigned long long)report.keys_out, report.bytes_in / 1024.0, report.bytes_out / 1024.0, report.max_error);
+
+        auto& stats = m_scene->load_stats();
+        stats.animation_keys_in += report.keys_in;
+        stats.animation_keys_out += report.keys_out;
+        stats.animation_bytes_in += report.bytes_in;
+        stats.animation_bytes_out += report.bytes_out;
+        stats.animation_max_error = std::max(stats.animation_max_error, report.max_error);
+
+        animationSet->animations.push_back(std::move(acre_animation));
     }
 }
 
@@ -735,9 +2941,9 @@ void GLTFLoader::_create_texture_transform(const tinygltf::Value& value, uint32_
 
     std::unordered_set<acre::Resource*> refs;
 
-    auto textureR = m_scene->find<acre::TextureID>(uuid);
+    auto textureR = m_scene->find<acre::TextureID>(_uuid(uuid));
 
-    auto acreTrsR   = m_scene->create<acre::TransformID>(textureR->idx() + 1 << 16);
+    auto acreTrsR   = m_scene->create<acre::TransformID>(_uuid((textureR->idx() + 1) << 16));
     auto acreTrs    = acreTrsR->ptr<acre::TransformID>();
     acreTrs->matrix = transformMat;
     acreTrs->affine = acre::math::homogeneousToAffine(transformMat);
@@ -752,7 +2958,7 @@ acre::Resource* GLTFLoader::_get_image(std::unordered_set<acre::Resource*>& refs
 {
     if (uuid == -1) return nullptr;
 
-    auto node = m_scene->find<acre::ImageID>(uuid);
+    auto node = m_scene->find<acre::ImageID>(uuid < m_image_uuids.size() ? m_image_uuids[uuid] : _uuid(uuid));
     refs.emplace(node);
     return node;
 }
@@ -761,7 +2967,7 @@ acre::Resource* GLTFLoader::_get_sampler(std::unordered_set<acre::Resource*>& re
 {
     if (uuid == -1) return nullptr;
 
-    auto node = m_scene->find<acre::SamplerID>(uuid);
+    auto node = m_scene->find<acre::SamplerID>(_uuid(uuid));
     refs.emplace(node);
     return node;
 }
@@ -770,7 +2976,7 @@ acre::Resource* GLTFLoader::_get_texture(std::unordered_set<acre::Resource*>& re
 {
     if (uuid == -1) return nullptr;
 
-    auto node = m_scene->find<acre::TextureID>(uuid);
+    auto node = m_scene->find<acre::TextureID>(_uuid(uuid));
     refs.emplace(node);
     return node;
 }
@@ -779,21 +2985,21 @@ acre::Resource* GLTFLoader::_get_transform(uint32_t uuid)
 {
     if (uuid == -1) return nullptr;
 
-    return m_scene->find<acre::TransformID>(uuid);
+    return m_scene->find<acre::TransformID>(_uuid(uuid));
 }
 
 acre::Resource* GLTFLoader::_get_geometry(uint32_t uuid)
 {
     if (uuid == -1) return nullptr;
 
-    return m_scene->find<acre::GeometryID>(uuid);
+    return m_scene->find<acre::GeometryID>(_uuid(uuid));
 }
 
 acre::Resource* GLTFLoader::_get_material(uint32_t uuid)
 {
     if (uuid == -1) return nullptr;
 
-    return m_scene->find<acre::MaterialID>(uuid);
+    return m_scene->find<acre::MaterialID>(_uuid(uuid));
 }
 
 acre::ImageID GLTFLoader::_get_image_id(std::unordered_set<acre::Resource*>& refs, uint32_t uuid)
@@ -0,0 +1,467 @@
+#include <controller/loader/sceneCache.h>
+#include <utils/hash.h>
+#include <utils/mipmap.h>
+
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+static constexpr char     g_magic[8] = {'A', 'C', 'R', 'E', 'S', 'C', 'N', 'C'};
+static constexpr uint32_t g_version  = 4;
+static constexpr uint64_t g_align    = 16;
+
+// On-disk layout, plain little endian PODs
+struct CacheHeader
+{
+    char     magic[8];
+    uint32_t version;
+    uint32_t geometry_count;
+    uint64_t key;
+    uint64_t file_size;
+    uint64_t geometry_offset;
+    uint64_t image_offset;
+    uint32_t image_count;
+    uint32_t reserved;
+    uint64_t stamp;
+};
+
+struct CacheStream
+{
+    uint64_t offset; // 0: no stream
+    uint32_t count;
+    uint32_t stride;
+    uint32_t size;
+    uint16_t type;
+    uint16_t normalized;
+};
+
+struct CacheLod
+{
+    CacheStream index;
+    float       error;
+    uint32_t    reserved;
+};
+
+enum CacheFlags : uint32_t
+{
+    fHasBox    = 1 << 0,
+    fOptimized = 1 << 1,
+    fQPosition = 1 << 2,
+    fQNormal   = 1 << 3,
+    fQTangent  = 1 << 4,
+    fQUV       = 1 << 5,
+    fQWeight   = 1 << 6,
+};
+
+struct CacheGeometry
+{
+    int32_t  mesh_idx;
+    int32_t  prim_idx;
+    uint32_t geo_idx;
+    uint32_t flags;
+
+    CacheStream index;
+    CacheStream position;
+    CacheStream uv;
+    CacheStream normal;
+    CacheStream tangent;
+    CacheStream joint;
+    CacheStream weight;
+
+    float box[6];
+    float position_offset[3];
+    float position_scale[3];
+
+    uint32_t triangles;
+    float    acmr_before;
+    float    acmr_after;
+    uint32_t lod_count;
+    uint64_t bytes_raw;
+    uint64_t bytes;
+    uint64_t attribute_bytes_raw;
+    uint64_t attribute_bytes;
+    uint64_t lod_offset;
+
+    uint32_t meshlet_count;
+    uint32_t meshlet_vertex_count;
+    uint32_t meshlet_triangle_bytes;
+    uint32_t reserved;
+    uint64_t meshlet_offset;
+    uint64_t meshlet_bounds_offset;
+    uint64_t meshlet_vertices_offset;
+    uint64_t meshlet_triangles_offset;
+};
+
+struct CacheImage
+{
+    uint64_t offset; // 0: not cached
+    uint32_t width;
+    uint32_t height;
+    uint32_t levels;
+    uint32_t pad;
+};
+
+class CacheWriter
+{
+    std::ofstream m_file;
+    uint64_t      m_offset = 0;
+
+public:
+    explicit CacheWriter(const std::string& fileName) :
+        m_file(fileName, std::ios::binary | std::ios::trunc) {}
+
+    bool good() const { return m_file.good(); }
+
+    auto offset() const { return m_offset; }
+
+    uint64_t write(const void* data, size_t size)
+    {
+        auto start = m_offset;
+        m_file.write(static_cast<const char*>(data), std::streamsize(size));
+        m_offset += size;
+        return start;
+    }
+
+    void align()
+    {
+        static const char zeros[g_align] = {};
+        auto              padding        = (g_align - m_offset % g_align) % g_align;
+        write(zeros, padding);
+    }
+
+    // Returns the aligned offset of the blob, 0 for an empty blob
+    uint64_t blob(const void* data, size_t size)
+    {
+        if (!data || size == 0) return 0;
+
+        align();
+        return write(data, size);
+    }
+
+    void patch(uint64_t offset, const void* data, size_t size)
+    {
+        auto position = m_file.tellp();
+        m_file.seekp(std::streamoff(offset));
+        m_file.write(static_cast<const char*>(data), std::streamsize(size));
+        m_file.seekp(position);
+    }
+};
+
+// Strided streams are packed to their element size on the way out
+static CacheStream writeStream(CacheWriter& writer, const AttributeView& view)
+{
+    CacheStream stream = {};
+    if (!view.valid() || view.count == 0) return stream;
+
+    auto size         = view.size ? view.size : view.stride;
+    stream.count      = view.count;
+    stream.stride     = size;
+    stream.size       = size;
+    stream.type       = uint16_t(view.type);
+    stream.normalized = view.normalized;
+
+    if (view.stride == size)
+    {
+        stream.offset = writer.blob(view.data, size_t(view.count) * size);
+        return stream;
+    }
+
+    writer.align();
+    stream.offset = writer.offset();
+    for (uint32_t i = 0; i < view.count; ++i)
+        writer.write(view.data + size_t(i) * view.stride, size);
+    return stream;
+}
+
+static bool readStream(const MappedFile& mapped, const CacheStream& stream, AttributeView& view)
+{
+    view = AttributeView();
+    if (stream.offset == 0) return true;
+
+    if (stream.offset + uint64_t(stream.count) * stream.stride > mapped.size()) return false;
+
+    view.data       = mapped.data() + stream.offset;
+    view.count      = stream.count;
+    view.stride     = stream.stride;
+    view.size       = stream.size;
+    view.type       = stream.type;
+    view.normalized = stream.normalized != 0;
+    return true;
+}
+
+template <typename T>
+static bool readArray(const MappedFile& mapped, uint64_t offset, size_t count, std::vector<T>& out)
+{
+    out.clear();
+    if (count == 0) return true;
+    if (offset == 0 || offset + count * sizeof(T) > mapped.size()) return false;
+
+    out.resize(count);
+    memcpy(out.data(), mapped.data() + offset, count * sizeof(T));
+    return true;
+}
+
+static const CacheHeader* header(const MappedFile& mapped)
+{
+    return reinterpret_cast<const CacheHeader*>(mapped.data());
+}
+
+bool SceneCache::open(const std::string& fileName, uint64_t stamp, const std::function<uint64_t()>& content_key)
+{
+    close();
+
+    // The header is checked before the file is mapped, restamping writes into it
+    CacheHeader head;
+    {
+        std::ifstream file(fileName, std::ios::binary);
+        if (!file.read(reinterpret_cast<char*>(&head), sizeof(head))) return false;
+    }
+    if (memcmp(head.magic, g_magic, sizeof(g_magic)) != 0 || head.version != g_version) return false;
+
+    if (head.stamp != stamp)
+    {
+        if (head.key != content_key()) return false;
+
+        std::fstream file(fileName, std::ios::binary | std::ios::in | std::ios::out);
+        file.seekp(std::streamoff(offsetof(CacheHeader, stamp)));
+        file.write(reinterpret_cast<const char*>(&stamp), sizeof(stamp));
+    }
+
+    if (!m_mapped.open(fileName)) return false;
+
+    bool valid = m_mapped.size() >= sizeof(head) && head.file_size == m_mapped.size();
+    valid      = valid && head.geometry_offset + uint64_t(head.geometry_count) * sizeof(CacheGeometry) <= m_mapped.size();
+    valid      = valid && head.image_offset + uint64_t(head.image_count) * sizeof(CacheImage) <= m_mapped.size();
+    if (!valid)
+    {
+        close();
+        return false;
+    }
+
+    m_mapped.advise(0, m_mapped.size(), MappedFile::Advice::aWillNeed);
+    return true;
+}
+
+bool SceneCache::read_geometry(std::vector<GeometryRecord>& records) const
+{
+    if (!is_open()) return false;
+
+    const auto head    = header(m_mapped);
+    const auto entries = reinterpret_cast<const CacheGeometry*>(m_mapped.data() + head->geometry_offset);
+
+    records.clear();
+    records.resize(head->geometry_count);
+    for (uint32_t i = 0; i < head->geometry_count; ++i)
+    {
+        CacheGeometry entry;
+        memcpy(&entry, entries + i, sizeof(entry));
+
+        auto& record    = records[i];
+        record.mesh_idx = entry.mesh_idx;
+        record.prim_idx = entry.prim_idx;
+        record.geo_idx  = entry.geo_idx;
+
+        bool ok = readStream(m_mapped, entry.index, record.index) &&
+                  readStream(m_mapped, entry.position, record.position) &&
+                  readStream(m_mapped, entry.uv, record.uv) &&
+                  readStream(m_mapped, entry.normal, record.normal) &&
+                  readStream(m_mapped, entry.tangent, record.tangent) &&
+                  readStream(m_mapped, entry.joint, record.joint) &&
+                  readStream(m_mapped, entry.weight, record.weight);
+        if (!ok) return false;
+
+        record.has_box = entry.flags & fHasBox;
+        if (record.has_box)
+        {
+            record.box.m_mins = acre::math::float3(entry.box[0], entry.box[1], entry.box[2]);
+            record.box.m_maxs = acre::math::float3(entry.box[3], entry.box[4], entry.box[5]);
+        }
+
+        record.optimized           = entry.flags & fOptimized;
+        record.triangles           = entry.triangles;
+        record.acmr_before         = entry.acmr_before;
+        record.acmr_after          = entry.acmr_after;
+        record.bytes_raw           = entry.bytes_raw;
+        record.bytes               = entry.bytes;
+        record.attribute_bytes_raw = entry.attribute_bytes_raw;
+        record.attribute_bytes     = entry.attribute_bytes;
+
+        auto& quantization           = record.quantization;
+        quantization.position        = entry.flags & fQPosition;
+        quantization.normal          = entry.flags & fQNormal;
+        quantization.tangent         = entry.flags & fQTangent;
+        quantization.uv              = entry.flags & fQUV;
+        quantization.weight          = entry.flags & fQWeight;
+        quantization.position_offset = acre::math::float3(entry.position_offset[0], entry.position_offset[1], entry.position_offset[2]);
+        quantization.position_scale  = acre::math::float3(entry.position_scale[0], entry.position_scale[1], entry.position_scale[2]);
+
+        std::vector<CacheLod> lods;
+        if (!readArray(m_mapped, entry.lod_offset, entry.lod_count, lods)) return false;
+        for (const auto& lod : lods)
+        {
+            if (!readStream(m_mapped, lod.index, record.lods.emplace_back())) return false;
+            record.lod_errors.push_back(lod.error);
+        }
+
+        auto& meshlets = record.meshlets;
+        ok             = readArray(m_mapped, entry.meshlet_offset, entry.meshlet_count, meshlets.meshlets) &&
+                         readArray(m_mapped, entry.meshlet_bounds_offset, entry.meshlet_count, meshlets.bounds) &&
+                         readArray(m_mapped, entry.meshlet_vertices_offset, entry.meshlet_vertex_count, meshlets.vertices) &&
+                         readArray(m_mapped, entry.meshlet_triangles_offset, entry.meshlet_triangle_bytes, meshlets.triangles);
+        if (!ok) return false;
+    }
+
+    return true;
+}
+
+bool SceneCache::read_images(std::vector<Image>& images) const
+{
+    if (!is_open()) return false;
+
+    const auto head    = header(m_mapped);
+    const auto entries = reinterpret_cast<const CacheImage*>(m_mapped.data() + head->image_offset);
+
+    images.clear();
+    images.resize(head->image_count);
+    for (uint32_t i = 0; i < head->image_count; ++i)
+    {
+        CacheImage entry;
+        memcpy(&entry, entries + i, sizeof(entry));
+        if (entry.offset == 0) continue;
+        if (entry.levels == 0 || entry.levels > mipmap::level_count(entry.width, entry.height)) return false;
+        if (entry.offset + mipmap::chain_pixels(entry.width, entry.height, entry.levels) * 4 > m_mapped.size()) return false;
+
+        images[i].pixels = m_mapped.data() + entry.offset;
+        images[i].width  = entry.width;
+        images[i].height = entry.height;
+        images[i].levels = entry.levels;
+    }
+
+    return true;
+}
+
+bool SceneCache::write(const std::string& fileName, uint64_t stamp, uint64_t key, const std::vector<GeometryRecord>& records, const std::vector<Image>& images)
+{
+    std::error_code error;
+    std::filesystem::create_directories(std::filesystem::path(fileName).parent_path(), error);
+
+    auto temporary = fileName + ".tmp";
+    {
+        CacheWriter writer(temporary);
+        if (!writer.good()) return false;
+
+        CacheHeader head = {};
+        memcpy(head.magic, g_magic, sizeof(g_magic));
+        head.version        = g_version;
+        head.key            = key;
+        head.stamp          = stamp;
+        head.geometry_count = uint32_t(records.size());
+        head.image_count    = uint32_t(images.size());
+        writer.write(&head, sizeof(head));
+
+        std::vector<CacheGeometry> entries(records.size());
+        for (size_t i = 0; i < records.size(); ++i)
+        {
+            const auto& record = records[i];
+            auto&       entry  = entries[i];
+            entry              = {};
+
+            entry.mesh_idx = record.mesh_idx;
+            entry.prim_idx = record.prim_idx;
+            entry.geo_idx  = record.geo_idx;
+
+            entry.index    = writeStream(writer, record.index);
+            entry.position = writeStream(writer, record.position);
+            entry.uv       = writeStream(writer, record.uv);
+            entry.normal   = writeStream(writer, record.normal);
+            entry.tangent  = writeStream(writer, record.tangent);
+            entry.joint    = writeStream(writer, record.joint);
+            entry.weight   = writeStream(writer, record.weight);
+
+            const auto& quantization = record.quantization;
+            entry.flags |= record.has_box ? fHasBox : 0;
+            entry.flags |= record.optimized ? fOptimized : 0;
+            entry.flags |= quantization.position ? fQPosition : 0;
+            entry.flags |= quantization.normal ? fQNormal : 0;
+            entry.flags |= quantization.tangent ? fQTangent : 0;
+            entry.flags |= quantization.uv ? fQUV : 0;
+            entry.flags |= quantization.weight ? fQWeight : 0;
+
+            float box[6] = {record.box.m_mins.x, record.box.m_mins.y, record.box.m_mins.z, record.box.m_maxs.x, record.box.m_maxs.y, record.box.m_maxs.z};
+            memcpy(entry.box, box, sizeof(box));
+            for (int c = 0; c < 3; ++c)
+            {
+                entry.position_offset[c] = quantization.position_offset[c];
+                entry.position_scale[c]  = quantization.position_scale[c];
+            }
+
+            entry.triangles           = record.triangles;
+            entry.acmr_before         = record.acmr_before;
+            entry.acmr_after          = record.acmr_after;
+            entry.bytes_raw           = record.bytes_raw;
+            entry.bytes               = record.bytes;
+            entry.attribute_bytes_raw = record.attribute_bytes_raw;
+            entry.attribute_bytes     = record.attribute_bytes;
+
+            std::vector<CacheLod> lods(record.lods.size());
+            for (size_t level = 0; level < record.lods.size(); ++level)
+            {
+                lods[level].index = writeStream(writer, record.lods[level]);
+                lods[level].error = record.lod_errors[level];
+            }
+            entry.lod_count  = uint32_t(lods.size());
+            entry.lod_offset = writer.blob(lods.data(), lods.size() * sizeof(CacheLod));
+
+            const auto& meshlets           = record.meshlets;
+            entry.meshlet_count            = uint32_t(meshlets.meshlets.size());
+            entry.meshlet_vertex_count     = uint32_t(meshlets.vertices.size());
+            entry.meshlet_triangle_bytes   = uint32_t(meshlets.triangles.size());
+            entry.meshlet_offset           = writer.blob(meshlets.meshlets.data(), meshlets.meshlets.size() * sizeof(meshopt::Meshlet));
+            entry.meshlet_bounds_offset    = writer.blob(meshlets.bounds.data(), meshlets.bounds.size() * sizeof(meshopt::MeshletBounds));
+            entry.meshlet_vertices_offset  = writer.blob(meshlets.vertices.data(), meshlets.vertices.size() * sizeof(uint32_t));
+            entry.meshlet_triangles_offset = writer.blob(meshlets.triangles.data(), meshlets.triangles.size());
+        }
+
+        std::vector<CacheImage> imageEntries(images.size());
+        for (size_t i = 0; i < images.size(); ++i)
+        {
+            const auto& image      = images[i];
+            imageEntries[i].width  = image.width;
+            imageEntries[i].height = image.height;
+            imageEntries[i].levels = image.levels;
+            imageEntries[i].offset = writer.blob(image.pixels, mipmap::chain_pixels(image.width, image.height, image.levels) * 4);
+        }
+
+        writer.align();
+        head.geometry_offset = writer.write(entries.data(), entries.size() * sizeof(CacheGeometry));
+        writer.align();
+        head.image_offset = writer.write(imageEntries.data(), imageEntries.size() * sizeof(CacheImage));
+        head.file_size    = writer.offset();
+        writer.patch(0, &head, sizeof(head));
+
+        if (!writer.good()) return false;
+    }
+
+    std::filesystem::rename(temporary, fileName, error);
+    if (error)
+    {
+        std::filesystem::remove(temporary, error);
+        return false;
+    }
+
+    return true;
+}
+
+std::string SceneCache::path_for(const std::string& sourceName, const std::string& dir)
+{
+    std::error_code error;
+
+    auto source = std::filesystem::absolute(sourceName, error).generic_string();
+    auto root   = dir.empty() ? std::filesystem::temp_directory_path(error) / "acreEditor" : std::filesystem::path(dir);
+
+    char name[32];
+    snprintf(name, sizeof(name), "%016llx.acrecache", (unsigned long long)hash64(source.data(), source.size()));
+    return (root / name).string();
+}
@@ -72,6 +72,9 @@ void TriangleLoader::loadScene(const std::string& fileName)
     createMaterial();
     createTransform();
     create_component_draw();
+
+    _on_ready();
+    _on_loaded();
 }
 
 void TriangleLoader::createGeometry()
@@ -1,8 +1,81 @@
 #include <model/animation.h>
 
+#include <algorithm>
+#include <cmath>
+
 namespace acre
 {
 
+void KeyframeStore::assign(const float* values, size_t count, uint32_t components, bool tangents)
+{
+    m_count      = count;
+    m_components = std::min(components, kMaxComponents);
+    m_stride     = tangents ? components * 3 : components;
+    m_offset     = tangents ? components : 0;
+
+    m_values.assign(values, values + count * m_stride);
+    m_snorm.clear();
+}
+
+void KeyframeStore::read(size_t key, float* out) const
+{
+    if (!m_snorm.empty())
+    {
+        const auto* q      = &m_snorm[key * 4];
+        float       length = 0.0f;
+        for (uint32_t c = 0; c < 4; ++c)
+        {
+            out[c] = float(q[c]) / 32767.0f;
+            length += out[c] * out[c];
+        }
+
+        auto scale = length > 0.0f ? 1.0f / std::sqrt(length) : 0.0f;
+        for (uint32_t c = 0; c < 4; ++c)
+            out[c] *= scale;
+        return;
+    }
+
+    const auto* value = m_values.data() + key * m_stride + m_offset;
+    for (uint32_t c = 0; c < m_components; ++c)
+        out[c] = value[c];
+}
+
+void KeyframeStore::keep(const std::vector<uint32_t>& keys)
+{
+    // Keys are ascending, compacting front to back never overwrites a key still to be moved
+    for (size_t i = 0; i < keys.size(); ++i)
+    {
+        if (!m_snorm.empty())
+            std::copy_n(m_snorm.begin() + keys[i] * 4, 4, m_snorm.begin() + i * 4);
+        else
+            std::copy_n(m_values.begin() + keys[i] * m_stride, m_stride, m_values.begin() + i * m_stride);
+    }
+
+    m_count = keys.size();
+    if (!m_snorm.empty())
+        m_snorm.resize(m_count * 4);
+    else
+        m_values.resize(m_count * m_stride);
+}
+
+bool KeyframeStore::quantize_rotations()
+{
+    if (m_components != 4 || m_stride != 4 || !m_snorm.empty()) return false;
+
+    m_snorm.resize(m_count * 4);
+    for (size_t key = 0; key < m_count; ++key)
+    {
+        const auto* q      = m_values.data() + key * 4;
+        auto        length = std::sqrt(q[0] * q[0] + q[1] * q[1] + q[2] * q[2] + q[3] * q[3]);
+        auto        scale  = length > 0.0f ? 1.0f / length : 0.0f;
+        for (uint32_t c = 0; c < 4; ++c)
+            m_snorm[key * 4 + c] = int16_t(std::lround(std::clamp(q[c] * scale, -1.0f, 1.0f) * 32767.0f));
+    }
+
+    decltype(m_values)().swap(m_values);
+    return true;
+}
+
 Animation* AnimationSet::animation(const std::string& name)
 {
     for (auto& animation : animations)
@@ -13,4 +86,148 @@ Animation* AnimationSet::animation(const std::string& name)
     return nullptr;
 }
 
+// Longest run of keys one pair may replace, bounds the cost of flat curves
+static constexpr uint32_t kMaxSpan = 256;
+
+static float maxDeviation(const float* a, const float* b, uint32_t components)
+{
+    float deviation = 0.0f;
+    for (uint32_t c = 0; c < components; ++c)
+        deviation = std::max(deviation, std::abs(a[c] - b[c]));
+    return deviation;
+}
+
+static void lerpKeys(const float* a, const float* b, float t, uint32_t components, float* out)
+{
+    for (uint32_t c = 0; c < components; ++c)
+        out[c] = a[c] + (b[c] - a[c]) * t;
+}
+
+static float keyFactor(const std::vector<float>& times, size_t from, size_t to, float time)
+{
+    auto span = times[to] - times[from];
+    return span > 0.0f ? (time - times[from]) / span : 0.0f;
+}
+
+static std::vector<uint32_t> reduceKeys(const AnimationSampler& sampler, size_t count, float tolerance)
+{
+    const auto& times      = sampler.input;
+    const auto& store      = sampler.output;
+    auto        components = store.components();
+    auto        step       = sampler.interpolation == "STEP";
+
+    std::vector<uint32_t> keys;
+    keys.reserve(count);
+    keys.push_back(0);
+
+    // A key goes when the kept key before it and the key after it reproduce it, and every key
+    // dropped since, within tolerance
+    float    from[KeyframeStore::kMaxComponents], to[KeyframeStore::kMaxComponents];
+    float    value[KeyframeStore::kMaxComponents], lerped[KeyframeStore::kMaxComponents];
+    uint32_t anchor = 0;
+    for (uint32_t key = 1; key + 1 < count; ++key)
+    {
+        auto drop = key - anchor < kMaxSpan;
+        store.read(anchor, from);
+        if (drop && step)
+        {
+            store.read(key, value);
+            drop = maxDeviation(from, value, components) <= tolerance;
+        }
+        else if (drop)
+        {
+            store.read(key + 1, to);
+            for (auto skipped = anchor + 1; drop && skipped <= key; ++skipped)
+            {
+                store.read(skipped, value);
+                lerpKeys(from, to, keyFactor(times, anchor, key + 1, times[skipped]), components, lerped);
+                drop = maxDeviation(lerped, value, components) <= tolerance;
+            }
+        }
+
+        if (drop) continue;
+
+        keys.push_back(key);
+        anchor = key;
+    }
+
+    if (count > 1) keys.push_back(uint32_t(count - 1));
+    return keys;
+}
+
+// Largest deviation of the compressed sampler from the imported one at the imported key times
+static float sampleError(const AnimationSampler& original, const AnimationSampler& compressed, size_t count)
+{
+    auto components = original.output.components();
+    auto step       = original.interpolation == "STEP";
+    auto keys       = compressed.output.count();
+
+    float  from[KeyframeStore::kMaxComponents], to[KeyframeStore::kMaxComponents];
+    float  value[KeyframeStore::kMaxComponents], sampled[KeyframeStore::kMaxComponents];
+    float  error  = 0.0f;
+    size_t cursor = 0;
+    for (size_t key = 0; key < count; ++key)
+    {
+        auto time = original.input[key];
+        while (cursor + 2 < keys && time > compressed.input[cursor + 1])
+            ++cursor;
+
+        original.output.read(key, value);
+        compressed.output.read(cursor, from);
+        if (step || keys < 2)
+        {
+            if (keys >= 2 && time >= compressed.input[cursor + 1]) compressed.output.read(cursor + 1, from);
+            std::copy_n(from, components, sampled);
+        }
+        else
+        {
+            compressed.output.read(cursor + 1, to);
+            lerpKeys(from, to, keyFactor(compressed.input, cursor, cursor + 1, time), components, sampled);
+        }
+        error = std::max(error, maxDeviation(sampled, value, components));
+    }
+    return error;
+}
+
+void compress_animation(Animation& animation, float tolerance, bool quantize_rotations)
+{
+    std::vector<uint8_t> rotations(animation.samplers.size(), 0);
+    for (const auto& channel : animation.channels)
+    {
+        if (channel.target_path == "rotation" && channel.sampler_idx >= 0 && channel.sampler_idx < rotations.size()) rotations[channel.sampler_idx] = 1;
+    }
+
+    auto& report = animation.report;
+    report       = AnimationReport();
+    for (size_t idx = 0; idx < animation.samplers.size(); ++idx)
+    {
+        auto& sampler = animation.samplers[idx];
+        auto  count   = std::min(sampler.input.size(), sampler.output.count());
+
+        report.keys_in += count;
+        report.bytes_in += sampler.input.size() * sizeof(float) + sampler.output.bytes();
+
+        if (sampler.interpolation != "CUBICSPLINE" && count > 2 && sampler.input.size() == sampler.output.count())
+        {
+            auto original = sampler;
+
+            auto keys = reduceKeys(sampler, count, tolerance);
+            if (keys.size() < count)
+            {
+                std::vector<float> times(keys.size());
+                for (size_t i = 0; i < keys.size(); ++i)
+                    times[i] = sampler.input[keys[i]];
+                sampler.input = std::move(times);
+                sampler.output.keep(keys);
+            }
+            if (quantize_rotations && rotations[idx]) sampler.output.quantize_rotations();
+
+            report.max_error = std::max(report.max_error, sampleError(original, sampler, count));
+        }
+
+        report.keys_out += sampler.output.count();
+        report.bytes_out += sampler.input.size() * sizeof(float) + sampler.output.bytes();
+    }
+}
+
 } // namespace acre
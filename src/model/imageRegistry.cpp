@@ -0,0 +1,17 @@
+#include <model/imageRegistry.h>
+
+namespace acre
+{
+
+void ImageRegistry::release(AssetID asset)
+{
+    for (auto iter = m_entries.begin(); iter != m_entries.end();)
+    {
+        if (asset_of(iter->second.uuid) == asset)
+            iter = m_entries.erase(iter);
+        else
+            ++iter;
+    }
+}
+
+} // namespace acre
@@ -0,0 +1,304 @@
+#include <model/imageResidency.h>
+#include <model/wrapper/resourceTree.h>
+#include <utils/workerPool.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+
+namespace acre
+{
+
+static uint32_t texelBytes(Image::Format format)
+{
+    switch (format)
+    {
+        case Image::Format::RGBA8_UNORM: return 4;
+        case Image::Format::RGBA16_FLOAT: return 8;
+        case Image::Format::RGBA32_FLOAT: return 16;
+        default: return 0;
+    }
+}
+
+bool ImageResidency::_init(Resource* node, Entry& entry)
+{
+    auto image = node ? node->ptr<ImageID>() : nullptr;
+    if (!image || !image->data || !image->width || !image->height) return false;
+
+    // Only full chains, the levels kept after an eviction must reach down to 1x1
+    entry.texel = texelBytes(image->format);
+    if (!entry.texel || image->mipmaps < 2 || (std::max(image->width, image->height) >> (image->mipmaps - 1)) != 1) return false;
+
+    entry.width  = image->width;
+    entry.height = image->height;
+    entry.levels = image->mipmaps;
+
+    entry.offsets.resize(entry.levels + 1);
+    size_t offset = 0;
+    for (uint32_t level = 0; level < entry.levels; ++level)
+    {
+        entry.offsets[level] = offset;
+        offset += size_t(std::max(entry.width >> level, 1u)) * std::max(entry.height >> level, 1u) * entry.texel;
+
+        if (std::max(entry.width >> level, entry.height >> level) > kMinResidentSize) entry.min_level = level + 1;
+    }
+    entry.offsets[entry.levels] = offset;
+    entry.min_level             = std::min(entry.min_level, entry.levels - 1);
+
+    entry.serial   = ++m_serial;
+    entry.last_use = m_frame;
+    return true;
+}
+
+bool ImageResidency::track(Resource* node, std::vector<unsigned char>& chain, Reload reload)
+{
+    Entry entry;
+    if (!_init(node, entry) || node->ptr<ImageID>()->data != chain.data() || chain.size() < entry.offsets[entry.levels]) return false;
+
+    entry.chain.swap(chain);
+    entry.reload           = std::move(reload);
+    m_entries[node->uuid()] = std::move(entry);
+    return true;
+}
+
+bool ImageResidency::track_mapped(Resource* node, const unsigned char* chain)
+{
+    Entry entry;
+    if (!_init(node, entry) || node->ptr<ImageID>()->data != chain) return false;
+
+    entry.mapped            = chain;
+    m_entries[node->uuid()] = std::move(entry);
+    return true;
+}
+
+void ImageResidency::use(UUID uuid, float pixels)
+{
+    auto iter = m_entries.find(uuid);
+    if (iter == m_entries.end()) return;
+
+    // The level whose texels come closest to one per pixel, drawing the image over pixels
+    auto&    entry = iter->second;
+    uint32_t level = entry.min_level;
+    if (pixels > 0.0f)
+    {
+        auto ratio = float(std::max(entry.width, entry.height)) / pixels;
+        level      = ratio > 1.0f ? std::min(uint32_t(std::log2(ratio)), entry.min_level) : 0;
+    }
+
+    if (entry.last_use != m_frame)
+    {
+        entry.last_use   = m_frame;
+        entry.want_level = level;
+    }
+    else
+    {
+        entry.want_level = std::min(entry.want_level, level);
+    }
+}
+
+void ImageResidency::update(ResourceTree& tree, const Post& post)
+{
+    std::erase_if(m_tasks, [](const auto& task) { return task.wait_for(std::chrono::seconds(0)) == std::future_status::ready; });
+
+    // Nodes removed from the tree take their entry along
+    std::erase_if(m_entries, [&](const auto& item) { return !tree.has<ImageID>(item.first); });
+
+    auto want = [this](const Entry& entry) { return entry.last_use == m_frame ? entry.want_level : entry.min_level; };
+
+    size_t resident = 0;
+    for (const auto& [uuid, entry] : m_entries)
+        resident += entry.bytes(entry.first_level);
+
+    std::vector<std::pair<UUID, Entry*>> order;
+    order.reserve(m_entries.size());
+    for (auto& [uuid, entry] : m_entries)
+    {
+        if (!entry.loading) order.emplace_back(uuid, &entry);
+    }
+
+    auto budget = m_stats.budget;
+    if (resident > budget)
+    {
+        // Least recently used first, the farther of two equally recent ones first. Evicting to 7/8 of
+        // the budget keeps the reloads from chasing the evictions every frame
+        std::sort(order.begin(), order.end(), [&](const auto& a, const auto& b) {
+            if (a.second->last_use != b.second->last_use) return a.second->last_use < b.second->last_use;
+            return want(*a.second) > want(*b.second);
+        });
+        auto target = budget - budget / 8;
+
+        // Levels finer than any draw needs go first, then one level at a time off every image
+        for (auto& [uuid, entry] : order)
+        {
+            if (resident <= target) break;
+            if (entry->first_level >= want(*entry)) continue;
+
+            resident -= entry->bytes(entry->first_level) - entry->bytes(want(*entry));
+            _evict(tree, uuid, *entry, want(*entry));
+        }
+
+        bool evicted = true;
+        while (resident > target && evicted)
+        {
+            evicted = false;
+            for (auto& [uuid, entry] : order)
+            {
+                if (resident <= target) break;
+                if (entry->first_level >= entry->min_level) continue;
+
+                resident -= entry->bytes(entry->first_level) - entry->bytes(entry->first_level + 1);
+                _evict(tree, uuid, *entry, entry->first_level + 1);
+                evicted = true;
+            }
+        }
+    }
+    else
+    {
+        // Drawn images missing the most levels first, each at the finest level the budget allows
+        std::erase_if(order, [&](const auto& item) {
+            const auto& entry = *item.second;
+            return entry.last_use != m_frame || entry.want_level >= entry.first_level || (!entry.mapped && !entry.reload);
+        });
+        std::sort(order.begin(), order.end(), [](const auto& a, const auto& b) {
+            return a.second->first_level - a.second->want_level > b.second->first_level - b.second->want_level;
+        });
+
+        for (auto& [uuid, entry] : order)
+        {
+            if (m_stats.loading >= kMaxReloads) break;
+
+            auto level = entry->want_level;
+            while (level < entry->first_level && resident + m_reserved + entry->bytes(level) - entry->bytes(entry->first_level) > budget)
+                level++;
+            if (level >= entry->first_level) continue;
+
+            resident += entry->mapped ? entry->bytes(level) - entry->bytes(entry->first_level) : 0;
+            _reload(tree, uuid, *entry, level, post);
+        }
+    }
+
+    m_stats.images         = uint32_t(m_entries.size());
+    m_stats.resident_bytes = 0;
+    m_stats.full_bytes     = 0;
+    m_stats.reduced_images = 0;
+    m_stats.used_images    = 0;
+    for (const auto& [uuid, entry] : m_entries)
+    {
+        m_stats.resident_bytes += entry.bytes(entry.first_level);
+        m_stats.full_bytes += entry.bytes(0);
+        m_stats.reduced_images += entry.first_level > 0;
+        m_stats.used_images += entry.last_use == m_frame;
+    }
+}
+
+void ImageResidency::_apply(ResourceTree& tree, UUID uuid, Entry& entry)
+{
+    if (!tree.has<ImageID>(uuid)) return;
+
+    auto node  = tree.get<ImageID>(uuid);
+    auto image = node->ptr<ImageID>();
+
+    image->data    = entry.mapped ? (void*)(entry.mapped + entry.offsets[entry.first_level]) : (void*)entry.chain.data();
+    image->width   = std::max(entry.width >> entry.first_level, 1u);
+    image->height  = std::max(entry.height >> entry.first_level, 1u);
+    image->mipmaps = entry.levels - entry.first_level;
+    tree.updateLeaf(node);
+}
+
+void ImageResidency::_evict(ResourceTree& tree, UUID uuid, Entry& entry, uint32_t level)
+{
+    auto freed = entry.bytes(entry.first_level) - entry.bytes(level);
+    if (!entry.mapped)
+    {
+        // A copy of the coarser levels, so the finer ones are actually released
+        std::vector<unsigned char> chain(entry.chain.begin() + (entry.offsets[level] - entry.offsets[entry.first_level]), entry.chain.end());
+        entry.chain.swap(chain);
+    }
+    entry.first_level = level;
+    _apply(tree, uuid, entry);
+
+    m_stats.evictions++;
+    m_stats.evicted_bytes += freed;
+}
+
+void ImageResidency::_reload(ResourceTree& tree, UUID uuid, Entry& entry, uint32_t level, const Post& post)
+{
+    auto reserved = entry.bytes(level) - entry.bytes(entry.first_level);
+
+    // The mapped chain is all there, only the image moves back up
+    if (entry.mapped)
+    {
+        entry.first_level = level;
+        _apply(tree, uuid, entry);
+
+        m_stats.reloads++;
+        m_stats.reloaded_bytes += reserved;
+        return;
+    }
+
+    entry.loading = true;
+    m_reserved += reserved;
+    m_stats.loading++;
+
+    auto offset = entry.offsets[level];
+    auto size   = entry.offsets[entry.levels];
+    m_tasks.emplace_back(WorkerPool::global().submit(
+        [this, tree = &tree, post, reload = entry.reload, uuid, serial = entry.serial, level, reserved, offset, size]() {
+            std::vector<unsigned char> chain;
+            if (reload(chain) && chain.size() >= size)
+                chain = std::vector<unsigned char>(chain.begin() + offset, chain.begin() + size);
+            else
+                chain.clear();
+
+            post([this, tree, uuid, serial, level, reserved, chain = std::move(chain)]() mutable {
+                _finish_reload(*tree, uuid, serial, level, reserved, std::move(chain));
+            });
+        }));
+}
+
+void ImageResidency::_finish_reload(ResourceTree& tree, UUID uuid, uint32_t serial, uint32_t level, size_t reserved, std::vector<unsigned char>&& chain)
+{
+    m_reserved -= reserved;
+    m_stats.loading--;
+
+    auto iter = m_entries.find(uuid);
+    if (iter == m_entries.end() || iter->second.serial != serial) return;
+
+    auto& entry   = iter->second;
+    entry.loading = false;
+    if (chain.empty())
+    {
+        // The source is gone or no longer decodes, the image stays at what it has
+        printf("Failed to reload image %llx, keeping %u levels\n", (unsigned long long)uuid, entry.levels - entry.first_level);
+        entry.reload = nullptr;
+        return;
+    }
+
+    entry.chain.swap(chain);
+    entry.first_level = level;
+    _apply(tree, uuid, entry);
+
+    m_stats.reloads++;
+    m_stats.reloaded_bytes += reserved;
+}
+
+void ImageResidency::clear()
+{
+    m_entries.clear();
+
+    // In flight reloads still settle loading and m_reserved when they come back
+    Stats stats;
+    stats.budget  = m_stats.budget;
+    stats.loading = m_stats.loading;
+    m_stats       = stats;
+}
+
+void ImageResidency::_wait()
+{
+    for (auto& task : m_tasks)
+        task.wait();
+    m_tasks.clear();
+}
+
+} // namespace acre
@@ -2,6 +2,10 @@
 
 #include <acre/utils/math/math.h>
 #include <acre/render/renderer.h>
+#include <utils/bounds.h>
+#include <model/wrapper/geometryExt.h>
+
+#include <cfloat>
 
 SceneMgr::SceneMgr(acre::Scene* scene) :
     m_scene(scene), m_tree(new acre::ResourceTree(scene))
@@ -45,10 +49,193 @@ void SceneMgr::_init_point_light()
 
 void SceneMgr::clear_scene()
 {
+    m_generation++;
+    m_load_stats = LoadStats();
+    m_assets.clear();
+    m_images.clear();
+    m_residency.clear();
+    m_animation_set->animations.clear();
+
     m_tree->clear();
     m_scene->clear();
     _init_camera();
     _init_direction_light();
+    for (const auto& lut : m_luts)
+        _init_lut(lut);
+}
+
+void SceneMgr::install_lut(brdfLut::Kind kind, acre::UUID uuid, std::vector<uint16_t>* rgba, uint32_t size)
+{
+    std::erase_if(m_luts, [kind](const GeneratedLut& lut) { return lut.kind == kind; });
+    _init_lut(m_luts.emplace_back(GeneratedLut{kind, uuid, size, rgba}));
+}
+
+void SceneMgr::_init_lut(const GeneratedLut& lut)
+{
+    auto imageR = m_tree->get<acre::ImageID>(lut.uuid);
+    auto image  = imageR->ptr<acre::ImageID>();
+
+    image->data    = lut.rgba->data();
+    image->format  = acre::Image::Format::RGBA16_FLOAT;
+    image->name    = brdfLut::name(lut.kind);
+    image->width   = lut.size;
+    image->height  = lut.size;
+    image->mipmaps = 1;
+
+    auto node      = m_tree->get<acre::TextureID>(lut.uuid);
+    auto texture   = node->ptr<acre::TextureID>();
+    texture->image = imageR->id<acre::ImageID>();
+
+    switch (lut.kind)
+    {
+        case brdfLut::Kind::lGGX: set_lut_ggx(node->id<acre::TextureID>()); break;
+        case brdfLut::Kind::lCharlie: set_lut_charlie(node->id<acre::TextureID>()); break;
+        case brdfLut::Kind::lSheenAlbedoScale: set_lut_sheen_albedo_scale(node->id<acre::TextureID>()); break;
+    }
+}
+
+acre::AssetID SceneMgr::create_asset(const std::string& name)
+{
+    auto id      = m_next_asset++;
+    auto asset   = std::make_unique<SceneAsset>();
+    asset->name  = name;
+    m_assets[id] = std::move(asset);
+    return id;
+}
+
+SceneAsset* SceneMgr::asset(acre::AssetID asset)
+{
+    auto iter = m_assets.find(asset);
+    return iter != m_assets.end() ? iter->second.get() : nullptr;
+}
+
+acre::Resource* SceneMgr::find_image(uint64_t key)
+{
+    auto entry = m_images.find(key);
+    auto node  = entry ? find<acre::ImageID>(entry->uuid) : nullptr;
+
+    // The node left the tree since, the content gets decoded again
+    if (entry && !node) m_images.erase(key);
+
+    m_load_stats.image_lookups++;
+    if (node)
+    {
+        m_load_stats.image_hits++;
+        m_load_stats.image_bytes_saved += entry->bytes;
+    }
+    return node;
+}
+
+void SceneMgr::merge_box(const acre::math::box3* boxes, size_t count)
+{
+    auto merged = bounds::merge(boxes, count);
+    if (merged.m_mins.x > merged.m_maxs.x) return;
+
+    m_box |= merged;
+}
+
+static float boxDistance(const acre::math::box3& box, const acre::math::float3& point)
+{
+    float distance2 = 0.0f;
+    for (int c = 0; c < 3; ++c)
+    {
+        auto d = std::max(std::max(box.m_mins[c] - point[c], point[c] - box.m_maxs[c]), 0.0f);
+        distance2 += d * d;
+    }
+
+    return sqrtf(distance2);
+}
+
+// pixels per world unit at distance 1 (perspective) or anywhere (orthonormal)
+static float projectionScale(const acre::Camera* camera, float viewport_height)
+{
+    if (camera->type == acre::Camera::ProjectType::tPerspective)
+    {
+        const auto& p = std::get<acre::Camera::Perspective>(camera->projection);
+        return viewport_height / (2.0f * tanf(acre::math::radians(p.fov) * 0.5f));
+    }
+
+    const auto& o = std::get<acre::Camera::Orthonormal>(camera->projection);
+    return viewport_height / std::max(o.topPlane - o.bottomPlane, 1e-6f);
+}
+
+void SceneMgr::select_lods(float viewport_height, float threshold)
+{
+    auto camera      = m_camera->ptr<acre::CameraID>();
+    auto perspective = camera->type == acre::Camera::ProjectType::tPerspective;
+    auto projection  = projectionScale(camera, viewport_height);
+
+    for (auto& [uuid, node] : geometry_list())
+    {
+        auto ext = node->ext<acre::GeometryExt>();
+        if (!ext || ext->lods.size() < 2) continue;
+
+        // The closest instance decides, the index buffer is shared by all of them
+        float factor = 0.0f;
+        for (const auto& instance : ext->instances)
+        {
+            auto distance = perspective ? boxDistance(instance.box, camera->position) : 1.0f;
+            factor        = distance > 0.0f ? std::max(factor, instance.scale * projection / distance) : FLT_MAX;
+        }
+
+        uint32_t level = 0;
+        for (uint32_t i = 1; i < ext->lods.size(); ++i)
+        {
+            if (ext->lods[i].error * factor <= threshold) level = i;
+        }
+
+        if (level == ext->lod_level) continue;
+
+        ext->lod_level                       = level;
+        node->ptr<acre::GeometryID>()->index = ext->lods[level].index;
+        m_tree->updateLeaf(node.get());
+    }
+}
+
+void SceneMgr::update_residency(float viewport_height)
+{
+    auto camera      = m_camera->ptr<acre::CameraID>();
+    auto perspective = camera->type == acre::Camera::ProjectType::tPerspective;
+    auto projection  = projectionScale(camera, viewport_height);
+
+    m_residency.begin_frame();
+    for (auto& [uuid, node] : entity_list())
+    {
+        // Screen extent of the closest instance, the textures are assumed to span the geometry once.
+        // Geometry without instances (no loader data) keeps its textures at full resolution
+        float           pixels   = FLT_MAX;
+        acre::Resource* material = nullptr;
+        for (auto ref : node->references())
+        {
+            if (ref->is<acre::MaterialID>()) material = ref;
+            if (!ref->is<acre::GeometryID>()) continue;
+
+            auto ext = ref->ext<acre::GeometryExt>();
+            if (!ext || ext->instances.empty()) continue;
+
+            pixels = 0.0f;
+            for (const auto& instance : ext->instances)
+            {
+                auto size     = instance.box.m_maxs - instance.box.m_mins;
+                auto extent   = sqrtf(size.x * size.x + size.y * size.y + size.z * size.z) * projection;
+                auto distance = perspective ? boxDistance(instance.box, camera->position) : 1.0f;
+                pixels        = distance > 0.0f ? std::max(pixels, extent / distance) : FLT_MAX;
+            }
+        }
+        if (!material) continue;
+
+        for (auto texture : material->references())
+        {
+            if (!texture->is<acre::TextureID>()) continue;
+
+            for (auto image : texture->references())
+            {
+                if (image->is<acre::ImageID>()) m_residency.use(image->uuid(), pixels);
+            }
+        }
+    }
+
+    m_residency.update(*m_tree, [this](std::function<void()>&& task) { post(std::move(task)); });
 }
 
 // void SceneMgr::clearHDR()
@@ -68,6 +255,26 @@ void SceneMgr::clear_scene()
 //     m_extTextureList.resize(0);
 // }
 
+void SceneMgr::post(std::function<void()>&& task)
+{
+    std::lock_guard<std::mutex> lock(m_pending_mutex);
+    m_pending.emplace_back(std::move(task));
+}
+
+bool SceneMgr::process_pending()
+{
+    std::vector<std::function<void()>> tasks;
+    {
+        std::lock_guard<std::mutex> lock(m_pending_mutex);
+        tasks.swap(m_pending);
+    }
+
+    for (auto& task : tasks)
+        task();
+
+    return !tasks.empty();
+}
+
 void SceneMgr::create(acre::component::DrawPtr draw)
 {
     m_scene->create_component_draw(draw);
@@ -115,18 +322,18 @@ void SceneMgr::update(acre::Resource* node)
     m_tree->updateLeaf(node);
 }
 
-void SceneMgr::set_main_camera(uint32_t uuid)
+void SceneMgr::set_main_camera(acre::UUID uuid)
 {
     m_camera = find<acre::CameraID>(uuid);
 }
 
-void SceneMgr::highlight_geometry(uint32_t uuid)
+void SceneMgr::highlight_geometry(acre::UUID uuid)
 {
     auto node = find<acre::GeometryID>(uuid);
     m_scene->highlight(node->id<acre::GeometryID>());
 }
 
-void SceneMgr::highlight_material(uint32_t uuid)
+void SceneMgr::highlight_material(acre::UUID uuid)
 {
     auto node = find<acre::MaterialID>(uuid);
     m_scene->highlight(node->id<acre::MaterialID>());
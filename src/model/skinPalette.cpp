@@ -0,0 +1,99 @@
+#include <model/skinPalette.h>
+
+#include <cstring>
+
+namespace acre
+{
+
+uint32_t SkinPalette::add_skin(const int* joint_nodes, uint32_t count, const unsigned char* inverse_bind_data)
+{
+    SkinRange range;
+    range.first_joint = uint32_t(joints.size());
+    range.joint_count = count;
+
+    joints.reserve(joints.size() + count);
+    inverse_binds.reserve(inverse_binds.size() + count);
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        joints.push_back(joint_nodes[i] >= 0 ? uint32_t(joint_nodes[i]) : kNone);
+
+        auto& inverse_bind = inverse_binds.emplace_back(math::float4x4::identity());
+        if (inverse_bind_data) memcpy(inverse_bind.m_data, inverse_bind_data + size_t(i) * sizeof(math::float4x4), sizeof(math::float4x4));
+    }
+
+    skins.push_back(range);
+    return uint32_t(skins.size() - 1);
+}
+
+void SkinPalette::add_instance(uint32_t node, uint32_t skin)
+{
+    const auto& range = skins[skin];
+
+    Instance instance;
+    instance.node         = node;
+    instance.skin         = skin;
+    instance.first_matrix = uint32_t(matrices.size());
+    matrices.resize(matrices.size() + range.joint_count, math::float4x4::identity());
+
+    for (uint32_t joint = 0; joint < range.joint_count; ++joint)
+    {
+        auto joint_node = joints[range.first_joint + joint];
+        if (joint_node == kNone) continue;
+
+        if (joint_node >= m_owners.size()) m_owners.resize(joint_node + 1);
+        if (m_owners[joint_node].instance != kNone) continue;
+
+        m_owners[joint_node] = {uint32_t(instances.size()), joint};
+        skinned_joints.push_back(joint_node);
+    }
+
+    instances.push_back(instance);
+}
+
+void SkinPalette::clear()
+{
+    skins.clear();
+    joints.clear();
+    inverse_binds.clear();
+    instances.clear();
+    matrices.clear();
+    skinned_joints.clear();
+    m_owners.clear();
+}
+
+void SkinPalette::update(const TransformHierarchy& hierarchy)
+{
+    auto world = [&](uint32_t node) {
+        auto slot = node == kNone ? TransformHierarchy::kNoSlot : hierarchy.slot(node);
+        return slot == TransformHierarchy::kNoSlot ? math::float4x4::identity() : math::affineToHomogeneous(hierarchy.worlds[slot]);
+    };
+
+    for (auto& instance : instances)
+    {
+        instance.inverse_node_matrix = math::inverse(world(instance.node));
+
+        const auto& range = skins[instance.skin];
+        for (uint32_t joint = 0; joint < range.joint_count; ++joint)
+        {
+            auto entry = range.first_joint + joint;
+
+            matrices[instance.first_matrix + joint] = inverse_binds[entry] * world(joints[entry]) * instance.inverse_node_matrix;
+        }
+    }
+}
+
+bool SkinPalette::write_skin(uint32_t joint_node, Skin& skin) const
+{
+    if (joint_node >= m_owners.size() || m_owners[joint_node].instance == kNone) return false;
+
+    const auto& owner    = m_owners[joint_node];
+    const auto& instance = instances[owner.instance];
+
+    skin.inverse_bind_matrix = inverse_binds[skins[instance.skin].first_joint + owner.joint];
+    skin.inverse_node_matrix = instance.inverse_node_matrix;
+    skin.joint_matrix        = matrices[instance.first_matrix + owner.joint];
+    skin.joint_affine        = math::homogeneousToAffine(skin.joint_matrix);
+    return true;
+}
+
+} // namespace acre
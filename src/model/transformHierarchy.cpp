@@ -0,0 +1,114 @@
+#include <model/transformHierarchy.h>
+
+namespace acre
+{
+
+void TransformHierarchy::build(const std::vector<int>& node_parents)
+{
+    clear();
+
+    auto count = uint32_t(node_parents.size());
+
+    std::vector<std::vector<uint32_t>> children(count);
+    for (uint32_t node = 0; node < count; ++node)
+    {
+        auto parent = node_parents[node];
+        if (parent >= 0 && uint32_t(parent) < count && uint32_t(parent) != node) children[parent].push_back(node);
+    }
+
+    node_slots.assign(count, kNoSlot);
+    nodes.reserve(count);
+    parents.reserve(count);
+
+    // Breadth first from the roots, nodes the walk did not reach sit in a cycle and start a new
+    // walk as a root so every node ends up with a slot
+    auto walk = [&](uint32_t root) {
+        node_slots[root] = uint32_t(nodes.size());
+        nodes.push_back(root);
+        parents.push_back(kNoSlot);
+
+        for (auto slot = node_slots[root]; slot < nodes.size(); ++slot)
+        {
+            for (auto child : children[nodes[slot]])
+            {
+                if (node_slots[child] != kNoSlot) continue;
+
+                node_slots[child] = uint32_t(nodes.size());
+                nodes.push_back(child);
+                parents.push_back(slot);
+            }
+        }
+    };
+
+    for (uint32_t node = 0; node < count; ++node)
+    {
+        auto parent = node_parents[node];
+        if (parent < 0 || uint32_t(parent) >= count || uint32_t(parent) == node) walk(node);
+    }
+    for (uint32_t node = 0; node < count; ++node)
+    {
+        if (node_slots[node] == kNoSlot) walk(node);
+    }
+
+    translations.assign(count, math::float3(0.0f, 0.0f, 0.0f));
+    rotations.assign(count, math::quat());
+    scales.assign(count, math::float3(1.0f, 1.0f, 1.0f));
+    fixed.assign(count, 0);
+    fixed_locals.assign(count, math::affine3::identity());
+    worlds.assign(count, math::affine3::identity());
+    m_dirty.assign(count, 0);
+}
+
+void TransformHierarchy::clear()
+{
+    nodes.clear();
+    parents.clear();
+    node_slots.clear();
+    translations.clear();
+    rotations.clear();
+    scales.clear();
+    fixed.clear();
+    fixed_locals.clear();
+    worlds.clear();
+    m_dirty.clear();
+}
+
+math::affine3 TransformHierarchy::local(uint32_t slot) const
+{
+    if (fixed[slot]) return fixed_locals[slot];
+
+    // Row vectors: scale, then rotate, then translate
+    auto local = math::scaling(scales[slot]);
+    local *= rotations[slot].toAffine();
+    local *= math::translation(translations[slot]);
+    return local;
+}
+
+void TransformHierarchy::update()
+{
+    for (uint32_t slot = 0; slot < size(); ++slot)
+    {
+        auto parent  = parents[slot];
+        worlds[slot] = parent == kNoSlot ? local(slot) : local(slot) * worlds[parent];
+    }
+}
+
+void TransformHierarchy::update_dirty(std::vector<uint32_t>& changed)
+{
+    changed.clear();
+    for (uint32_t slot = 0; slot < size(); ++slot)
+    {
+        auto parent = parents[slot];
+        if (parent != kNoSlot && m_dirty[parent]) m_dirty[slot] = 1;
+        if (!m_dirty[slot]) continue;
+
+        worlds[slot] = parent == kNoSlot ? local(slot) : local(slot) * worlds[parent];
+        changed.push_back(slot);
+    }
+
+    // Cleared after the pass, children read their parent's flag above
+    for (auto slot : changed)
+        m_dirty[slot] = 0;
+}
+
+} // namespace acre
@@ -0,0 +1,184 @@
+#include <utils/benchmark.h>
+#include <utils/bounds.h>
+#include <utils/brdfLut.h>
+#include <utils/dequantize.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+namespace benchmark
+{
+
+template <typename Func>
+static double measure(Func&& func, int repeat = 5)
+{
+    double best = 1e30;
+    for (int i = 0; i < repeat; ++i)
+    {
+        auto start = std::chrono::high_resolution_clock::now();
+        func();
+        auto end = std::chrono::high_resolution_clock::now();
+        best     = std::min(best, std::chrono::duration<double, std::milli>(end - start).count());
+    }
+
+    return best;
+}
+
+// The loop the loader used before the kernel, kept as the baseline
+static auto scalarBounds(const unsigned char* data, size_t count, size_t stride)
+{
+    auto box = acre::math::box3::empty();
+    for (size_t i = 0; i < count; ++i)
+    {
+        acre::math::float3 pos;
+        memcpy(&pos, data + i * stride, sizeof(pos));
+        box |= pos;
+    }
+
+    return box;
+}
+
+static auto formatLine(const char* name, size_t count, double ms, double baseline)
+{
+    char line[128];
+    snprintf(line, sizeof(line), "%-18s %8.2f ms  %7.2f Mvert/s  x%.2f\n", name, ms, count / (ms * 1000.0), baseline / ms);
+    return std::string(line);
+}
+
+std::string bounds(size_t count)
+{
+    std::mt19937                          rng(7);
+    std::uniform_real_distribution<float> dist(-1000.0f, 1000.0f);
+
+    // Interleaved position + normal + uv (32 bytes) next to a tightly packed float3 stream
+    std::vector<unsigned char> interleaved(count * 32);
+    std::vector<float>         packed(count * 3);
+    std::vector<uint16_t>      quantized(count * 4);
+    for (size_t i = 0; i < count; ++i)
+    {
+        float pos[3] = {dist(rng), dist(rng), dist(rng)};
+        memcpy(interleaved.data() + i * 32, pos, sizeof(pos));
+        memcpy(packed.data() + i * 3, pos, sizeof(pos));
+        for (int c = 0; c < 3; ++c)
+            quantized[i * 4 + c] = uint16_t((pos[c] + 1000.0f) * 32.0f);
+    }
+
+    acre::math::box3 sink[6];
+
+    auto packedScalar  = measure([&] { sink[0] = scalarBounds((const unsigned char*)packed.data(), count, 12); });
+    auto packedKernel  = measure([&] { sink[1] = bounds::compute(packed.data(), count, 12); });
+    auto stridedScalar = measure([&] { sink[2] = scalarBounds(interleaved.data(), count, 32); });
+    auto stridedKernel = measure([&] { sink[3] = bounds::compute((const float*)interleaved.data(), count, 32); });
+
+    bounds::PositionStream stream;
+    stream.data       = quantized.data();
+    stream.count      = count;
+    stream.stride     = 8;
+    stream.type       = bounds::ComponentType::cUShort;
+    stream.normalized = false;
+    auto quantKernel  = measure([&] { sink[4] = bounds::compute(stream); });
+
+    std::string report = "bounds over " + std::to_string(count) + " vertices\n";
+    report += formatLine("float3 scalar", count, packedScalar, packedScalar);
+    report += formatLine("float3 kernel", count, packedKernel, packedScalar);
+    report += formatLine("stride32 scalar", count, stridedScalar, stridedScalar);
+    report += formatLine("stride32 kernel", count, stridedKernel, stridedScalar);
+    report += formatLine("ushort4 kernel", count, quantKernel, stridedScalar);
+
+    auto same = [](const acre::math::box3& a, const acre::math::box3& b) {
+        for (int c = 0; c < 3; ++c)
+            if (a.m_mins[c] != b.m_mins[c] || a.m_maxs[c] != b.m_maxs[c]) return false;
+        return true;
+    };
+    if (!same(sink[0], sink[1]) || !same(sink[2], sink[3])) report += "mismatch against scalar bounds!\n";
+
+    return report;
+}
+
+std::string attributes(size_t count)
+{
+    std::mt19937                            rng(7);
+    std::uniform_int_distribution<uint32_t> dist(0, 255);
+
+    // One stream per common KHR_mesh_quantization layout, padded to 4 byte strides as the spec asks
+    struct Stream
+    {
+        const char*                name;
+        size_t                     stride;
+        size_t                     components;
+        dequantize::Component      type;
+        bool                       normalized;
+        std::vector<unsigned char> data;
+    };
+    Stream streams[] = {
+        {"position ushort3", 8, 3, dequantize::Component::cUShort, false},
+        {"position short3n", 8, 3, dequantize::Component::cShort, true},
+        {"normal byte3n", 4, 3, dequantize::Component::cByte, true},
+        {"tangent short4n", 8, 4, dequantize::Component::cShort, true},
+        {"uv ushort2n", 4, 2, dequantize::Component::cUShort, true},
+        {"weights ubyte4n", 4, 4, dequantize::Component::cUByte, true},
+    };
+
+    std::vector<float> expanded(count * 4);
+    std::vector<float> reference(count * 4);
+    std::vector<char>  copied(count * 8);
+
+    std::string report = "attribute expansion over " + std::to_string(count) + " vertices\n";
+    bool        mismatch = false;
+    for (auto& stream : streams)
+    {
+        stream.data.resize(count * stream.stride);
+        for (auto& byte : stream.data)
+            byte = (unsigned char)dist(rng);
+
+        auto scalar = measure([&] { dequantize::to_float_scalar(reference.data(), stream.data.data(), count, stream.stride, stream.components, stream.type, stream.normalized); });
+        auto kernel = measure([&] { dequantize::to_float(expanded.data(), stream.data.data(), count, stream.stride, stream.components, stream.type, stream.normalized); });
+        auto keep   = measure([&] { memcpy(copied.data(), stream.data.data(), count * stream.stride); });
+
+        report += std::string(stream.name) + "\n";
+        report += formatLine("  scalar", count, scalar, scalar);
+        report += formatLine("  kernel", count, kernel, scalar);
+        report += formatLine("  keep (copy)", count, keep, scalar);
+
+        mismatch |= memcmp(expanded.data(), reference.data(), count * stream.components * sizeof(float)) != 0;
+    }
+    if (mismatch) report += "mismatch against scalar expansion!\n";
+
+    return report;
+}
+
+std::string luts(size_t samples)
+{
+    brdfLut::Options options;
+    options.samples = uint32_t(samples);
+
+    auto texels = size_t(options.size) * options.size;
+
+    std::string report = "LUT generation " + std::to_string(options.size) + "x" + std::to_string(options.size) + ", " + std::to_string(samples) + " samples per texel\n";
+    bool        mismatch = false;
+    for (auto kind : {brdfLut::Kind::lGGX, brdfLut::Kind::lCharlie, brdfLut::Kind::lSheenAlbedoScale})
+    {
+        std::vector<uint16_t> reference, generated;
+
+        auto scalar = measure([&] { brdfLut::generate_scalar(kind, options, reference); }, 1);
+        auto kernel = measure([&] { brdfLut::generate(kind, options, generated); }, 3);
+
+        // Mtexel/s in the Mvert/s column
+        report += std::string(brdfLut::name(kind)) + "\n";
+        report += formatLine("  scalar", texels, scalar, scalar);
+        report += formatLine("  kernel", texels, kernel, scalar);
+
+        // SSE sums in another order, allow a few half ulps
+        for (size_t i = 0; i < reference.size(); ++i)
+            mismatch |= std::abs(int(reference[i]) - int(generated[i])) > 4;
+    }
+    if (mismatch) report += "mismatch against scalar generation!\n";
+
+    return report;
+}
+
+} // namespace benchmark
@@ -0,0 +1,307 @@
+#include <utils/bounds.h>
+
+#include <algorithm>
+#include <cfloat>
+#include <cstring>
+#include <limits>
+#include <type_traits>
+
+#if defined(__AVX__)
+#    define BOUNDS_USE_AVX  1
+#    define BOUNDS_USE_SSE  1
+#elif defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)
+#    define BOUNDS_USE_AVX  0
+#    define BOUNDS_USE_SSE  1
+#else
+#    define BOUNDS_USE_AVX  0
+#    define BOUNDS_USE_SSE  0
+#endif
+
+#if BOUNDS_USE_SSE
+#    include <immintrin.h>
+#endif
+
+namespace bounds
+{
+
+struct MinMax
+{
+    float mins[3] = {FLT_MAX, FLT_MAX, FLT_MAX};
+    float maxs[3] = {-FLT_MAX, -FLT_MAX, -FLT_MAX};
+
+    void add(const float* p)
+    {
+        for (int c = 0; c < 3; ++c)
+        {
+            mins[c] = std::min(mins[c], p[c]);
+            maxs[c] = std::max(maxs[c], p[c]);
+        }
+    }
+
+    auto to_box() const
+    {
+        auto box = acre::math::box3::empty();
+        if (mins[0] > maxs[0]) return box;
+
+        box.m_mins = {mins[0], mins[1], mins[2]};
+        box.m_maxs = {maxs[0], maxs[1], maxs[2]};
+        return box;
+    }
+};
+
+static auto readFloat3(const unsigned char* addr)
+{
+    float p[3];
+    memcpy(p, addr, sizeof(p));
+    return acre::math::float3(p[0], p[1], p[2]);
+}
+
+#if BOUNDS_USE_SSE
+
+// Tightly packed float3: 4 vertices are 12 floats are 3 registers, float j belongs to component j % 3
+static void packedSSE(const float* data, size_t count, MinMax& result)
+{
+    auto mn0 = _mm_set1_ps(FLT_MAX), mn1 = mn0, mn2 = mn0;
+    auto mx0 = _mm_set1_ps(-FLT_MAX), mx1 = mx0, mx2 = mx0;
+
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        auto p = data + i * 3;
+        auto a = _mm_loadu_ps(p);
+        auto b = _mm_loadu_ps(p + 4);
+        auto c = _mm_loadu_ps(p + 8);
+        mn0    = _mm_min_ps(mn0, a);
+        mx0    = _mm_max_ps(mx0, a);
+        mn1    = _mm_min_ps(mn1, b);
+        mx1    = _mm_max_ps(mx1, b);
+        mn2    = _mm_min_ps(mn2, c);
+        mx2    = _mm_max_ps(mx2, c);
+    }
+
+    float mins[12], maxs[12];
+    _mm_storeu_ps(mins, mn0);
+    _mm_storeu_ps(mins + 4, mn1);
+    _mm_storeu_ps(mins + 8, mn2);
+    _mm_storeu_ps(maxs, mx0);
+    _mm_storeu_ps(maxs + 4, mx1);
+    _mm_storeu_ps(maxs + 8, mx2);
+    for (int j = 0; j < 12; ++j)
+    {
+        result.mins[j % 3] = std::min(result.mins[j % 3], mins[j]);
+        result.maxs[j % 3] = std::max(result.maxs[j % 3], maxs[j]);
+    }
+
+    for (; i < count; ++i)
+        result.add(data + i * 3);
+}
+
+// Any stride: one unaligned load per vertex, the 4th lane is ignored. The last vertex is read
+// with scalar code since a buffer view only has to cover 12 bytes of it
+static void stridedSSE(const unsigned char* data, size_t count, size_t stride, MinMax& result)
+{
+    if (count == 0) return;
+
+    auto mn0 = _mm_set1_ps(FLT_MAX), mn1 = mn0;
+    auto mx0 = _mm_set1_ps(-FLT_MAX), mx1 = mx0;
+
+    size_t i    = 0;
+    size_t last = count - 1;
+    for (; i + 2 <= last; i += 2)
+    {
+        auto a = _mm_loadu_ps((const float*)(data + i * stride));
+        auto b = _mm_loadu_ps((const float*)(data + (i + 1) * stride));
+        mn0    = _mm_min_ps(mn0, a);
+        mx0    = _mm_max_ps(mx0, a);
+        mn1    = _mm_min_ps(mn1, b);
+        mx1    = _mm_max_ps(mx1, b);
+    }
+
+    float mins[4], maxs[4];
+    _mm_storeu_ps(mins, _mm_min_ps(mn0, mn1));
+    _mm_storeu_ps(maxs, _mm_max_ps(mx0, mx1));
+    if (i > 0)
+    {
+        for (int c = 0; c < 3; ++c)
+        {
+            result.mins[c] = std::min(result.mins[c], mins[c]);
+            result.maxs[c] = std::max(result.maxs[c], maxs[c]);
+        }
+    }
+
+    for (; i < count; ++i)
+    {
+        float p[3];
+        memcpy(p, data + i * stride, sizeof(p));
+        result.add(p);
+    }
+}
+
+#endif
+
+#if BOUNDS_USE_AVX
+
+// Same idea as packedSSE with 8 vertices (24 floats) per iteration
+static void packedAVX(const float* data, size_t count, MinMax& result)
+{
+    auto mn0 = _mm256_set1_ps(FLT_MAX), mn1 = mn0, mn2 = mn0;
+    auto mx0 = _mm256_set1_ps(-FLT_MAX), mx1 = mx0, mx2 = mx0;
+
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        auto p = data + i * 3;
+        auto a = _mm256_loadu_ps(p);
+        auto b = _mm256_loadu_ps(p + 8);
+        auto c = _mm256_loadu_ps(p + 16);
+        mn0    = _mm256_min_ps(mn0, a);
+        mx0    = _mm256_max_ps(mx0, a);
+        mn1    = _mm256_min_ps(mn1, b);
+        mx1    = _mm256_max_ps(mx1, b);
+        mn2    = _mm256_min_ps(mn2, c);
+        mx2    = _mm256_max_ps(mx2, c);
+    }
+
+    float mins[24], maxs[24];
+    _mm256_storeu_ps(mins, mn0);
+    _mm256_storeu_ps(mins + 8, mn1);
+    _mm256_storeu_ps(mins + 16, mn2);
+    _mm256_storeu_ps(maxs, mx0);
+    _mm256_storeu_ps(maxs + 8, mx1);
+    _mm256_storeu_ps(maxs + 16, mx2);
+    for (int j = 0; j < 24; ++j)
+    {
+        result.mins[j % 3] = std::min(result.mins[j % 3], mins[j]);
+        result.maxs[j % 3] = std::max(result.maxs[j % 3], maxs[j]);
+    }
+
+    packedSSE(data + i * 3, count - i, result);
+}
+
+#endif
+
+static void computeFloat(const unsigned char* data, size_t count, size_t stride, MinMax& result)
+{
+#if BOUNDS_USE_AVX
+    if (stride == 12) return packedAVX((const float*)data, count, result);
+#endif
+#if BOUNDS_USE_SSE
+    if (stride == 12) return packedSSE((const float*)data, count, result);
+    return stridedSSE(data, count, stride, result);
+#else
+    for (size_t i = 0; i < count; ++i)
+    {
+        float p[3];
+        memcpy(p, data + i * stride, sizeof(p));
+        result.add(p);
+    }
+#endif
+}
+
+// Quantized positions: min/max in the integer domain, (de)normalization is monotonic so it is
+// applied once to the result
+template <typename T>
+static void computeInteger(const unsigned char* data, size_t count, size_t stride, bool normalized, MinMax& result)
+{
+    if (count == 0) return;
+
+    T mins[3], maxs[3];
+    memcpy(mins, data, sizeof(mins));
+    memcpy(maxs, data, sizeof(maxs));
+    for (size_t i = 1; i < count; ++i)
+    {
+        T p[3];
+        memcpy(p, data + i * stride, sizeof(p));
+        for (int c = 0; c < 3; ++c)
+        {
+            mins[c] = std::min(mins[c], p[c]);
+            maxs[c] = std::max(maxs[c], p[c]);
+        }
+    }
+
+    auto scale = normalized ? 1.0f / float(std::numeric_limits<T>::max()) : 1.0f;
+    for (int c = 0; c < 3; ++c)
+    {
+        // signed normalized values clamp at -1 (glTF 3.11)
+        auto lo        = std::max(float(mins[c]) * scale, normalized && std::is_signed_v<T> ? -1.0f : -FLT_MAX);
+        auto hi        = std::max(float(maxs[c]) * scale, normalized && std::is_signed_v<T> ? -1.0f : -FLT_MAX);
+        result.mins[c] = std::min(result.mins[c], lo);
+        result.maxs[c] = std::max(result.maxs[c], hi);
+    }
+}
+
+acre::math::box3 compute(const PositionStream& stream)
+{
+    MinMax result;
+    if (!stream.data || stream.count == 0) return result.to_box();
+
+    auto data = static_cast<const unsigned char*>(stream.data);
+    switch (stream.type)
+    {
+        case ComponentType::cFloat: computeFloat(data, stream.count, stream.stride, result); break;
+        case ComponentType::cByte: computeInteger<int8_t>(data, stream.count, stream.stride, stream.normalized, result); break;
+        case ComponentType::cUByte: computeInteger<uint8_t>(data, stream.count, stream.stride, stream.normalized, result); break;
+        case ComponentType::cShort: computeInteger<int16_t>(data, stream.count, stream.stride, stream.normalized, result); break;
+        case ComponentType::cUShort: computeInteger<uint16_t>(data, stream.count, stream.stride, stream.normalized, result); break;
+    }
+
+    return result.to_box();
+}
+
+acre::math::box3 compute(const float* data, size_t count, size_t stride)
+{
+    PositionStream stream;
+    stream.data   = data;
+    stream.count  = count;
+    stream.stride = stride;
+    return compute(stream);
+}
+
+acre::math::box3 merge(const acre::math::box3* boxes, size_t count)
+{
+    MinMax result;
+    for (size_t i = 0; i < count; ++i)
+    {
+        const auto& box = boxes[i];
+        if (box.m_mins.x > box.m_maxs.x) continue; // empty
+
+        float mins[3] = {box.m_mins.x, box.m_mins.y, box.m_mins.z};
+        float maxs[3] = {box.m_maxs.x, box.m_maxs.y, box.m_maxs.z};
+        result.add(mins);
+        result.add(maxs);
+    }
+
+    return result.to_box();
+}
+
+acre::math::box3 transform(const acre::math::box3& box, const acre::math::affine3& affine)
+{
+    if (box.m_mins.x > box.m_maxs.x) return box;
+
+    // Note: row-vector convention, p' = p * linear + translation (matches box3 * affine3)
+    auto origin = affine.transformPoint(acre::math::float3(0.0f, 0.0f, 0.0f));
+    auto axisX  = affine.transformPoint(acre::math::float3(1.0f, 0.0f, 0.0f)) - origin;
+    auto axisY  = affine.transformPoint(acre::math::float3(0.0f, 1.0f, 0.0f)) - origin;
+    auto axisZ  = affine.transformPoint(acre::math::float3(0.0f, 0.0f, 1.0f)) - origin;
+
+    MinMax result;
+    float  lo[3] = {origin.x, origin.y, origin.z};
+    float  hi[3] = {origin.x, origin.y, origin.z};
+    for (int c = 0; c < 3; ++c)
+    {
+        const acre::math::float3* axes[3] = {&axisX, &axisY, &axisZ};
+        for (int k = 0; k < 3; ++k)
+        {
+            auto a = (*axes[k])[c] * box.m_mins[k];
+            auto b = (*axes[k])[c] * box.m_maxs[k];
+            lo[c] += std::min(a, b);
+            hi[c] += std::max(a, b);
+        }
+    }
+    result.add(lo);
+    result.add(hi);
+
+    return result.to_box();
+}
+
+} // namespace bounds
@@ -0,0 +1,394 @@
+#include <utils/brdfLut.h>
+#include <utils/half.h>
+#include <utils/workerPool.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+#ifdef _WIN32
+#    ifndef WIN32_LEAN_AND_MEAN
+#        define WIN32_LEAN_AND_MEAN
+#    endif
+#    ifndef NOMINMAX
+#        define NOMINMAX
+#    endif
+#    include <windows.h>
+#endif
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)
+#    define BRDFLUT_USE_SSE 1
+#    include <immintrin.h>
+#else
+#    define BRDFLUT_USE_SSE 0
+#endif
+
+namespace brdfLut
+{
+
+static constexpr float kPi = 3.14159265358979323846f;
+
+// Sheen lobes get narrow enough below this to need more samples than a table is worth
+static constexpr float kMinSheenRoughness = 0.07f;
+
+static constexpr char     g_magic[8] = {'A', 'C', 'R', 'E', 'L', 'U', 'T', '1'};
+static constexpr uint32_t g_version  = 1;
+
+struct CacheHeader
+{
+    char     magic[8];
+    uint32_t version;
+    uint32_t kind;
+    uint32_t size;
+    uint32_t samples;
+};
+
+static float radicalInverse(uint32_t bits)
+{
+    bits = (bits << 16u) | (bits >> 16u);
+    bits = ((bits & 0x55555555u) << 1u) | ((bits & 0xAAAAAAAAu) >> 1u);
+    bits = ((bits & 0x33333333u) << 2u) | ((bits & 0xCCCCCCCCu) >> 2u);
+    bits = ((bits & 0x0F0F0F0Fu) << 4u) | ((bits & 0xF0F0F0F0u) >> 4u);
+    bits = ((bits & 0x00FF00FFu) << 8u) | ((bits & 0xFF00FF00u) >> 8u);
+    return float(bits) * 2.3283064365386963e-10f;
+}
+
+// GGX half vectors of one roughness in the tangent frame, structure of arrays padded to a multiple
+// of 4 with weight 0. V lies in the xz plane, so y never enters
+struct GGXSamples
+{
+    std::vector<float> hx, hz, weight;
+};
+
+static void ggxSamples(float alpha, uint32_t count, GGXSamples& samples)
+{
+    auto padded = (count + 3) & ~3u;
+    samples.hx.assign(padded, 0.0f);
+    samples.hz.assign(padded, 1.0f);
+    samples.weight.assign(padded, 0.0f);
+
+    auto alpha2 = alpha * alpha;
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        auto phi       = 2.0f * kPi * (float(i) + 0.5f) / count;
+        auto xi        = radicalInverse(i);
+        auto cos_theta = std::sqrt((1.0f - xi) / (1.0f + (alpha2 - 1.0f) * xi));
+        auto sin_theta = std::sqrt(std::max(0.0f, 1.0f - cos_theta * cos_theta));
+
+        samples.hx[i]     = sin_theta * std::cos(phi);
+        samples.hz[i]     = cos_theta;
+        samples.weight[i] = 1.0f;
+    }
+}
+
+// Split sum of one texel: L = reflect(-V, H), pdf(H) folded into VdotH / NdotH
+static void ggxTexelScalar(const GGXSamples& samples, float n_dot_v, float alpha2, float* out)
+{
+    auto vx = std::sqrt(1.0f - n_dot_v * n_dot_v);
+    auto gv = std::sqrt(n_dot_v * n_dot_v * (1.0f - alpha2) + alpha2);
+
+    float a = 0.0f, b = 0.0f;
+    for (size_t i = 0; i < samples.hx.size(); ++i)
+    {
+        auto v_dot_h = std::max(vx * samples.hx[i] + n_dot_v * samples.hz[i], 0.0f);
+        auto n_dot_l = 2.0f * v_dot_h * samples.hz[i] - n_dot_v;
+        if (n_dot_l <= 0.0f || samples.weight[i] == 0.0f) continue;
+
+        auto gl  = std::sqrt(n_dot_l * n_dot_l * (1.0f - alpha2) + alpha2);
+        auto vis = 0.5f / (n_dot_l * gv + n_dot_v * gl);
+        auto g   = vis * 4.0f * n_dot_l * v_dot_h / samples.hz[i];
+        auto m   = 1.0f - v_dot_h;
+        auto fc  = m * m * m * m * m;
+        a += (1.0f - fc) * g;
+        b += fc * g;
+    }
+    out[0] = a;
+    out[1] = b;
+}
+
+#if BRDFLUT_USE_SSE
+
+static void ggxTexelSSE(const GGXSamples& samples, float n_dot_v, float alpha2, float* out)
+{
+    auto nv     = _mm_set1_ps(n_dot_v);
+    auto vx     = _mm_set1_ps(std::sqrt(1.0f - n_dot_v * n_dot_v));
+    auto gv     = _mm_set1_ps(std::sqrt(n_dot_v * n_dot_v * (1.0f - alpha2) + alpha2));
+    auto a2     = _mm_set1_ps(alpha2);
+    auto one_a2 = _mm_set1_ps(1.0f - alpha2);
+    auto zero   = _mm_setzero_ps();
+    auto one    = _mm_set1_ps(1.0f);
+    auto two    = _mm_set1_ps(2.0f);
+
+    auto a = zero, b = zero;
+    for (size_t i = 0; i < samples.hx.size(); i += 4)
+    {
+        auto hx = _mm_loadu_ps(&samples.hx[i]);
+        auto hz = _mm_loadu_ps(&samples.hz[i]);
+
+        auto v_dot_h = _mm_max_ps(_mm_add_ps(_mm_mul_ps(vx, hx), _mm_mul_ps(nv, hz)), zero);
+        auto n_dot_l = _mm_sub_ps(_mm_mul_ps(_mm_mul_ps(two, v_dot_h), hz), nv);
+        auto valid   = _mm_and_ps(_mm_cmpgt_ps(n_dot_l, zero), _mm_cmpgt_ps(_mm_loadu_ps(&samples.weight[i]), zero));
+        n_dot_l      = _mm_max_ps(n_dot_l, zero);
+
+        auto gl  = _mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(_mm_mul_ps(n_dot_l, n_dot_l), one_a2), a2));
+        auto vis = _mm_div_ps(_mm_set1_ps(0.5f), _mm_add_ps(_mm_mul_ps(n_dot_l, gv), _mm_mul_ps(nv, gl)));
+        auto g   = _mm_div_ps(_mm_mul_ps(_mm_mul_ps(vis, _mm_set1_ps(4.0f)), _mm_mul_ps(n_dot_l, v_dot_h)), hz);
+        g        = _mm_and_ps(g, valid);
+
+        auto m  = _mm_sub_ps(one, v_dot_h);
+        auto m2 = _mm_mul_ps(m, m);
+        auto fc = _mm_mul_ps(_mm_mul_ps(m2, m2), m);
+        a       = _mm_add_ps(a, _mm_mul_ps(_mm_sub_ps(one, fc), g));
+        b       = _mm_add_ps(b, _mm_mul_ps(fc, g));
+    }
+
+    float la[4], lb[4];
+    _mm_storeu_ps(la, a);
+    _mm_storeu_ps(lb, b);
+    out[0] = (la[0] + la[1]) + (la[2] + la[3]);
+    out[1] = (lb[0] + lb[1]) + (lb[2] + lb[3]);
+}
+
+#endif
+
+// Uniform hemisphere directions, pdf 1 / 2pi
+struct HemisphereSamples
+{
+    std::vector<float> lx, ly, lz;
+};
+
+static HemisphereSamples hemisphereSamples(uint32_t count)
+{
+    HemisphereSamples samples;
+    samples.lx.resize(count);
+    samples.ly.resize(count);
+    samples.lz.resize(count);
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        auto phi       = 2.0f * kPi * (float(i) + 0.5f) / count;
+        auto cos_theta = radicalInverse(i);
+        auto sin_theta = std::sqrt(std::max(0.0f, 1.0f - cos_theta * cos_theta));
+        samples.lx[i]  = sin_theta * std::cos(phi);
+        samples.ly[i]  = sin_theta * std::sin(phi);
+        samples.lz[i]  = cos_theta;
+    }
+    return samples;
+}
+
+static float charlieD(float alpha, float n_dot_h)
+{
+    auto inv_r = 1.0f / alpha;
+    auto sin2h = std::max(1.0f - n_dot_h * n_dot_h, 0.0f);
+    return (2.0f + inv_r) * std::pow(sin2h, inv_r * 0.5f) / (2.0f * kPi);
+}
+
+static float ashikhminV(float n_dot_l, float n_dot_v)
+{
+    return 1.0f / (4.0f * (n_dot_l + n_dot_v - n_dot_l * n_dot_v));
+}
+
+// Sheen visibility of KHR_materials_sheen (Estevez and Kulla fit)
+static float sheenL(float x, float alpha)
+{
+    auto t = (1.0f - alpha) * (1.0f - alpha);
+    auto a = 21.5473f + (25.3245f - 21.5473f) * t;
+    auto b = 3.82987f + (3.32435f - 3.82987f) * t;
+    auto c = 0.19823f + (0.16801f - 0.19823f) * t;
+    auto d = -1.97760f + (-1.27393f + 1.97760f) * t;
+    auto e = -4.32054f + (-4.85967f + 4.32054f) * t;
+    return a / (1.0f + b * std::pow(x, c)) + d * x + e;
+}
+
+static float sheenLambda(float cos_theta, float alpha)
+{
+    if (std::abs(cos_theta) < 0.5f) return std::exp(sheenL(cos_theta, alpha));
+    return std::exp(2.0f * sheenL(0.5f, alpha) - sheenL(1.0f - cos_theta, alpha));
+}
+
+static float charlieV(float n_dot_l, float n_dot_v, float alpha)
+{
+    auto v = 1.0f / ((1.0f + sheenLambda(n_dot_v, alpha) + sheenLambda(n_dot_l, alpha)) * (4.0f * n_dot_v * n_dot_l));
+    return std::clamp(v, 0.0f, 1.0f);
+}
+
+static float sheenTexel(Kind kind, const HemisphereSamples& samples, float n_dot_v, float alpha)
+{
+    auto vx = std::sqrt(1.0f - n_dot_v * n_dot_v);
+
+    double sum = 0.0;
+    for (size_t i = 0; i < samples.lz.size(); ++i)
+    {
+        auto n_dot_l = samples.lz[i];
+        if (n_dot_l <= 0.0f) continue;
+
+        // H = normalize(V + L)
+        float h[3]   = {vx + samples.lx[i], samples.ly[i], n_dot_v + n_dot_l};
+        auto  length = std::sqrt(h[0] * h[0] + h[1] * h[1] + h[2] * h[2]);
+        auto  n_dot_h = length > 0.0f ? h[2] / length : 1.0f;
+
+        auto v = kind == Kind::lCharlie ? ashikhminV(n_dot_l, n_dot_v) : charlieV(n_dot_l, n_dot_v, alpha);
+        sum += charlieD(alpha, n_dot_h) * v * n_dot_l;
+    }
+    return float(sum * 2.0 * kPi / std::max<size_t>(samples.lz.size(), 1));
+}
+
+static void generateRow(Kind kind, const Options& options, uint32_t y, const HemisphereSamples& hemisphere, bool simd, float* row)
+{
+    auto roughness = (float(y) + 0.5f) / options.size;
+    if (kind == Kind::lGGX)
+    {
+        auto       alpha = roughness * roughness;
+        GGXSamples samples;
+        ggxSamples(alpha, options.samples, samples);
+
+        for (uint32_t x = 0; x < options.size; ++x)
+        {
+            auto  n_dot_v = (float(x) + 0.5f) / options.size;
+            float ab[2];
+#if BRDFLUT_USE_SSE
+            if (simd)
+                ggxTexelSSE(samples, n_dot_v, alpha * alpha, ab);
+            else
+#endif
+                ggxTexelScalar(samples, n_dot_v, alpha * alpha, ab);
+
+            auto* out = row + x * 4;
+            out[0]    = ab[0] / options.samples;
+            out[1]    = ab[1] / options.samples;
+            out[2]    = 0.0f;
+            out[3]    = 1.0f;
+        }
+        return;
+    }
+
+    // alpha_g = roughness^2 as in the sheen extension
+    auto sheen = std::max(roughness, kMinSheenRoughness);
+    auto alpha = sheen * sheen;
+    for (uint32_t x = 0; x < options.size; ++x)
+    {
+        auto n_dot_v = (float(x) + 0.5f) / options.size;
+        auto value   = sheenTexel(kind, hemisphere, n_dot_v, alpha);
+
+        auto* out = row + x * 4;
+        out[0] = out[1] = out[2] = value;
+        out[3]                   = 1.0f;
+    }
+}
+
+static void generateImpl(Kind kind, const Options& options, std::vector<uint16_t>& rgba, bool parallel)
+{
+    auto hemisphere = kind == Kind::lGGX ? HemisphereSamples() : hemisphereSamples(options.samples);
+
+    std::vector<float> values(size_t(options.size) * options.size * 4);
+    auto               row = [&](size_t y) { generateRow(kind, options, uint32_t(y), hemisphere, parallel, &values[y * options.size * 4]); };
+    if (parallel)
+    {
+        WorkerPool::global().parallel_for(options.size, row);
+    }
+    else
+    {
+        for (uint32_t y = 0; y < options.size; ++y)
+            row(y);
+    }
+
+    rgba.resize(values.size());
+    half::from_floats(values.data(), rgba.data(), values.size());
+}
+
+const char* name(Kind kind)
+{
+    switch (kind)
+    {
+        case Kind::lGGX: return "ggx";
+        case Kind::lCharlie: return "charlie";
+        case Kind::lSheenAlbedoScale: return "sheenAlbedoScaling";
+    }
+    return "unknown";
+}
+
+void generate(Kind kind, const Options& options, std::vector<uint16_t>& rgba)
+{
+    generateImpl(kind, options, rgba, true);
+}
+
+void generate_scalar(Kind kind, const Options& options, std::vector<uint16_t>& rgba)
+{
+    generateImpl(kind, options, rgba, false);
+}
+
+static std::filesystem::path executableDir()
+{
+    std::error_code error;
+#ifdef _WIN32
+    wchar_t path[MAX_PATH];
+    auto    length = GetModuleFileNameW(nullptr, path, MAX_PATH);
+    if (length > 0 && length < MAX_PATH) return std::filesystem::path(path).parent_path();
+#else
+    auto path = std::filesystem::read_symlink("/proc/self/exe", error);
+    if (!error) return path.parent_path();
+#endif
+    return std::filesystem::current_path(error);
+}
+
+std::string cache_path(Kind kind, const Options& options)
+{
+    char file[64];
+    snprintf(file, sizeof(file), "%s_%u_%u.acrelut", name(kind), options.size, options.samples);
+    return (executableDir() / "lut" / file).string();
+}
+
+bool read_cache(const std::string& fileName, Kind kind, const Options& options, std::vector<uint16_t>& rgba)
+{
+    std::ifstream file(fileName, std::ios::binary);
+    if (!file) return false;
+
+    CacheHeader head;
+    file.read(reinterpret_cast<char*>(&head), sizeof(head));
+
+    bool valid = file.good() && memcmp(head.magic, g_magic, sizeof(g_magic)) == 0 && head.version == g_version;
+    valid      = valid && head.kind == uint32_t(kind) && head.size == options.size && head.samples == options.samples;
+    if (!valid) return false;
+
+    rgba.resize(size_t(options.size) * options.size * 4);
+    file.read(reinterpret_cast<char*>(rgba.data()), rgba.size() * sizeof(uint16_t));
+    return file.gcount() == std::streamsize(rgba.size() * sizeof(uint16_t));
+}
+
+bool write_cache(const std::string& fileName, Kind kind, const Options& options, const std::vector<uint16_t>& rgba)
+{
+    std::error_code error;
+    std::filesystem::create_directories(std::filesystem::path(fileName).parent_path(), error);
+
+    CacheHeader head = {};
+    memcpy(head.magic, g_magic, sizeof(g_magic));
+    head.version = g_version;
+    head.kind    = uint32_t(kind);
+    head.size    = options.size;
+    head.samples = options.samples;
+
+    auto temporary = fileName + ".tmp";
+    {
+        std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+        file.write(reinterpret_cast<const char*>(&head), sizeof(head));
+        file.write(reinterpret_cast<const char*>(rgba.data()), rgba.size() * sizeof(uint16_t));
+        if (!file.good())
+        {
+            file.close();
+            std::filesystem::remove(temporary, error);
+            return false;
+        }
+    }
+
+    std::filesystem::rename(temporary, fileName, error);
+    if (error)
+    {
+        std::filesystem::remove(temporary, error);
+        return false;
+    }
+
+    return true;
+}
+
+} // namespace brdfLut
@@ -0,0 +1,201 @@
+#include <utils/dequantize.h>
+
+#include <algorithm>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)
+#    define DEQUANTIZE_USE_SSE 1
+#    include <immintrin.h>
+#else
+#    define DEQUANTIZE_USE_SSE 0
+#endif
+
+namespace dequantize
+{
+
+static auto isSigned(Component type)
+{
+    return type == Component::cByte || type == Component::cShort;
+}
+
+static float normalizeScale(Component type)
+{
+    switch (type)
+    {
+        case Component::cByte: return 1.0f / 127.0f;
+        case Component::cUByte: return 1.0f / 255.0f;
+        case Component::cShort: return 1.0f / 32767.0f;
+        default: return 1.0f / 65535.0f;
+    }
+}
+
+template <typename T>
+static void toFloatScalar(float* dst, const unsigned char* src, size_t count, size_t stride, size_t components, bool normalized, float scale)
+{
+    for (size_t i = 0; i < count; ++i)
+    {
+        T element[4];
+        memcpy(element, src + i * stride, components * sizeof(T));
+        for (size_t c = 0; c < components; ++c)
+        {
+            auto value              = float(element[c]);
+            dst[i * components + c] = normalized ? std::max(value * scale, -1.0f) : value;
+        }
+    }
+}
+
+void to_float_scalar(float* dst, const unsigned char* src, size_t count, size_t stride, size_t components, Component type, bool normalized)
+{
+    auto scale = normalizeScale(type);
+    switch (type)
+    {
+        case Component::cByte: toFloatScalar<int8_t>(dst, src, count, stride, components, normalized, scale); break;
+        case Component::cUByte: toFloatScalar<uint8_t>(dst, src, count, stride, components, normalized, scale); break;
+        case Component::cShort: toFloatScalar<int16_t>(dst, src, count, stride, components, normalized, scale); break;
+        case Component::cUShort: toFloatScalar<uint16_t>(dst, src, count, stride, components, normalized, scale); break;
+    }
+}
+
+#if DEQUANTIZE_USE_SSE
+
+// One element widened to four int32 lanes, lanes past the element hold whatever was loaded
+template <Component Type, size_t Bytes>
+static inline __m128i loadElement(const unsigned char* addr)
+{
+    __m128i value;
+    if constexpr (Bytes <= 4)
+    {
+        int32_t word = 0;
+        memcpy(&word, addr, Bytes);
+        value = _mm_cvtsi32_si128(word);
+    }
+    else
+    {
+        int64_t word = 0;
+        memcpy(&word, addr, Bytes);
+        value = _mm_loadl_epi64((const __m128i*)&word);
+    }
+
+    if constexpr (Type == Component::cByte)
+    {
+        value = _mm_srai_epi16(_mm_unpacklo_epi8(value, value), 8);
+        return _mm_srai_epi32(_mm_unpacklo_epi16(value, value), 16);
+    }
+    else if constexpr (Type == Component::cUByte)
+    {
+        value = _mm_unpacklo_epi8(value, _mm_setzero_si128());
+        return _mm_unpacklo_epi16(value, _mm_setzero_si128());
+    }
+    else if constexpr (Type == Component::cShort)
+    {
+        return _mm_srai_epi32(_mm_unpacklo_epi16(value, value), 16);
+    }
+    else
+    {
+        return _mm_unpacklo_epi16(value, _mm_setzero_si128());
+    }
+}
+
+// Four elements per iteration, packed into Components stores so nothing is written past dst.
+// Bytes is the load width, a power of two that may read into the padding of the element; the
+// last element has none guaranteed and is left to the scalar loop then. Returns the elements done
+template <size_t Components, Component Type, size_t Bytes>
+static size_t toFloatSSE(float* dst, const unsigned char* src, size_t count, size_t stride, bool normalized)
+{
+    constexpr auto element = Components * (Type == Component::cByte || Type == Component::cUByte ? 1 : 2);
+
+    auto scale = _mm_set1_ps(normalized ? normalizeScale(Type) : 1.0f);
+    auto lower = _mm_set1_ps(normalized && isSigned(Type) ? -1.0f : -3.0e38f);
+
+    auto blocks = (Bytes > element ? count - 1 : count) / 4;
+    for (size_t block = 0; block < blocks; ++block)
+    {
+        const auto* addr = src + block * 4 * stride;
+
+        __m128 v[4];
+        for (int k = 0; k < 4; ++k)
+            v[k] = _mm_max_ps(_mm_mul_ps(_mm_cvtepi32_ps(loadElement<Type, Bytes>(addr + k * stride)), scale), lower);
+
+        auto out = dst + block * 4 * Components;
+        if constexpr (Components == 4)
+        {
+            for (int k = 0; k < 4; ++k)
+                _mm_storeu_ps(out + k * 4, v[k]);
+        }
+        else if constexpr (Components == 3)
+        {
+            // x0 y0 z0 x1 | y1 z1 x2 y2 | z2 x3 y3 z3
+            auto t0 = _mm_shuffle_ps(v[0], v[1], _MM_SHUFFLE(0, 0, 2, 2));
+            auto t1 = _mm_shuffle_ps(v[2], v[3], _MM_SHUFFLE(0, 0, 2, 2));
+            _mm_storeu_ps(out + 0, _mm_shuffle_ps(v[0], t0, _MM_SHUFFLE(2, 0, 1, 0)));
+            _mm_storeu_ps(out + 4, _mm_shuffle_ps(v[1], v[2], _MM_SHUFFLE(1, 0, 2, 1)));
+            _mm_storeu_ps(out + 8, _mm_shuffle_ps(t1, v[3], _MM_SHUFFLE(2, 1, 2, 0)));
+        }
+        else if constexpr (Components == 2)
+        {
+            _mm_storeu_ps(out + 0, _mm_movelh_ps(v[0], v[1]));
+            _mm_storeu_ps(out + 4, _mm_movelh_ps(v[2], v[3]));
+        }
+        else
+        {
+            _mm_storeu_ps(out, _mm_movelh_ps(_mm_unpacklo_ps(v[0], v[1]), _mm_unpacklo_ps(v[2], v[3])));
+        }
+    }
+
+    return blocks * 4;
+}
+
+template <size_t Components, Component Type>
+static size_t toFloatSSE(float* dst, const unsigned char* src, size_t count, size_t stride, bool normalized)
+{
+    constexpr size_t element = Components * (Type == Component::cByte || Type == Component::cUByte ? 1 : 2);
+    constexpr size_t wide    = element <= 1 ? 1 : element <= 2 ? 2 : element <= 4 ? 4 : 8;
+
+    // Padded strides (as KHR_mesh_quantization requires) allow one power of two load per element
+    if (stride >= wide) return toFloatSSE<Components, Type, wide>(dst, src, count, stride, normalized);
+
+    return toFloatSSE<Components, Type, element>(dst, src, count, stride, normalized);
+}
+
+template <size_t Components>
+static size_t toFloatSSE(float* dst, const unsigned char* src, size_t count, size_t stride, Component type, bool normalized)
+{
+    switch (type)
+    {
+        case Component::cByte: return toFloatSSE<Components, Component::cByte>(dst, src, count, stride, normalized);
+        case Component::cUByte: return toFloatSSE<Components, Component::cUByte>(dst, src, count, stride, normalized);
+        case Component::cShort: return toFloatSSE<Components, Component::cShort>(dst, src, count, stride, normalized);
+        default: return toFloatSSE<Components, Component::cUShort>(dst, src, count, stride, normalized);
+    }
+}
+
+#endif
+
+void to_float(float* dst, const unsigned char* src, size_t count, size_t stride, size_t components, Component type, bool normalized)
+{
+    if (count == 0 || components == 0 || components > 4) return;
+
+    size_t done = 0;
+#if DEQUANTIZE_USE_SSE
+    switch (components)
+    {
+        case 1: done = toFloatSSE<1>(dst, src, count, stride, type, normalized); break;
+        case 2: done = toFloatSSE<2>(dst, src, count, stride, type, normalized); break;
+        case 3: done = toFloatSSE<3>(dst, src, count, stride, type, normalized); break;
+        default: done = toFloatSSE<4>(dst, src, count, stride, type, normalized); break;
+    }
+#endif
+
+    to_float_scalar(dst + done * components, src + done * stride, count - done, stride, components, type, normalized);
+}
+
+void widen_u8_u16(uint16_t* dst, const unsigned char* src, size_t count, size_t stride, size_t components)
+{
+    for (size_t i = 0; i < count; ++i)
+    {
+        for (size_t c = 0; c < components; ++c)
+            dst[i * components + c] = src[i * stride + c];
+    }
+}
+
+} // namespace dequantize
@@ -0,0 +1,433 @@
+#include <utils/envmap.h>
+#include <utils/half.h>
+#include <utils/hash.h>
+#include <utils/mipmap.h>
+#include <utils/workerPool.h>
+
+#include <algorithm>
+#include <cmath>
+
+namespace envmap
+{
+
+static constexpr float kPi = 3.14159265358979323846f;
+
+struct Vec3
+{
+    float x, y, z;
+};
+
+static inline Vec3 operator*(Vec3 v, float s) { return {v.x * s, v.y * s, v.z * s}; }
+static inline Vec3 operator+(Vec3 a, Vec3 b) { return {a.x + b.x, a.y + b.y, a.z + b.z}; }
+
+static inline Vec3 cross(Vec3 a, Vec3 b) { return {a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x}; }
+
+static inline Vec3 normalize(Vec3 v)
+{
+    auto length = std::sqrt(v.x * v.x + v.y * v.y + v.z * v.z);
+    return length > 0.0f ? v * (1.0f / length) : v;
+}
+
+// u, v in [-1, 1], v down, see acre::EnvironmentMap
+static Vec3 faceDirection(uint32_t face, float u, float v)
+{
+    switch (face)
+    {
+        case 0: return {1.0f, -v, -u};
+        case 1: return {-1.0f, -v, u};
+        case 2: return {u, 1.0f, v};
+        case 3: return {u, -1.0f, -v};
+        case 4: return {u, -v, 1.0f};
+        default: return {-u, -v, -1.0f};
+    }
+}
+
+// Inverse of faceDirection, u, v in [0, 1]
+static uint32_t directionFace(Vec3 d, float& u, float& v)
+{
+    auto ax = std::abs(d.x), ay = std::abs(d.y), az = std::abs(d.z);
+
+    uint32_t face;
+    float    s, t, major;
+    if (ax >= ay && ax >= az)
+    {
+        face  = d.x > 0.0f ? 0 : 1;
+        s     = d.x > 0.0f ? -d.z : d.z;
+        t     = -d.y;
+        major = ax;
+    }
+    else if (ay >= az)
+    {
+        face  = d.y > 0.0f ? 2 : 3;
+        s     = d.x;
+        t     = d.y > 0.0f ? d.z : -d.z;
+        major = ay;
+    }
+    else
+    {
+        face  = d.z > 0.0f ? 4 : 5;
+        s     = d.z > 0.0f ? d.x : -d.x;
+        t     = -d.y;
+        major = az;
+    }
+
+    u = 0.5f * (s / major + 1.0f);
+    v = 0.5f * (t / major + 1.0f);
+    return face;
+}
+
+// Bilinear lookup of rgba32f pixels at pixel coordinates (centers at + 0.5), wraps or clamps x
+static void bilinear(const float* pixels, uint32_t width, uint32_t height, float x, float y, bool wrap_x, float* out)
+{
+    x -= 0.5f;
+    y -= 0.5f;
+    auto x0 = int(std::floor(x)), y0 = int(std::floor(y));
+    auto fx = x - float(x0), fy = y - float(y0);
+
+    auto column = [&](int i) {
+        if (wrap_x) return uint32_t(((i % int(width)) + int(width)) % int(width));
+        return uint32_t(std::clamp(i, 0, int(width) - 1));
+    };
+    auto row = [&](int j) { return uint32_t(std::clamp(j, 0, int(height) - 1)); };
+
+    const float* p00 = pixels + (size_t(row(y0)) * width + column(x0)) * 4;
+    const float* p10 = pixels + (size_t(row(y0)) * width + column(x0 + 1)) * 4;
+    const float* p01 = pixels + (size_t(row(y0 + 1)) * width + column(x0)) * 4;
+    const float* p11 = pixels + (size_t(row(y0 + 1)) * width + column(x0 + 1)) * 4;
+    for (int c = 0; c < 4; ++c)
+    {
+        auto top    = p00[c] + (p10[c] - p00[c]) * fx;
+        auto bottom = p01[c] + (p11[c] - p01[c]) * fx;
+        out[c]      = top + (bottom - top) * fy;
+    }
+}
+
+static void sampleEquirect(const float* rgba, uint32_t width, uint32_t height, Vec3 d, float* out)
+{
+    auto u = 0.5f + std::atan2(d.z, d.x) / (2.0f * kPi);
+    auto v = std::acos(std::clamp(d.y, -1.0f, 1.0f)) / kPi;
+    bilinear(rgba, width, height, u * width, v * height, true, out);
+}
+
+// Radiance cube with a box filtered mip chain per face
+struct Cube
+{
+    uint32_t            size   = 0;
+    uint32_t            levels = 0;
+    std::vector<float>  faces[6];
+    std::vector<size_t> offsets; // of each level in a face chain, in pixels
+
+    const float* level(uint32_t face, uint32_t level) const { return faces[face].data() + offsets[level] * 4; }
+
+    void sample(Vec3 d, float lod, float* out) const
+    {
+        float u, v;
+        auto  face = directionFace(d, u, v);
+
+        lod     = std::clamp(lod, 0.0f, float(levels - 1));
+        auto l0 = uint32_t(lod);
+        auto l1 = std::min(l0 + 1, levels - 1);
+        auto t  = lod - float(l0);
+
+        auto s0 = std::max(1u, size >> l0);
+        bilinear(level(face, l0), s0, s0, u * s0, v * s0, false, out);
+        if (t <= 0.0f || l1 == l0) return;
+
+        float upper[4];
+        auto  s1 = std::max(1u, size >> l1);
+        bilinear(level(face, l1), s1, s1, u * s1, v * s1, false, upper);
+        for (int c = 0; c < 4; ++c)
+            out[c] += (upper[c] - out[c]) * t;
+    }
+};
+
+// Face texels in parallel, func(face, x, y, direction, u, v) per texel, u, v in [-1, 1]
+template <typename Func>
+static void forTexels(uint32_t size, Func&& func)
+{
+    WorkerPool::global().parallel_for(size_t(6) * size, [&](size_t item) {
+        auto face = uint32_t(item / size);
+        auto y    = uint32_t(item % size);
+        for (uint32_t x = 0; x < size; ++x)
+        {
+            auto u = (float(x) + 0.5f) / size * 2.0f - 1.0f;
+            auto v = (float(y) + 0.5f) / size * 2.0f - 1.0f;
+            func(face, x, y, normalize(faceDirection(face, u, v)), u, v);
+        }
+    });
+}
+
+static Cube toCube(const float* rgba, uint32_t width, uint32_t height, uint32_t size)
+{
+    Cube cube;
+    cube.size = size;
+
+    // Equirect pixels per face texel, supersampled so large sources do not alias
+    auto taps = std::clamp(uint32_t(std::ceil(float(width) / 4.0f / size)), 1u, 4u);
+
+    std::vector<float> base[6];
+    for (auto& face : base)
+        face.resize(size_t(size) * size * 4);
+
+    WorkerPool::global().parallel_for(size_t(6) * size, [&](size_t item) {
+        auto face = uint32_t(item / size);
+        auto y    = uint32_t(item % size);
+        for (uint32_t x = 0; x < size; ++x)
+        {
+            float sum[4] = {};
+            for (uint32_t j = 0; j < taps; ++j)
+            {
+                for (uint32_t i = 0; i < taps; ++i)
+                {
+                    auto  u = (float(x) + (i + 0.5f) / taps) / size * 2.0f - 1.0f;
+                    auto  v = (float(y) + (j + 0.5f) / taps) / size * 2.0f - 1.0f;
+                    float value[4];
+                    sampleEquirect(rgba, width, height, normalize(faceDirection(face, u, v)), value);
+                    for (int c = 0; c < 4; ++c)
+                        sum[c] += value[c];
+                }
+            }
+
+            auto* out = &base[face][(size_t(y) * size + x) * 4];
+            for (int c = 0; c < 4; ++c)
+                out[c] = sum[c] / float(taps * taps);
+        }
+    });
+
+    mipmap::Options options;
+    options.filter = mipmap::Filter::fBox;
+    for (uint32_t face = 0; face < 6; ++face)
+        cube.levels = mipmap::build_rgba32f(base[face].data(), size, size, options, cube.faces[face]);
+    mipmap::chain_pixels(size, size, cube.levels, &cube.offsets);
+    return cube;
+}
+
+static float radicalInverse(uint32_t bits)
+{
+    bits = (bits << 16u) | (bits >> 16u);
+    bits = ((bits & 0x55555555u) << 1u) | ((bits & 0xAAAAAAAAu) >> 1u);
+    bits = ((bits & 0x33333333u) << 2u) | ((bits & 0xCCCCCCCCu) >> 2u);
+    bits = ((bits & 0x0F0F0F0Fu) << 4u) | ((bits & 0xF0F0F0F0u) >> 4u);
+    bits = ((bits & 0x00FF00FFu) << 8u) | ((bits & 0xFF00FF00u) >> 8u);
+    return float(bits) * 2.3283064365386963e-10f;
+}
+
+// Reflected direction in the tangent frame of the normal (N = V = R), its NdotL weight and the
+// source mip level covering its solid angle
+struct GGXSample
+{
+    Vec3  direction;
+    float weight;
+    float lod;
+};
+
+static std::vector<GGXSample> ggxSamples(float roughness, uint32_t count, uint32_t source_size)
+{
+    auto alpha  = roughness * roughness;
+    auto alpha2 = alpha * alpha;
+    auto texel  = 4.0f * kPi / (6.0f * source_size * source_size);
+
+    std::vector<GGXSample> samples;
+    samples.reserve(count);
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        auto xi_x = (float(i) + 0.5f) / count;
+        auto xi_y = radicalInverse(i);
+
+        auto phi       = 2.0f * kPi * xi_x;
+        auto cos_theta = std::sqrt((1.0f - xi_y) / (1.0f + (alpha2 - 1.0f) * xi_y));
+        auto sin_theta = std::sqrt(std::max(0.0f, 1.0f - cos_theta * cos_theta));
+
+        Vec3 h = {sin_theta * std::cos(phi), sin_theta * std::sin(phi), cos_theta};
+        Vec3 l = {2.0f * cos_theta * h.x, 2.0f * cos_theta * h.y, 2.0f * cos_theta * h.z - 1.0f};
+        if (l.z <= 0.0f) continue;
+
+        // pdf of L is D * NdotH / (4 VdotH) = D / 4 with N = V
+        auto denom = (alpha2 - 1.0f) * cos_theta * cos_theta + 1.0f;
+        auto d     = alpha2 / (kPi * denom * denom);
+        auto solid = 1.0f / (count * d * 0.25f + 1e-6f);
+        auto lod   = std::max(0.0f, 0.5f * std::log2(solid / texel) + 1.0f);
+        samples.push_back({l, l.z, lod});
+    }
+    return samples;
+}
+
+static void prefilter(const Cube& cube, const Options& options, std::vector<float>& specular, const acre::EnvironmentMap& environment)
+{
+    // Roughness 0 is the radiance itself
+    for (uint32_t face = 0; face < 6; ++face)
+    {
+        const auto* src = cube.level(face, 0);
+        std::copy(src, src + environment.face_texels(0) * 4, specular.begin() + environment.specular_offset(0, face));
+    }
+
+    for (uint32_t level = 1; level < environment.levels; ++level)
+    {
+        auto size    = std::max(1u, environment.face_size >> level);
+        auto samples = ggxSamples(float(level) / float(environment.levels - 1), options.samples, cube.size);
+
+        forTexels(size, [&](uint32_t face, uint32_t x, uint32_t y, Vec3 n, float, float) {
+            auto up        = std::abs(n.z) < 0.999f ? Vec3{0.0f, 0.0f, 1.0f} : Vec3{1.0f, 0.0f, 0.0f};
+            auto tangent   = normalize(cross(up, n));
+            auto bitangent = cross(n, tangent);
+
+            float sum[4] = {}, total = 0.0f;
+            for (const auto& sample : samples)
+            {
+                auto  l = tangent * sample.direction.x + bitangent * sample.direction.y + n * sample.direction.z;
+                float value[4];
+                cube.sample(l, sample.lod, value);
+                for (int c = 0; c < 4; ++c)
+                    sum[c] += value[c] * sample.weight;
+                total += sample.weight;
+            }
+
+            auto* out = &specular[environment.specular_offset(level, face) + (size_t(y) * size + x) * 4];
+            for (int c = 0; c < 4; ++c)
+                out[c] = total > 0.0f ? sum[c] / total : 0.0f;
+        });
+    }
+}
+
+// Projection on the 9 SH basis functions over a small cube level, convolved with the cosine lobe
+static void irradianceSH(const Cube& cube, float sh[9][3])
+{
+    uint32_t level = 0;
+    while (level + 1 < cube.levels && (cube.size >> level) > 64)
+        ++level;
+    auto size = std::max(1u, cube.size >> level);
+
+    // One accumulator per face row, summed afterwards
+    std::vector<double> rows(size_t(6) * size * 28, 0.0);
+    WorkerPool::global().parallel_for(size_t(6) * size, [&](size_t item) {
+        auto  face   = uint32_t(item / size);
+        auto  y      = uint32_t(item % size);
+        auto* acc    = &rows[item * 28];
+        auto* pixels = cube.level(face, level);
+        for (uint32_t x = 0; x < size; ++x)
+        {
+            auto u = (float(x) + 0.5f) / size * 2.0f - 1.0f;
+            auto v = (float(y) + 0.5f) / size * 2.0f - 1.0f;
+            auto d = normalize(faceDirection(face, u, v));
+
+            // Solid angle of the texel, up to the constant (2 / size)^2 that the normalization drops
+            auto weight = 1.0 / std::pow(1.0 + u * u + v * v, 1.5);
+
+            double basis[9] = {
+                0.282095,
+                0.488603 * d.y,
+                0.488603 * d.z,
+                0.488603 * d.x,
+                1.092548 * d.x * d.y,
+                1.092548 * d.y * d.z,
+                0.315392 * (3.0 * d.z * d.z - 1.0),
+                1.092548 * d.x * d.z,
+                0.546274 * (d.x * d.x - d.y * d.y),
+            };
+
+            const auto* pixel = pixels + (size_t(y) * size + x) * 4;
+            for (int i = 0; i < 9; ++i)
+            {
+                for (int c = 0; c < 3; ++c)
+                    acc[i * 3 + c] += pixel[c] * basis[i] * weight;
+            }
+            acc[27] += weight;
+        }
+    });
+
+    double sum[28] = {};
+    for (size_t item = 0; item < size_t(6) * size; ++item)
+    {
+        for (int i = 0; i < 28; ++i)
+            sum[i] += rows[item * 28 + i];
+    }
+
+    // Cosine lobe per band: pi, 2pi / 3, pi / 4
+    const double band[9] = {kPi, 2.0 * kPi / 3.0, 2.0 * kPi / 3.0, 2.0 * kPi / 3.0, kPi / 4.0, kPi / 4.0, kPi / 4.0, kPi / 4.0, kPi / 4.0};
+    auto         scale   = sum[27] > 0.0 ? 4.0 * kPi / sum[27] : 0.0;
+    for (int i = 0; i < 9; ++i)
+    {
+        for (int c = 0; c < 3; ++c)
+            sh[i][c] = float(sum[i * 3 + c] * scale * band[i]);
+    }
+}
+
+static void buildCDF(const float* rgba, uint32_t width, uint32_t height, const Options& options, acre::EnvironmentMap& environment)
+{
+    auto factor = std::max(1u, (width + options.cdf_width - 1) / std::max(1u, options.cdf_width));
+    auto cdf_w  = (width + factor - 1) / factor;
+    auto cdf_h  = (height + factor - 1) / factor;
+
+    environment.cdf_width  = cdf_w;
+    environment.cdf_height = cdf_h;
+    environment.conditional_cdf.assign(size_t(cdf_h) * (cdf_w + 1), 0.0f);
+    environment.marginal_cdf.assign(cdf_h + 1, 0.0f);
+
+    std::vector<float> row_integrals(cdf_h, 0.0f);
+    WorkerPool::global().parallel_for(cdf_h, [&](size_t y) {
+        auto  sin_theta = std::sin(kPi * (float(y) + 0.5f) / cdf_h);
+        auto* cdf       = &environment.conditional_cdf[y * (cdf_w + 1)];
+        for (uint32_t x = 0; x < cdf_w; ++x)
+        {
+            // Box average of the cell, edge cells cover fewer pixels
+            double   luminance = 0.0;
+            uint32_t count     = 0;
+            for (auto sy = uint32_t(y) * factor; sy < std::min(height, uint32_t(y + 1) * factor); ++sy)
+            {
+                for (auto sx = x * factor; sx < std::min(width, (x + 1) * factor); ++sx)
+                {
+                    const auto* p = rgba + (size_t(sy) * width + sx) * 4;
+                    luminance += 0.2126 * p[0] + 0.7152 * p[1] + 0.0722 * p[2];
+                    ++count;
+                }
+            }
+            auto value = count ? float(std::max(0.0, luminance / count)) * sin_theta : 0.0f;
+            cdf[x + 1] = cdf[x] + value / cdf_w;
+        }
+
+        row_integrals[y] = cdf[cdf_w];
+        for (uint32_t x = 1; x <= cdf_w; ++x)
+            cdf[x] = row_integrals[y] > 0.0f ? cdf[x] / row_integrals[y] : float(x) / cdf_w;
+    });
+
+    auto& marginal = environment.marginal_cdf;
+    for (uint32_t y = 0; y < cdf_h; ++y)
+        marginal[y + 1] = marginal[y] + row_integrals[y] / cdf_h;
+
+    environment.integral = marginal[cdf_h];
+    for (uint32_t y = 1; y <= cdf_h; ++y)
+        marginal[y] = environment.integral > 0.0f ? marginal[y] / environment.integral : float(y) / cdf_h;
+}
+
+uint64_t options_key(const Options& options)
+{
+    uint64_t key = 0;
+    key          = hash_combine(key, options.face_size);
+    key          = hash_combine(key, options.levels);
+    key          = hash_combine(key, options.samples);
+    return hash_combine(key, options.cdf_width);
+}
+
+void build(const float* rgba, uint32_t width, uint32_t height, const Options& options, acre::EnvironmentMap& environment)
+{
+    // Power of two faces, none finer than the equirect
+    uint32_t size = 1;
+    while (size * 2 <= std::min(options.face_size, std::max(1u, width / 4)))
+        size *= 2;
+
+    environment.face_size = size;
+    environment.levels    = std::clamp(options.levels, 1u, mipmap::level_count(size, size));
+
+    auto cube = toCube(rgba, width, height, size);
+
+    std::vector<float> specular(environment.specular_offset(environment.levels, 0));
+    prefilter(cube, options, specular, environment);
+
+    environment.specular.resize(specular.size());
+    half::from_floats(specular.data(), environment.specular.data(), specular.size());
+
+    irradianceSH(cube, environment.sh);
+    buildCDF(rgba, width, height, options, environment);
+}
+
+} // namespace envmap
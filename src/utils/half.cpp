@@ -0,0 +1,85 @@
+#include <utils/half.h>
+
+#if defined(__F16C__) || defined(__AVX2__)
+#    define HALF_USE_F16C 1
+#    define HALF_USE_SSE  1
+#elif defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)
+#    define HALF_USE_F16C 0
+#    define HALF_USE_SSE  1
+#else
+#    define HALF_USE_F16C 0
+#    define HALF_USE_SSE  0
+#endif
+
+#if HALF_USE_SSE
+#    include <immintrin.h>
+#endif
+
+namespace half
+{
+
+#if HALF_USE_SSE && !HALF_USE_F16C
+
+// Four floats to halves in the low 16 bits of each lane, round to nearest even: normals round on the
+// integer bits, denormals through a float add that lands the value in the low mantissa bits
+static inline __m128i convertSSE2(__m128 value)
+{
+    const auto f16_max      = _mm_set1_epi32((127 + 16) << 23);
+    const auto f32_inf      = _mm_set1_epi32(255 << 23);
+    const auto min_normal   = _mm_set1_epi32(113 << 23);
+    const auto denorm_magic = _mm_set1_epi32(((127 - 15) + (23 - 10) + 1) << 23);
+    const auto rebias       = _mm_set1_epi32((uint32_t(15 - 127) << 23) + 0xfff);
+    const auto one          = _mm_set1_epi32(1);
+
+    auto bits = _mm_castps_si128(value);
+    auto sign = _mm_and_si128(bits, _mm_set1_epi32(int(0x80000000u)));
+    auto abs  = _mm_xor_si128(bits, sign);
+
+    auto is_inf_nan = _mm_cmpgt_epi32(abs, _mm_sub_epi32(f16_max, one));
+    auto is_nan     = _mm_cmpgt_epi32(abs, f32_inf);
+    auto inf_nan    = _mm_or_si128(_mm_set1_epi32(0x7c00), _mm_and_si128(is_nan, _mm_set1_epi32(0x200)));
+
+    auto is_denorm = _mm_cmpgt_epi32(min_normal, abs);
+    auto denorm    = _mm_sub_epi32(_mm_castps_si128(_mm_add_ps(_mm_castsi128_ps(abs), _mm_castsi128_ps(denorm_magic))), denorm_magic);
+
+    auto odd    = _mm_and_si128(_mm_srli_epi32(abs, 13), one);
+    auto normal = _mm_srli_epi32(_mm_add_epi32(_mm_add_epi32(abs, rebias), odd), 13);
+
+    auto finite = _mm_or_si128(_mm_and_si128(is_denorm, denorm), _mm_andnot_si128(is_denorm, normal));
+    auto result = _mm_or_si128(_mm_and_si128(is_inf_nan, inf_nan), _mm_andnot_si128(is_inf_nan, finite));
+    return _mm_or_si128(result, _mm_srli_epi32(sign, 16));
+}
+
+// Sign extends the halves so the signed saturating pack keeps them as they are
+static inline __m128i packHalves(__m128i lo, __m128i hi)
+{
+    lo = _mm_srai_epi32(_mm_slli_epi32(lo, 16), 16);
+    hi = _mm_srai_epi32(_mm_slli_epi32(hi, 16), 16);
+    return _mm_packs_epi32(lo, hi);
+}
+
+#endif
+
+void from_floats(const float* src, uint16_t* dst, size_t count)
+{
+    size_t i = 0;
+#if HALF_USE_F16C
+    for (; i + 8 <= count; i += 8)
+    {
+        auto lo = _mm_cvtps_ph(_mm_loadu_ps(src + i), _MM_FROUND_TO_NEAREST_INT);
+        auto hi = _mm_cvtps_ph(_mm_loadu_ps(src + i + 4), _MM_FROUND_TO_NEAREST_INT);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_unpacklo_epi64(lo, hi));
+    }
+#elif HALF_USE_SSE
+    for (; i + 8 <= count; i += 8)
+    {
+        auto lo = convertSSE2(_mm_loadu_ps(src + i));
+        auto hi = convertSSE2(_mm_loadu_ps(src + i + 4));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), packHalves(lo, hi));
+    }
+#endif
+    for (; i < count; ++i)
+        dst[i] = from_float(src[i]);
+}
+
+} // namespace half
@@ -0,0 +1,99 @@
+#include <utils/hash.h>
+
+#include <cstring>
+
+static constexpr uint64_t g_prime1 = 0x9E3779B185EBCA87ull;
+static constexpr uint64_t g_prime2 = 0xC2B2AE3D27D4EB4Full;
+static constexpr uint64_t g_prime3 = 0x165667B19E3779F9ull;
+static constexpr uint64_t g_prime4 = 0x85EBCA77C2B2AE63ull;
+static constexpr uint64_t g_prime5 = 0x27D4EB2F165667C5ull;
+
+static inline uint64_t rotl(uint64_t x, int r)
+{
+    return (x << r) | (x >> (64 - r));
+}
+
+static inline uint64_t read64(const unsigned char* p)
+{
+    uint64_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static inline uint32_t read32(const unsigned char* p)
+{
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static inline uint64_t round(uint64_t acc, uint64_t input)
+{
+    acc += input * g_prime2;
+    acc = rotl(acc, 31);
+    return acc * g_prime1;
+}
+
+static inline uint64_t mergeRound(uint64_t acc, uint64_t value)
+{
+    acc ^= round(0, value);
+    return acc * g_prime1 + g_prime4;
+}
+
+uint64_t hash64(const void* data, size_t size, uint64_t seed)
+{
+    auto p   = static_cast<const unsigned char*>(data);
+    auto end = p + size;
+
+    uint64_t h;
+    if (size >= 32)
+    {
+        uint64_t v1 = seed + g_prime1 + g_prime2;
+        uint64_t v2 = seed + g_prime2;
+        uint64_t v3 = seed;
+        uint64_t v4 = seed - g_prime1;
+        for (; p + 32 <= end; p += 32)
+        {
+            v1 = round(v1, read64(p));
+            v2 = round(v2, read64(p + 8));
+            v3 = round(v3, read64(p + 16));
+            v4 = round(v4, read64(p + 24));
+        }
+
+        h = rotl(v1, 1) + rotl(v2, 7) + rotl(v3, 12) + rotl(v4, 18);
+        h = mergeRound(h, v1);
+        h = mergeRound(h, v2);
+        h = mergeRound(h, v3);
+        h = mergeRound(h, v4);
+    }
+    else
+    {
+        h = seed + g_prime5;
+    }
+
+    h += uint64_t(size);
+
+    for (; p + 8 <= end; p += 8)
+    {
+        h ^= round(0, read64(p));
+        h = rotl(h, 27) * g_prime1 + g_prime4;
+    }
+    if (p + 4 <= end)
+    {
+        h ^= uint64_t(read32(p)) * g_prime1;
+        h = rotl(h, 23) * g_prime2 + g_prime3;
+        p += 4;
+    }
+    for (; p < end; ++p)
+    {
+        h ^= (*p) * g_prime5;
+        h = rotl(h, 11) * g_prime1;
+    }
+
+    h ^= h >> 33;
+    h *= g_prime2;
+    h ^= h >> 29;
+    h *= g_prime3;
+    h ^= h >> 32;
+    return h;
+}
@@ -0,0 +1,205 @@
+#include <utils/ktx2.h>
+#include <utils/workerPool.h>
+
+#ifdef USE_KTX2
+#    include <basisu_transcoder.h>
+#endif
+
+#include <algorithm>
+#include <cstring>
+#include <mutex>
+
+namespace ktx2
+{
+
+static const unsigned char kIdentifier[12] = {0xab, 'K', 'T', 'X', ' ', '2', '0', 0xbb, '\r', '\n', 0x1a, '\n'};
+
+static constexpr size_t   kHeaderSize      = 80;
+static constexpr uint32_t kModelETC1S      = 163;
+static constexpr uint32_t kModelUASTC      = 166;
+static constexpr uint32_t kTransferSRGB    = 2;
+static constexpr uint32_t kSupercompNone   = 0;
+static constexpr uint32_t kChannelAlpha    = 15; // ETC1S
+static constexpr uint32_t kChannelRGBA     = 3;  // UASTC
+static constexpr uint32_t kChannelRRRG     = 5;  // UASTC
+static constexpr uint32_t kChannelRG       = 6;  // UASTC
+static constexpr uint32_t kFormatBC1Begin  = 131; // VK_FORMAT_BC1_RGB_UNORM_BLOCK .. VK_FORMAT_BC1_RGBA_SRGB_BLOCK
+static constexpr uint32_t kFormatBC1End    = 134;
+static constexpr uint32_t kFormatBC3Unorm  = 137;
+static constexpr uint32_t kFormatBC3SRGB   = 138;
+static constexpr uint32_t kFormatBC5Unorm  = 141;
+static constexpr uint32_t kFormatBC7Unorm  = 145;
+static constexpr uint32_t kFormatBC7SRGB   = 146;
+
+template <typename T>
+static auto readValue(const unsigned char* bytes, size_t offset)
+{
+    T value;
+    memcpy(&value, bytes + offset, sizeof(T));
+    return value;
+}
+
+static bool toFormat(uint32_t vk_format, Format& format, bool& srgb)
+{
+    if (vk_format >= kFormatBC1Begin && vk_format <= kFormatBC1End)
+    {
+        format = Format::fBC1_RGB;
+        srgb   = vk_format == 132 || vk_format == 134;
+        return true;
+    }
+
+    switch (vk_format)
+    {
+        case kFormatBC3Unorm: format = Format::fBC3_RGBA; srgb = false; return true;
+        case kFormatBC3SRGB: format = Format::fBC3_RGBA; srgb = true; return true;
+        case kFormatBC5Unorm: format = Format::fBC5_RG; srgb = false; return true;
+        case kFormatBC7Unorm: format = Format::fBC7_RGBA; srgb = false; return true;
+        case kFormatBC7SRGB: format = Format::fBC7_RGBA; srgb = true; return true;
+        default: return false;
+    }
+}
+
+bool is_ktx2(const unsigned char* bytes, size_t size)
+{
+    return size >= kHeaderSize && memcmp(bytes, kIdentifier, sizeof(kIdentifier)) == 0;
+}
+
+bool read(const unsigned char* bytes, size_t size, Texture& texture)
+{
+    if (!is_ktx2(bytes, size)) return false;
+
+    texture.data             = bytes;
+    texture.size             = size;
+    texture.vk_format        = readValue<uint32_t>(bytes, 12);
+    texture.width            = readValue<uint32_t>(bytes, 20);
+    texture.height           = readValue<uint32_t>(bytes, 24);
+    texture.supercompression = readValue<uint32_t>(bytes, 44);
+
+    auto depth       = readValue<uint32_t>(bytes, 28);
+    auto layer_count = readValue<uint32_t>(bytes, 32);
+    auto face_count  = readValue<uint32_t>(bytes, 36);
+    auto level_count = std::max(readValue<uint32_t>(bytes, 40), 1u);
+    if (!texture.width || !texture.height || depth > 1 || layer_count > 1 || face_count != 1) return false;
+    if (kHeaderSize + size_t(level_count) * sizeof(Level) > size) return false;
+
+    texture.levels.resize(level_count);
+    for (uint32_t i = 0; i < level_count; ++i)
+    {
+        auto& level = texture.levels[i];
+        memcpy(&level, bytes + kHeaderSize + i * sizeof(Level), sizeof(Level));
+        if (level.offset + level.size > size) return false;
+    }
+
+    // Basic data format descriptor: color model, transfer function and the channel of each sample
+    auto dfd_offset = readValue<uint32_t>(bytes, 48);
+    auto dfd_size   = readValue<uint32_t>(bytes, 52);
+    if (dfd_size < 28 || uint64_t(dfd_offset) + dfd_size > size) return true;
+
+    auto dfd            = bytes + dfd_offset;
+    auto block_size     = readValue<uint16_t>(dfd, 10);
+    texture.color_model = dfd[12];
+    texture.srgb        = dfd[14] == kTransferSRGB;
+
+    auto sample_count = std::min<size_t>(block_size >= 24 ? (block_size - 24) / 16 : 0, (dfd_size - 28) / 16);
+    for (size_t i = 0; i < sample_count; ++i)
+    {
+        auto channel = dfd[28 + i * 16 + 3] & 0xf;
+        if (texture.color_model == kModelETC1S && channel == kChannelAlpha) texture.has_alpha = true;
+        if (texture.color_model == kModelUASTC && (channel == kChannelRGBA || channel == kChannelRRRG || channel == kChannelRG)) texture.has_alpha = true;
+    }
+
+    return true;
+}
+
+Format choose_format(const Texture& texture, bool normal_map)
+{
+    if (normal_map) return Format::fBC5_RG;
+    if (texture.color_model == kModelUASTC) return Format::fBC7_RGBA;
+
+    return texture.has_alpha ? Format::fBC3_RGBA : Format::fBC1_RGB;
+}
+
+size_t level_size(Format format, uint32_t width, uint32_t height)
+{
+    auto blocks = size_t((width + 3) / 4) * ((height + 3) / 4);
+    return format == Format::fBC1_RGB ? blocks * 8 : blocks * 16;
+}
+
+static void allocateLevels(const Texture& texture, Image& image)
+{
+    size_t size = 0;
+    image.level_offsets.resize(texture.levels.size());
+    for (size_t i = 0; i < texture.levels.size(); ++i)
+    {
+        image.level_offsets[i] = size;
+        size += level_size(image.format, std::max(texture.width >> i, 1u), std::max(texture.height >> i, 1u));
+    }
+    image.data.resize(size);
+}
+
+#ifdef USE_KTX2
+static auto toTranscoderFormat(Format format)
+{
+    switch (format)
+    {
+        case Format::fBC1_RGB: return basist::transcoder_texture_format::cTFBC1_RGB;
+        case Format::fBC3_RGBA: return basist::transcoder_texture_format::cTFBC3_RGBA;
+        case Format::fBC5_RG: return basist::transcoder_texture_format::cTFBC5_RG;
+        default: return basist::transcoder_texture_format::cTFBC7_RGBA;
+    }
+}
+
+static bool transcodeBasis(const Texture& texture, Image& image)
+{
+    static std::once_flag init;
+    std::call_once(init, []() { basist::basisu_transcoder_init(); });
+
+    basist::ktx2_transcoder transcoder;
+    if (!transcoder.init(texture.data, uint32_t(texture.size)) || !transcoder.start_transcoding()) return false;
+
+    // One state per level keeps transcode_image_level thread safe
+    std::vector<char> failed(texture.levels.size(), 0);
+    WorkerPool::global().parallel_for(texture.levels.size(), [&](size_t level) {
+        basist::ktx2_transcoder_state state;
+
+        auto dst    = image.data.data() + image.level_offsets[level];
+        auto blocks = uint32_t(level_size(image.format, std::max(texture.width >> level, 1u), std::max(texture.height >> level, 1u)) /
+                               (image.format == Format::fBC1_RGB ? 8 : 16));
+        if (!transcoder.transcode_image_level(uint32_t(level), 0, 0, dst, blocks, toTranscoderFormat(image.format), 0, 0, 0, -1, -1, &state))
+            failed[level] = 1;
+    });
+
+    return std::find(failed.begin(), failed.end(), 1) == failed.end();
+}
+#endif
+
+bool transcode(const Texture& texture, [[maybe_unused]] bool normal_map, Image& image)
+{
+    image.width  = texture.width;
+    image.height = texture.height;
+    image.srgb   = texture.srgb;
+
+    // Already in a block format the renderer samples, the levels are only gathered
+    if (texture.vk_format != 0)
+    {
+        if (texture.supercompression != kSupercompNone || !toFormat(texture.vk_format, image.format, image.srgb)) return false;
+
+        allocateLevels(texture, image);
+        for (size_t i = 0; i < texture.levels.size(); ++i)
+        {
+            auto size = std::min<size_t>(texture.levels[i].size, image.data.size() - image.level_offsets[i]);
+            memcpy(image.data.data() + image.level_offsets[i], texture.data + texture.levels[i].offset, size);
+        }
+        return true;
+    }
+
+#ifdef USE_KTX2
+    image.format = choose_format(texture, normal_map);
+    allocateLevels(texture, image);
+    return transcodeBasis(texture, image);
+#else
+    return false;
+#endif
+}
+
+} // namespace ktx2
@@ -0,0 +1,151 @@
+#include <utils/mappedFile.h>
+
+#include <algorithm>
+
+#ifdef _WIN32
+#    ifndef WIN32_LEAN_AND_MEAN
+#        define WIN32_LEAN_AND_MEAN
+#    endif
+#    ifndef NOMINMAX
+#        define NOMINMAX
+#    endif
+#    include <windows.h>
+#else
+#    include <fcntl.h>
+#    include <sys/mman.h>
+#    include <sys/stat.h>
+#    include <unistd.h>
+#endif
+
+MappedFile::~MappedFile()
+{
+    close();
+}
+
+#ifdef _WIN32
+
+bool MappedFile::open(const std::string& fileName)
+{
+    close();
+
+    auto length = MultiByteToWideChar(CP_UTF8, 0, fileName.c_str(), -1, nullptr, 0);
+    if (length <= 0) return false;
+
+    std::wstring wideName(length, L'\0');
+    MultiByteToWideChar(CP_UTF8, 0, fileName.c_str(), -1, wideName.data(), length);
+
+    auto file = CreateFileW(wideName.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file == INVALID_HANDLE_VALUE) return false;
+
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0)
+    {
+        CloseHandle(file);
+        return false;
+    }
+
+    auto mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!mapping)
+    {
+        CloseHandle(file);
+        return false;
+    }
+
+    auto view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (!view)
+    {
+        CloseHandle(mapping);
+        CloseHandle(file);
+        return false;
+    }
+
+    m_file    = file;
+    m_mapping = mapping;
+    m_data    = static_cast<const unsigned char*>(view);
+    m_size    = size_t(fileSize.QuadPart);
+    return true;
+}
+
+void MappedFile::close()
+{
+    if (m_data) UnmapViewOfFile(m_data);
+    if (m_mapping) CloseHandle(m_mapping);
+    if (m_file) CloseHandle(m_file);
+
+    m_data    = nullptr;
+    m_size    = 0;
+    m_mapping = nullptr;
+    m_file    = nullptr;
+}
+
+void MappedFile::advise(size_t offset, size_t size, Advice advice) const
+{
+    if (!m_data || offset >= m_size) return;
+    if (advice != Advice::aWillNeed) return; // sequential scan is requested when opening the file
+
+    WIN32_MEMORY_RANGE_ENTRY range;
+    range.VirtualAddress = (void*)(m_data + offset);
+    range.NumberOfBytes  = std::min(size, m_size - offset);
+    PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0);
+}
+
+#else
+
+bool MappedFile::open(const std::string& fileName)
+{
+    close();
+
+    auto fd = ::open(fileName.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size == 0)
+    {
+        ::close(fd);
+        return false;
+    }
+
+    auto view = mmap(nullptr, size_t(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    if (view == MAP_FAILED)
+    {
+        ::close(fd);
+        return false;
+    }
+
+    m_fd   = fd;
+    m_data = static_cast<const unsigned char*>(view);
+    m_size = size_t(info.st_size);
+    return true;
+}
+
+void MappedFile::close()
+{
+    if (m_data) munmap((void*)m_data, m_size);
+    if (m_fd >= 0) ::close(m_fd);
+
+    m_data = nullptr;
+    m_size = 0;
+    m_fd   = -1;
+}
+
+void MappedFile::advise(size_t offset, size_t size, Advice advice) const
+{
+    if (!m_data || offset >= m_size) return;
+
+    // madvise needs a page aligned start
+    auto page  = size_t(sysconf(_SC_PAGESIZE));
+    auto begin = offset / page * page;
+    auto end   = std::min(offset + size, m_size);
+
+    int flag = MADV_NORMAL;
+    switch (advice)
+    {
+        case Advice::aNormal: flag = MADV_NORMAL; break;
+        case Advice::aSequential: flag = MADV_SEQUENTIAL; break;
+        case Advice::aWillNeed: flag = MADV_WILLNEED; break;
+    }
+
+    madvise((void*)(m_data + begin), end - begin, flag);
+}
+
+#endif
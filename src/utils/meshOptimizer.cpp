@@ -0,0 +1,765 @@
+#include <utils/meshOptimizer.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <numeric>
+#include <vector>
+
+namespace meshopt
+{
+
+static constexpr int   kCacheSize        = 32;
+static constexpr int   kMaxValence       = 64;
+static constexpr float kCacheDecayPower  = 1.5f;
+static constexpr float kLastTriScore     = 0.75f;
+static constexpr float kValenceBoostScale = 2.0f;
+static constexpr float kValenceBoostPower = 0.5f;
+
+struct ScoreTable
+{
+    float cache[kCacheSize];
+    float valence[kMaxValence];
+
+    ScoreTable()
+    {
+        for (int i = 0; i < kCacheSize; ++i)
+        {
+            // The three vertices of the last triangle get a fixed score so it is not directly reused
+            if (i < 3)
+                cache[i] = kLastTriScore;
+            else
+                cache[i] = powf(1.0f - float(i - 3) / float(kCacheSize - 3), kCacheDecayPower);
+        }
+
+        valence[0] = 0.0f;
+        for (int i = 1; i < kMaxValence; ++i)
+            valence[i] = kValenceBoostScale * powf(float(i), -kValenceBoostPower);
+    }
+
+    float score(int cache_pos, uint32_t live) const
+    {
+        if (live == 0) return -1.0f;
+
+        auto result = cache_pos < 0 ? 0.0f : cache[cache_pos];
+        return result + valence[std::min<uint32_t>(live, kMaxValence - 1)];
+    }
+};
+
+static const ScoreTable g_score_table;
+
+struct Adjacency
+{
+    std::vector<uint32_t> counts;
+    std::vector<uint32_t> offsets;
+    std::vector<uint32_t> triangles;
+
+    void build(const uint32_t* indices, size_t index_count, size_t vertex_count)
+    {
+        counts.assign(vertex_count, 0);
+        offsets.assign(vertex_count, 0);
+        triangles.resize(index_count);
+
+        for (size_t i = 0; i < index_count; ++i)
+            counts[indices[i]]++;
+
+        uint32_t offset = 0;
+        for (size_t v = 0; v < vertex_count; ++v)
+        {
+            offsets[v] = offset;
+            offset += counts[v];
+        }
+
+        std::vector<uint32_t> fill = offsets;
+        for (size_t i = 0; i < index_count; ++i)
+            triangles[fill[indices[i]]++] = uint32_t(i / 3);
+    }
+};
+
+void optimize_vertex_cache(uint32_t* dst, const uint32_t* indices, size_t index_count, size_t vertex_count)
+{
+    auto face_count = index_count / 3;
+    if (face_count == 0) return;
+
+    Adjacency adjacency;
+    adjacency.build(indices, index_count, vertex_count);
+
+    // live counts shrink as triangles are emitted, the adjacency list is compacted in place
+    auto& live = adjacency.counts;
+
+    std::vector<int>   cache_pos(vertex_count, -1);
+    std::vector<float> vertex_score(vertex_count);
+    for (size_t v = 0; v < vertex_count; ++v)
+        vertex_score[v] = g_score_table.score(-1, live[v]);
+
+    std::vector<float> face_score(face_count);
+    std::vector<bool>  emitted(face_count, false);
+    for (size_t f = 0; f < face_count; ++f)
+    {
+        face_score[f] = vertex_score[indices[f * 3 + 0]] + vertex_score[indices[f * 3 + 1]] + vertex_score[indices[f * 3 + 2]];
+    }
+
+    uint32_t cache[kCacheSize + 3];
+    uint32_t cache_new[kCacheSize + 3];
+    int      cache_count = 0;
+
+    size_t input_cursor = 0;
+    size_t output       = 0;
+
+    auto best_face = ~0u;
+    while (output < face_count)
+    {
+        if (best_face == ~0u)
+        {
+            // Cache has nothing to offer, pick the best among the next unemitted triangles in input order
+            float best_score = -1.0f;
+            for (size_t f = input_cursor; f < face_count; ++f)
+            {
+                if (emitted[f]) continue;
+                if (best_face == ~0u) input_cursor = f;
+
+                if (face_score[f] > best_score)
+                {
+                    best_score = face_score[f];
+                    best_face  = uint32_t(f);
+                }
+
+                // scanning the whole tail would be quadratic, a short window is enough
+                if (f - input_cursor > 64) break;
+            }
+        }
+
+        emitted[best_face] = true;
+        const uint32_t* tri = indices + best_face * 3;
+        memcpy(dst + output * 3, tri, 3 * sizeof(uint32_t));
+        output++;
+
+        // Push the triangle's vertices to the front of the LRU cache
+        int new_count = 0;
+        for (int k = 0; k < 3; ++k)
+            cache_new[new_count++] = tri[k];
+        for (int i = 0; i < cache_count; ++i)
+        {
+            auto v = cache[i];
+            if (v != tri[0] && v != tri[1] && v != tri[2]) cache_new[new_count++] = v;
+        }
+
+        // Remove the emitted triangle from the live adjacency of its vertices
+        for (int k = 0; k < 3; ++k)
+        {
+            auto  v     = tri[k];
+            auto* begin = adjacency.triangles.data() + adjacency.offsets[v];
+            auto* end   = begin + live[v];
+            auto* it    = std::find(begin, end, best_face);
+            if (it != end)
+            {
+                *it = *(end - 1);
+                live[v]--;
+            }
+        }
+
+        // Rescore every vertex that was touched, evicted ones fall back to the valence only score
+        for (int i = 0; i < new_count; ++i)
+        {
+            auto v       = cache_new[i];
+            cache_pos[v] = i < kCacheSize ? i : -1;
+        }
+
+        best_face        = ~0u;
+        float best_score = -1.0f;
+        for (int i = 0; i < new_count; ++i)
+        {
+            auto v     = cache_new[i];
+            auto score = g_score_table.score(cache_pos[v], live[v]);
+            auto delta = score - vertex_score[v];
+
+            vertex_score[v] = score;
+
+            auto* faces = adjacency.triangles.data() + adjacency.offsets[v];
+            for (uint32_t j = 0; j < live[v]; ++j)
+            {
+                auto f = faces[j];
+                face_score[f] += delta;
+                if (face_score[f] > best_score)
+                {
+                    best_score = face_score[f];
+                    best_face  = f;
+                }
+            }
+        }
+
+        cache_count = std::min(new_count, kCacheSize);
+        memcpy(cache, cache_new, cache_count * sizeof(uint32_t));
+    }
+}
+
+float analyze_acmr(const uint32_t* indices, size_t index_count, size_t vertex_count, uint32_t cache_size)
+{
+    if (index_count < 3) return 0.0f;
+
+    // FIFO: a vertex is resident while it was inserted less than cache_size misses ago
+    std::vector<uint32_t> timestamps(vertex_count, 0);
+    uint32_t              time   = cache_size + 1;
+    size_t                misses = 0;
+    for (size_t i = 0; i < index_count; ++i)
+    {
+        auto v = indices[i];
+        if (time - timestamps[v] > cache_size)
+        {
+            timestamps[v] = time++;
+            misses++;
+        }
+    }
+
+    return float(misses) / float(index_count / 3);
+}
+
+static auto readPosition(const float* positions, size_t stride, uint32_t v, float* out)
+{
+    memcpy(out, (const unsigned char*)positions + v * stride, 3 * sizeof(float));
+}
+
+void optimize_overdraw(uint32_t* dst, const uint32_t* indices, size_t index_count, const float* positions, size_t vertex_count, size_t position_stride, float threshold)
+{
+    auto face_count = index_count / 3;
+    if (face_count == 0) return;
+
+    // Hard boundaries: a triangle that misses on all three vertices starts a new cluster
+    std::vector<uint32_t> clusters;
+    {
+        const uint32_t        cache_size = 16;
+        std::vector<uint32_t> timestamps(vertex_count, 0);
+        uint32_t              time = cache_size + 1;
+        for (size_t f = 0; f < face_count; ++f)
+        {
+            int misses = 0;
+            for (int k = 0; k < 3; ++k)
+            {
+                auto v = indices[f * 3 + k];
+                if (time - timestamps[v] > cache_size)
+                {
+                    timestamps[v] = time++;
+                    misses++;
+                }
+            }
+
+            if (f == 0 || misses == 3) clusters.push_back(uint32_t(f));
+        }
+    }
+
+    double mesh_centroid[3] = {0.0, 0.0, 0.0};
+    for (size_t i = 0; i < index_count; ++i)
+    {
+        float p[3];
+        readPosition(positions, position_stride, indices[i], p);
+        for (int c = 0; c < 3; ++c)
+            mesh_centroid[c] += p[c];
+    }
+    for (int c = 0; c < 3; ++c)
+        mesh_centroid[c] /= double(index_count);
+
+    // Sort key: how far the cluster faces away from the mesh centroid
+    std::vector<float> keys(clusters.size());
+    for (size_t i = 0; i < clusters.size(); ++i)
+    {
+        auto begin = clusters[i];
+        auto end   = i + 1 < clusters.size() ? clusters[i + 1] : uint32_t(face_count);
+
+        double centroid[3] = {0.0, 0.0, 0.0};
+        double normal[3]   = {0.0, 0.0, 0.0};
+        double area        = 0.0;
+        for (auto f = begin; f < end; ++f)
+        {
+            float p0[3], p1[3], p2[3];
+            readPosition(positions, position_stride, indices[f * 3 + 0], p0);
+            readPosition(positions, position_stride, indices[f * 3 + 1], p1);
+            readPosition(positions, position_stride, indices[f * 3 + 2], p2);
+
+            double e1[3] = {p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2]};
+            double e2[3] = {p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2]};
+            double n[3]  = {e1[1] * e2[2] - e1[2] * e2[1], e1[2] * e2[0] - e1[0] * e2[2], e1[0] * e2[1] - e1[1] * e2[0]};
+            double a     = sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+
+            for (int c = 0; c < 3; ++c)
+            {
+                centroid[c] += (p0[c] + p1[c] + p2[c]) / 3.0 * a;
+                normal[c] += n[c];
+            }
+            area += a;
+        }
+
+        auto length = sqrt(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+        if (area <= 0.0 || length <= 0.0) continue;
+
+        double key = 0.0;
+        for (int c = 0; c < 3; ++c)
+            key += (centroid[c] / area - mesh_centroid[c]) * (normal[c] / length);
+        keys[i] = float(key);
+    }
+
+    std::vector<uint32_t> order(clusters.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) { return keys[a] > keys[b]; });
+
+    std::vector<uint32_t> sorted(index_count);
+    size_t                offset = 0;
+    for (auto i : order)
+    {
+        auto begin = clusters[i];
+        auto end   = i + 1 < clusters.size() ? clusters[i + 1] : uint32_t(face_count);
+        memcpy(sorted.data() + offset, indices + begin * 3, (end - begin) * 3 * sizeof(uint32_t));
+        offset += (end - begin) * 3;
+    }
+
+    auto acmr_input  = analyze_acmr(indices, index_count, vertex_count);
+    auto acmr_sorted = analyze_acmr(sorted.data(), index_count, vertex_count);
+    if (acmr_sorted > acmr_input * threshold)
+    {
+        if (dst != indices) memcpy(dst, indices, index_count * sizeof(uint32_t));
+        return;
+    }
+
+    memcpy(dst, sorted.data(), index_count * sizeof(uint32_t));
+}
+
+size_t optimize_vertex_fetch_remap(uint32_t* remap, const uint32_t* indices, size_t index_count, size_t vertex_count)
+{
+    std::fill(remap, remap + vertex_count, ~0u);
+
+    uint32_t next = 0;
+    for (size_t i = 0; i < index_count; ++i)
+    {
+        auto v = indices[i];
+        if (remap[v] == ~0u) remap[v] = next++;
+    }
+
+    return next;
+}
+
+void remap_index_buffer(uint32_t* indices, size_t index_count, const uint32_t* remap)
+{
+    for (size_t i = 0; i < index_count; ++i)
+        indices[i] = remap[indices[i]];
+}
+
+void remap_vertex_buffer(void* dst, const void* vertices, size_t vertex_count, size_t vertex_size, size_t vertex_stride, const uint32_t* remap)
+{
+    auto src = static_cast<const unsigned char*>(vertices);
+    auto out = static_cast<unsigned char*>(dst);
+    for (size_t v = 0; v < vertex_count; ++v)
+    {
+        if (remap[v] == ~0u) continue;
+        memcpy(out + remap[v] * vertex_size, src + v * vertex_stride, vertex_size);
+    }
+}
+
+void build_meshlets(MeshletSet& result, const uint32_t* indices, size_t index_count, size_t max_vertices, size_t max_triangles)
+{
+    // compute_meshlet_bounds works on 256 vertices and triangles at most
+    max_vertices  = std::min<size_t>(max_vertices, 256);
+    max_triangles = std::min<size_t>(max_triangles, 256);
+
+    result.meshlets.clear();
+    result.vertices.clear();
+    result.triangles.clear();
+    result.vertices.reserve(index_count / 3);
+    result.triangles.reserve(index_count);
+
+    // local slot + 1 of each geometry vertex in the open meshlet, 0 when absent
+    std::vector<uint16_t> slots;
+    Meshlet               current;
+
+    auto flush = [&]() {
+        if (current.triangle_count == 0) return;
+
+        for (uint32_t i = 0; i < current.vertex_count; ++i)
+            slots[result.vertices[current.vertex_offset + i]] = 0;
+
+        result.meshlets.push_back(current);
+        current                 = Meshlet();
+        current.vertex_offset   = uint32_t(result.vertices.size());
+        current.triangle_offset = uint32_t(result.triangles.size());
+    };
+
+    for (size_t i = 0; i + 2 < index_count; i += 3)
+    {
+        const uint32_t* tri = indices + i;
+        for (int k = 0; k < 3; ++k)
+        {
+            if (tri[k] >= slots.size()) slots.resize(size_t(tri[k]) + 1, 0);
+        }
+
+        uint32_t extra = 0;
+        for (int k = 0; k < 3; ++k)
+        {
+            // a repeated vertex inside the triangle only counts once
+            bool repeated = (k > 0 && tri[k] == tri[0]) || (k > 1 && tri[k] == tri[1]);
+            if (slots[tri[k]] == 0 && !repeated) extra++;
+        }
+
+        if (current.vertex_count + extra > max_vertices || current.triangle_count + 1 > max_triangles) flush();
+
+        for (int k = 0; k < 3; ++k)
+        {
+            auto& slot = slots[tri[k]];
+            if (slot == 0)
+            {
+                result.vertices.push_back(tri[k]);
+                slot = uint16_t(++current.vertex_count);
+            }
+
+            result.triangles.push_back(uint8_t(slot - 1));
+        }
+
+        current.triangle_count++;
+    }
+
+    flush();
+}
+
+static auto readFloat3(const float* positions, size_t stride, uint32_t v, float* out)
+{
+    memcpy(out, (const unsigned char*)positions + v * stride, 3 * sizeof(float));
+}
+
+static auto computeSphere(const float (*points)[3], size_t count, float* center, float& radius)
+{
+    // Ritter: start from the widest of the axis extreme pairs, then grow to include stragglers
+    size_t pmin[3] = {0, 0, 0}, pmax[3] = {0, 0, 0};
+    for (size_t i = 0; i < count; ++i)
+    {
+        for (int c = 0; c < 3; ++c)
+        {
+            if (points[i][c] < points[pmin[c]][c]) pmin[c] = i;
+            if (points[i][c] > points[pmax[c]][c]) pmax[c] = i;
+        }
+    }
+
+    auto distance2 = [](const float* a, const float* b) {
+        float dx = a[0] - b[0], dy = a[1] - b[1], dz = a[2] - b[2];
+        return dx * dx + dy * dy + dz * dz;
+    };
+
+    int   axis = 0;
+    float span = -1.0f;
+    for (int c = 0; c < 3; ++c)
+    {
+        auto d = distance2(points[pmin[c]], points[pmax[c]]);
+        if (d > span)
+        {
+            span = d;
+            axis = c;
+        }
+    }
+
+    for (int c = 0; c < 3; ++c)
+        center[c] = (points[pmin[axis]][c] + points[pmax[axis]][c]) * 0.5f;
+    radius = sqrtf(span) * 0.5f;
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        auto d2 = distance2(points[i], center);
+        if (d2 <= radius * radius) continue;
+
+        auto d     = sqrtf(d2);
+        auto grown = (radius + d) * 0.5f;
+        auto k     = (grown - radius) / d;
+        for (int c = 0; c < 3; ++c)
+            center[c] += (points[i][c] - center[c]) * k;
+        radius = grown;
+    }
+}
+
+void compute_meshlet_bounds(MeshletSet& set, const float* positions, size_t position_stride)
+{
+    set.bounds.assign(set.meshlets.size(), MeshletBounds());
+
+    float points[256][3];
+    float normals[256][3];
+    float corners[256][3];
+    for (size_t m = 0; m < set.meshlets.size(); ++m)
+    {
+        const auto& meshlet = set.meshlets[m];
+        auto&       bounds  = set.bounds[m];
+
+        for (uint32_t i = 0; i < meshlet.vertex_count; ++i)
+            readFloat3(positions, position_stride, set.vertices[meshlet.vertex_offset + i], points[i]);
+
+        computeSphere(points, meshlet.vertex_count, bounds.center, bounds.radius);
+
+        // Normal cone over the non-degenerate triangles
+        size_t normal_count = 0;
+        float  axis[3]      = {0.0f, 0.0f, 0.0f};
+        for (uint32_t t = 0; t < meshlet.triangle_count; ++t)
+        {
+            const auto* tri = set.triangles.data() + meshlet.triangle_offset + t * 3;
+            const auto* p0  = points[tri[0]];
+            const auto* p1  = points[tri[1]];
+            const auto* p2  = points[tri[2]];
+
+            float e1[3] = {p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2]};
+            float e2[3] = {p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2]};
+            float n[3]  = {e1[1] * e2[2] - e1[2] * e2[1], e1[2] * e2[0] - e1[0] * e2[2], e1[0] * e2[1] - e1[1] * e2[0]};
+            float area  = sqrtf(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+            if (area == 0.0f) continue;
+
+            for (int c = 0; c < 3; ++c)
+            {
+                normals[normal_count][c] = n[c] / area;
+                corners[normal_count][c] = p0[c];
+                axis[c] += normals[normal_count][c];
+            }
+            normal_count++;
+        }
+
+        auto length = sqrtf(axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2]);
+        if (normal_count == 0 || length == 0.0f) continue;
+
+        for (int c = 0; c < 3; ++c)
+            axis[c] /= length;
+
+        float min_dot = 1.0f;
+        for (size_t i = 0; i < normal_count; ++i)
+            min_dot = std::min(min_dot, normals[i][0] * axis[0] + normals[i][1] * axis[1] + normals[i][2] * axis[2]);
+
+        // Cones wider than ~85 degrees are not worth testing
+        if (min_dot <= 0.1f) continue;
+
+        // Apex: move back along the axis until every triangle plane is in front of it
+        float max_t = 0.0f;
+        for (size_t i = 0; i < normal_count; ++i)
+        {
+            float dc[3] = {bounds.center[0] - corners[i][0], bounds.center[1] - corners[i][1], bounds.center[2] - corners[i][2]};
+            auto  dn    = dc[0] * normals[i][0] + dc[1] * normals[i][1] + dc[2] * normals[i][2];
+            auto  an    = axis[0] * normals[i][0] + axis[1] * normals[i][1] + axis[2] * normals[i][2];
+            max_t       = std::max(max_t, dn / an);
+        }
+
+        for (int c = 0; c < 3; ++c)
+        {
+            bounds.cone_apex[c] = bounds.center[c] - axis[c] * max_t;
+            bounds.cone_axis[c] = axis[c];
+        }
+        bounds.cone_cutoff = sqrtf(1.0f - min_dot * min_dot);
+    }
+}
+
+struct Quadric
+{
+    // symmetric A, b and c of the squared plane distance x'Ax + 2b'x + c, weighted by area
+    double a00 = 0.0, a11 = 0.0, a22 = 0.0, a01 = 0.0, a02 = 0.0, a12 = 0.0;
+    double b0 = 0.0, b1 = 0.0, b2 = 0.0;
+    double c = 0.0;
+    double w = 0.0;
+
+    void add_plane(const double n[3], double d, double weight)
+    {
+        a00 += weight * n[0] * n[0];
+        a11 += weight * n[1] * n[1];
+        a22 += weight * n[2] * n[2];
+        a01 += weight * n[0] * n[1];
+        a02 += weight * n[0] * n[2];
+        a12 += weight * n[1] * n[2];
+        b0 += weight * n[0] * d;
+        b1 += weight * n[1] * d;
+        b2 += weight * n[2] * d;
+        c += weight * d * d;
+        w += weight;
+    }
+
+    void add(const Quadric& q)
+    {
+        a00 += q.a00, a11 += q.a11, a22 += q.a22, a01 += q.a01, a02 += q.a02, a12 += q.a12;
+        b0 += q.b0, b1 += q.b1, b2 += q.b2;
+        c += q.c;
+        w += q.w;
+    }
+
+    double error(const float* p) const
+    {
+        double x = p[0], y = p[1], z = p[2];
+        double r = a00 * x * x + a11 * y * y + a22 * z * z + 2.0 * (a01 * x * y + a02 * x * z + a12 * y * z);
+        r += 2.0 * (b0 * x + b1 * y + b2 * z) + c;
+        return r > 0.0 ? r : 0.0;
+    }
+};
+
+struct Collapse
+{
+    uint32_t from;
+    uint32_t to;
+    float    cost; // mean squared distance
+};
+
+size_t simplify(uint32_t* dst, const uint32_t* indices, size_t index_count, const float* positions, size_t vertex_count, size_t position_stride, size_t target_index_count, float target_error, float* result_error)
+{
+    auto position = [&](uint32_t v) { return (const float*)((const unsigned char*)positions + v * position_stride); };
+
+    std::vector<uint32_t> current(indices, indices + index_count - index_count % 3);
+
+    // Lock vertices on open or non-manifold edges, this also keeps uv/normal seams intact
+    std::vector<bool> locked(vertex_count, false);
+    {
+        std::vector<uint64_t> edges;
+        edges.reserve(current.size());
+        for (size_t i = 0; i < current.size(); i += 3)
+        {
+            for (int k = 0; k < 3; ++k)
+            {
+                uint64_t a = current[i + k], b = current[i + (k + 1) % 3];
+                edges.push_back(a < b ? (a << 32) | b : (b << 32) | a);
+            }
+        }
+        std::sort(edges.begin(), edges.end());
+
+        for (size_t i = 0; i < edges.size();)
+        {
+            size_t j = i;
+            while (j < edges.size() && edges[j] == edges[i])
+                j++;
+
+            if (j - i != 2)
+            {
+                locked[edges[i] >> 32]         = true;
+                locked[edges[i] & 0xffffffffu] = true;
+            }
+            i = j;
+        }
+    }
+
+    std::vector<Quadric> quadrics(vertex_count);
+    for (size_t i = 0; i < current.size(); i += 3)
+    {
+        const float* p0 = position(current[i + 0]);
+        const float* p1 = position(current[i + 1]);
+        const float* p2 = position(current[i + 2]);
+
+        double e1[3] = {p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2]};
+        double e2[3] = {p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2]};
+        double n[3]  = {e1[1] * e2[2] - e1[2] * e2[1], e1[2] * e2[0] - e1[0] * e2[2], e1[0] * e2[1] - e1[1] * e2[0]};
+        double area  = sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+        if (area == 0.0) continue;
+
+        for (auto& c : n)
+            c /= area;
+        double d = -(n[0] * p0[0] + n[1] * p0[1] + n[2] * p0[2]);
+
+        for (int k = 0; k < 3; ++k)
+            quadrics[current[i + k]].add_plane(n, d, area * 0.5);
+    }
+
+    auto limit      = double(target_error) * double(target_error);
+    auto max_cost   = 0.0;
+    auto normalOf   = [](const float* a, const float* b, const float* c, double* n) {
+        double e1[3] = {b[0] - a[0], b[1] - a[1], b[2] - a[2]};
+        double e2[3] = {c[0] - a[0], c[1] - a[1], c[2] - a[2]};
+        n[0]         = e1[1] * e2[2] - e1[2] * e2[1];
+        n[1]         = e1[2] * e2[0] - e1[0] * e2[2];
+        n[2]         = e1[0] * e2[1] - e1[1] * e2[0];
+    };
+
+    std::vector<Collapse> collapses;
+    std::vector<uint32_t> remap(vertex_count);
+    std::vector<bool>     touched(vertex_count);
+    Adjacency             adjacency;
+
+    while (current.size() > target_index_count)
+    {
+        adjacency.build(current.data(), current.size(), vertex_count);
+
+        collapses.clear();
+        for (size_t i = 0; i < current.size(); i += 3)
+        {
+            for (int k = 0; k < 3; ++k)
+            {
+                uint32_t a = current[i + k], b = current[i + (k + 1) % 3];
+                for (int dir = 0; dir < 2; ++dir)
+                {
+                    if (!locked[a])
+                    {
+                        Quadric q = quadrics[a];
+                        q.add(quadrics[b]);
+                        auto cost = q.w > 0.0 ? q.error(position(b)) / q.w : 0.0;
+                        collapses.push_back({a, b, float(cost)});
+                    }
+                    std::swap(a, b);
+                }
+            }
+        }
+        if (collapses.empty()) break;
+
+        std::sort(collapses.begin(), collapses.end(), [](const Collapse& l, const Collapse& r) { return l.cost < r.cost; });
+
+        for (size_t v = 0; v < vertex_count; ++v)
+            remap[v] = uint32_t(v);
+        std::fill(touched.begin(), touched.end(), false);
+
+        // Each collapse removes about two triangles, do not overshoot the target within a pass
+        auto   budget    = (current.size() - target_index_count) / 6 + 1;
+        size_t performed = 0;
+        for (const auto& collapse : collapses)
+        {
+            if (performed >= budget || collapse.cost > limit) break;
+
+            auto from = collapse.from, to = collapse.to;
+            if (touched[from] || touched[to]) continue;
+
+            // Reject collapses that flip a surviving triangle around 'from'
+            bool  flips = false;
+            auto* faces = adjacency.triangles.data() + adjacency.offsets[from];
+            for (uint32_t j = 0; j < adjacency.counts[from] && !flips; ++j)
+            {
+                const uint32_t* tri = current.data() + faces[j] * 3;
+                if (tri[0] == to || tri[1] == to || tri[2] == to) continue;
+
+                const float* before[3] = {position(tri[0]), position(tri[1]), position(tri[2])};
+                const float* after[3]  = {before[0], before[1], before[2]};
+                for (int k = 0; k < 3; ++k)
+                {
+                    if (tri[k] == from) after[k] = position(to);
+                }
+
+                double n0[3], n1[3];
+                normalOf(before[0], before[1], before[2], n0);
+                normalOf(after[0], after[1], after[2], n1);
+                auto dot = n0[0] * n1[0] + n0[1] * n1[1] + n0[2] * n1[2];
+                auto l0  = sqrt(n0[0] * n0[0] + n0[1] * n0[1] + n0[2] * n0[2]);
+                auto l1  = sqrt(n1[0] * n1[0] + n1[1] * n1[1] + n1[2] * n1[2]);
+                if (dot < 0.25 * l0 * l1) flips = true;
+            }
+            if (flips) continue;
+
+            // The neighborhood of 'from' changes, keep it out of the rest of this pass
+            for (uint32_t j = 0; j < adjacency.counts[from]; ++j)
+            {
+                const uint32_t* tri = current.data() + faces[j] * 3;
+                touched[tri[0]] = touched[tri[1]] = touched[tri[2]] = true;
+            }
+
+            remap[from] = to;
+            quadrics[to].add(quadrics[from]);
+            max_cost = std::max(max_cost, double(collapse.cost));
+            performed++;
+        }
+        if (performed == 0) break;
+
+        size_t write = 0;
+        for (size_t i = 0; i < current.size(); i += 3)
+        {
+            auto a = remap[current[i + 0]], b = remap[current[i + 1]], c = remap[current[i + 2]];
+            if (a == b || b == c || a == c) continue;
+
+            current[write++] = a;
+            current[write++] = b;
+            current[write++] = c;
+        }
+        current.resize(write);
+    }
+
+    memcpy(dst, current.data(), current.size() * sizeof(uint32_t));
+    if (result_error) *result_error = float(sqrt(max_cost));
+
+    return current.size();
+}
+
+} // namespace meshopt
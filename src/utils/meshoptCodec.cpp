@@ -0,0 +1,432 @@
+#include <utils/meshoptCodec.h>
+
+#include <cmath>
+#include <cstring>
+
+namespace meshopt
+{
+
+static constexpr unsigned char kVertexHeader   = 0xa0;
+static constexpr unsigned char kIndexHeader    = 0xe0;
+static constexpr unsigned char kSequenceHeader = 0xd0;
+
+static constexpr size_t kVertexBlockSizeBytes = 8192;
+static constexpr size_t kVertexBlockMaxSize   = 256;
+static constexpr size_t kByteGroupSize        = 16;
+static constexpr size_t kByteGroupDecodeLimit = 24;
+static constexpr size_t kTailMaxSize          = 32;
+
+static size_t vertexBlockSize(size_t vertex_size)
+{
+    // A block fills the scratch buffer, rounded down to whole byte groups
+    auto result = (kVertexBlockSizeBytes / vertex_size) & ~(kByteGroupSize - 1);
+    return result < kVertexBlockMaxSize ? result : kVertexBlockMaxSize;
+}
+
+static unsigned char unzigzag8(unsigned char v)
+{
+    return (unsigned char)(-(v & 1) ^ (v >> 1));
+}
+
+// 16 values of 0, 2, 4 or 8 bits each, values with all bits set are escapes to a trailing full byte
+static const unsigned char* decodeBytesGroup(const unsigned char* data, unsigned char* buffer, int bitslog2)
+{
+    if (bitslog2 == 0)
+    {
+        memset(buffer, 0, kByteGroupSize);
+        return data;
+    }
+    if (bitslog2 == 3)
+    {
+        memcpy(buffer, data, kByteGroupSize);
+        return data + kByteGroupSize;
+    }
+
+    int  bits     = bitslog2 == 1 ? 2 : 4;
+    int  escape   = (1 << bits) - 1;
+    auto packed   = data;
+    auto data_var = data + kByteGroupSize * bits / 8;
+    for (size_t i = 0; i < kByteGroupSize; i += 8 / bits)
+    {
+        unsigned char byte = *packed++;
+        for (int k = 0; k < 8 / bits; ++k)
+        {
+            int enc = byte >> (8 - bits);
+            byte    = (unsigned char)(byte << bits);
+
+            *buffer++ = enc == escape ? *data_var : (unsigned char)enc;
+            data_var += enc == escape;
+        }
+    }
+
+    return data_var;
+}
+
+static const unsigned char* decodeBytes(const unsigned char* data, const unsigned char* data_end, unsigned char* buffer, size_t buffer_size)
+{
+    // 2 header bits per group select its bit width
+    auto header      = data;
+    auto header_size = (buffer_size / kByteGroupSize + 3) / 4;
+    if (size_t(data_end - data) < header_size) return nullptr;
+
+    data += header_size;
+    for (size_t i = 0; i < buffer_size; i += kByteGroupSize)
+    {
+        if (size_t(data_end - data) < kByteGroupDecodeLimit) return nullptr;
+
+        auto group    = i / kByteGroupSize;
+        int  bitslog2 = (header[group / 4] >> ((group % 4) * 2)) & 3;
+        data          = decodeBytesGroup(data, buffer + i, bitslog2);
+    }
+
+    return data;
+}
+
+static const unsigned char* decodeVertexBlock(const unsigned char* data, const unsigned char* data_end, unsigned char* vertex_data, size_t vertex_count, size_t vertex_size, unsigned char last_vertex[256])
+{
+    unsigned char buffer[kVertexBlockMaxSize];
+    unsigned char transposed[kVertexBlockSizeBytes];
+
+    // Each byte of the vertex is its own stream of zigzag deltas to the previous vertex
+    auto vertex_count_aligned = (vertex_count + kByteGroupSize - 1) & ~(kByteGroupSize - 1);
+    for (size_t k = 0; k < vertex_size; ++k)
+    {
+        data = decodeBytes(data, data_end, buffer, vertex_count_aligned);
+        if (!data) return nullptr;
+
+        auto p = last_vertex[k];
+        for (size_t i = 0; i < vertex_count; ++i)
+        {
+            auto v                          = (unsigned char)(unzigzag8(buffer[i]) + p);
+            transposed[i * vertex_size + k] = v;
+            p                               = v;
+        }
+    }
+
+    memcpy(vertex_data, transposed, vertex_count * vertex_size);
+    memcpy(last_vertex, &transposed[vertex_size * (vertex_count - 1)], vertex_size);
+    return data;
+}
+
+bool decode_vertex_buffer(void* dst, size_t vertex_count, size_t vertex_size, const unsigned char* buffer, size_t buffer_size)
+{
+    if (vertex_size == 0 || vertex_size > 256 || vertex_size % 4 != 0) return false;
+    if (buffer_size < 1 + vertex_size) return false;
+
+    auto data     = buffer;
+    auto data_end = buffer + buffer_size;
+
+    unsigned char header = *data++;
+    if ((header & 0xf0) != kVertexHeader || (header & 0x0f) > 0) return false;
+
+    // The first vertex is stored in the tail and seeds the deltas
+    unsigned char last_vertex[256];
+    memcpy(last_vertex, data_end - vertex_size, vertex_size);
+
+    auto vertex_data = static_cast<unsigned char*>(dst);
+    auto block_size  = vertexBlockSize(vertex_size);
+    for (size_t offset = 0; offset < vertex_count; offset += block_size)
+    {
+        auto count = offset + block_size < vertex_count ? block_size : vertex_count - offset;
+        data       = decodeVertexBlock(data, data_end, vertex_data + offset * vertex_size, count, vertex_size, last_vertex);
+        if (!data) return false;
+    }
+
+    auto tail_size = vertex_size < kTailMaxSize ? kTailMaxSize : vertex_size;
+    return size_t(data_end - data) == tail_size;
+}
+
+static unsigned int decodeVByte(const unsigned char*& data)
+{
+    unsigned char lead = *data++;
+    if (lead < 128) return lead;
+
+    unsigned int result = lead & 127;
+    unsigned int shift  = 7;
+    for (int i = 0; i < 4; ++i)
+    {
+        unsigned char group = *data++;
+        result |= unsigned(group & 127) << shift;
+        shift += 7;
+
+        if (group < 128) break;
+    }
+
+    return result;
+}
+
+static unsigned int decodeIndex(const unsigned char*& data, unsigned int last)
+{
+    auto v = decodeVByte(data);
+    auto d = (v >> 1) ^ -int(v & 1);
+    return last + d;
+}
+
+static void writeTriangle(void* dst, size_t offset, size_t index_size, unsigned int a, unsigned int b, unsigned int c)
+{
+    if (index_size == 2)
+    {
+        auto out = static_cast<uint16_t*>(dst) + offset;
+        out[0]   = uint16_t(a);
+        out[1]   = uint16_t(b);
+        out[2]   = uint16_t(c);
+    }
+    else
+    {
+        auto out = static_cast<uint32_t*>(dst) + offset;
+        out[0]   = a;
+        out[1]   = b;
+        out[2]   = c;
+    }
+}
+
+bool decode_index_buffer(void* dst, size_t index_count, size_t index_size, const unsigned char* buffer, size_t buffer_size)
+{
+    if (index_count % 3 != 0 || (index_size != 2 && index_size != 4)) return false;
+
+    // Header, one code byte per triangle and the 16 byte codeaux table at the end
+    if (buffer_size < 1 + index_count / 3 + 16) return false;
+    if ((buffer[0] & 0xf0) != kIndexHeader) return false;
+
+    int version = buffer[0] & 0x0f;
+    if (version > 1) return false;
+
+    unsigned int edge_fifo[16][2];
+    unsigned int vertex_fifo[16];
+    memset(edge_fifo, -1, sizeof(edge_fifo));
+    memset(vertex_fifo, -1, sizeof(vertex_fifo));
+
+    size_t edge_offset   = 0;
+    size_t vertex_offset = 0;
+
+    auto push_edge = [&](unsigned int a, unsigned int b) {
+        edge_fifo[edge_offset][0] = a;
+        edge_fifo[edge_offset][1] = b;
+        edge_offset               = (edge_offset + 1) & 15;
+    };
+    auto push_vertex = [&](unsigned int v, bool cond = true) {
+        vertex_fifo[vertex_offset] = v;
+        vertex_offset              = (vertex_offset + cond) & 15;
+    };
+
+    unsigned int next    = 0;
+    unsigned int last    = 0;
+    int          fec_max = version >= 1 ? 13 : 15;
+
+    auto code          = buffer + 1;
+    auto data          = code + index_count / 3;
+    auto data_safe_end = buffer + buffer_size - 16;
+    auto codeaux_table = data_safe_end;
+
+    for (size_t i = 0; i < index_count; i += 3)
+    {
+        // A triangle reads at most 16 bytes past data, the codeaux table keeps that in bounds
+        if (data > data_safe_end) return false;
+
+        unsigned char codetri = *code++;
+        if (codetri < 0xf0)
+        {
+            // Edge from the edge fifo, third vertex new, from the vertex fifo or free
+            int  fe  = codetri >> 4;
+            auto a   = edge_fifo[(edge_offset - 1 - fe) & 15][0];
+            auto b   = edge_fifo[(edge_offset - 1 - fe) & 15][1];
+            int  fec = codetri & 15;
+
+            unsigned int c = 0;
+            if (fec < fec_max)
+            {
+                c = fec == 0 ? next : vertex_fifo[(vertex_offset - 1 - fec) & 15];
+                next += fec == 0;
+                push_vertex(c, fec == 0);
+            }
+            else
+            {
+                // 13 and 14 are last -1 and +1 (version 1), free indices are deltas to the last one
+                c = last = fec != 15 ? last + (fec - (fec ^ 3)) : decodeIndex(data, last);
+                push_vertex(c);
+            }
+
+            writeTriangle(dst, i, index_size, a, b, c);
+            push_edge(c, b);
+            push_edge(a, c);
+        }
+        else if (codetri < 0xfe)
+        {
+            // Three vertices, new or from the vertex fifo as given by the codeaux table
+            unsigned char codeaux = codeaux_table[codetri & 15];
+
+            int feb = codeaux >> 4;
+            int fec = codeaux & 15;
+
+            auto a = next++;
+            auto b = feb == 0 ? next : vertex_fifo[(vertex_offset - feb) & 15];
+            next += feb == 0;
+            auto c = fec == 0 ? next : vertex_fifo[(vertex_offset - fec) & 15];
+            next += fec == 0;
+
+            writeTriangle(dst, i, index_size, a, b, c);
+            push_vertex(a);
+            push_vertex(b, feb == 0);
+            push_vertex(c, fec == 0);
+            push_edge(b, a);
+            push_edge(c, b);
+            push_edge(a, c);
+        }
+        else
+        {
+            // Same with a full codeaux byte, 15 means a free index and codeaux 0 resets next
+            unsigned char codeaux = *data++;
+
+            int fea = codetri == 0xfe ? 0 : 15;
+            int feb = codeaux >> 4;
+            int fec = codeaux & 15;
+
+            if (codeaux == 0) next = 0;
+
+            unsigned int a = fea == 0 ? next++ : 0;
+            unsigned int b = feb == 0 ? next++ : vertex_fifo[(vertex_offset - feb) & 15];
+            unsigned int c = fec == 0 ? next++ : vertex_fifo[(vertex_offset - fec) & 15];
+
+            if (fea == 15) last = a = decodeIndex(data, last);
+            if (feb == 15) last = b = decodeIndex(data, last);
+            if (fec == 15) last = c = decodeIndex(data, last);
+
+            writeTriangle(dst, i, index_size, a, b, c);
+            push_vertex(a);
+            push_vertex(b, feb == 0 || feb == 15);
+            push_vertex(c, fec == 0 || fec == 15);
+            push_edge(b, a);
+            push_edge(c, b);
+            push_edge(a, c);
+        }
+    }
+
+    return data == data_safe_end;
+}
+
+bool decode_index_sequence(void* dst, size_t index_count, size_t index_size, const unsigned char* buffer, size_t buffer_size)
+{
+    if (index_size != 2 && index_size != 4) return false;
+
+    // Header, at least one byte per index and a 4 byte tail
+    if (buffer_size < 1 + index_count + 4) return false;
+    if ((buffer[0] & 0xf0) != kSequenceHeader) return false;
+
+    int version = buffer[0] & 0x0f;
+    if (version > 1) return false;
+
+    auto data          = buffer + 1;
+    auto data_safe_end = buffer + buffer_size - 4;
+
+    // Two baselines, the low bit of each value picks the one its delta is relative to
+    unsigned int last[2] = {0, 0};
+    for (size_t i = 0; i < index_count; ++i)
+    {
+        if (data >= data_safe_end) return false;
+
+        auto v       = decodeVByte(data);
+        auto current = v & 1;
+        v >>= 1;
+
+        auto d        = (v >> 1) ^ -int(v & 1);
+        auto index    = last[current] + d;
+        last[current] = index;
+
+        if (index_size == 2)
+            static_cast<uint16_t*>(dst)[i] = uint16_t(index);
+        else
+            static_cast<uint32_t*>(dst)[i] = index;
+    }
+
+    return data == data_safe_end;
+}
+
+template <typename T>
+static void decodeFilterOct(unsigned char* data, size_t count, size_t stride)
+{
+    const float max = float((1 << (sizeof(T) * 8 - 1)) - 1);
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        auto v = reinterpret_cast<T*>(data + i * stride);
+
+        // z is stored as the value of 1.0 and reconstructed from |x| + |y|
+        float x = float(v[0]);
+        float y = float(v[1]);
+        float z = float(v[2]) - fabsf(x) - fabsf(y);
+
+        // Unfold the lower hemisphere
+        float t = z >= 0.0f ? 0.0f : z;
+        x += x >= 0.0f ? t : -t;
+        y += y >= 0.0f ? t : -t;
+
+        float s = max / sqrtf(x * x + y * y + z * z);
+
+        v[0] = T(int(x * s + (x >= 0.0f ? 0.5f : -0.5f)));
+        v[1] = T(int(y * s + (y >= 0.0f ? 0.5f : -0.5f)));
+        v[2] = T(int(z * s + (z >= 0.0f ? 0.5f : -0.5f)));
+    }
+}
+
+void decode_filter_oct(void* data, size_t count, size_t stride)
+{
+    if (stride == 4)
+        decodeFilterOct<int8_t>(static_cast<unsigned char*>(data), count, stride);
+    else if (stride == 8)
+        decodeFilterOct<int16_t>(static_cast<unsigned char*>(data), count, stride);
+}
+
+void decode_filter_quat(void* data, size_t count, size_t stride)
+{
+    if (stride != 8) return;
+
+    const float scale = 1.0f / sqrtf(2.0f);
+
+    auto bytes = static_cast<unsigned char*>(data);
+    for (size_t i = 0; i < count; ++i)
+    {
+        auto v = reinterpret_cast<int16_t*>(bytes + i * stride);
+
+        // The low 2 bits of the 4th value name the dropped (largest) component, the rest is the scale
+        int   sf = v[3] | 3;
+        float ss = scale / float(sf);
+
+        float x  = float(v[0]) * ss;
+        float y  = float(v[1]) * ss;
+        float z  = float(v[2]) * ss;
+        float ww = 1.0f - x * x - y * y - z * z;
+        float w  = sqrtf(ww >= 0.0f ? ww : 0.0f);
+
+        int xf = int(x * 32767.0f + (x >= 0.0f ? 0.5f : -0.5f));
+        int yf = int(y * 32767.0f + (y >= 0.0f ? 0.5f : -0.5f));
+        int zf = int(z * 32767.0f + (z >= 0.0f ? 0.5f : -0.5f));
+        int wf = int(w * 32767.0f + 0.5f);
+
+        int qc = v[3] & 3;
+
+        v[(qc + 1) & 3] = int16_t(xf);
+        v[(qc + 2) & 3] = int16_t(yf);
+        v[(qc + 3) & 3] = int16_t(zf);
+        v[(qc + 0) & 3] = int16_t(wf);
+    }
+}
+
+void decode_filter_exp(void* data, size_t count, size_t stride)
+{
+    // 24 bit signed mantissa, 8 bit signed exponent per 32 bit value
+    auto values = static_cast<uint32_t*>(data);
+    for (size_t i = 0; i < count * (stride / 4); ++i)
+    {
+        auto v = values[i];
+        int  m = int(v << 8) >> 8;
+        int  e = int(v) >> 24;
+
+        uint32_t bits = uint32_t(e + 127) << 23;
+        float    f;
+        memcpy(&f, &bits, sizeof(float));
+        f *= float(m);
+        memcpy(&values[i], &f, sizeof(float));
+    }
+}
+
+} // namespace meshopt
@@ -0,0 +1,417 @@
+#include <utils/mipmap.h>
+#include <utils/workerPool.h>
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)
+#    define MIPMAP_USE_SSE 1
+#    include <immintrin.h>
+#else
+#    define MIPMAP_USE_SSE 0
+#endif
+
+namespace mipmap
+{
+
+// Destination rows one worker item filters, the horizontal pass is redone for the taps shared
+// with the neighbouring bands
+static constexpr uint32_t kRowsPerTask = 16;
+
+static constexpr uint32_t kMaxTaps = 8;
+
+// Destination pixel x covers source pixels [2x, 2x + 2), tap i reads source pixel 2x + first + i
+struct Kernel
+{
+    int      first = 0;
+    uint32_t count = 0;
+    float    weights[kMaxTaps];
+};
+
+static double besselI0(double x)
+{
+    double sum = 1.0, term = 1.0;
+    for (int k = 1; k < 32; ++k)
+    {
+        term *= (x * 0.5 / k) * (x * 0.5 / k);
+        sum += term;
+    }
+    return sum;
+}
+
+static Kernel makeKernel(Filter filter)
+{
+    Kernel kernel;
+    if (filter == Filter::fBox)
+    {
+        kernel.first      = 0;
+        kernel.count      = 2;
+        kernel.weights[0] = 0.5f;
+        kernel.weights[1] = 0.5f;
+        return kernel;
+    }
+
+    // sinc of the destination sample rate windowed by Kaiser over 2 destination pixels
+    constexpr double kAlpha  = 4.0;
+    constexpr double kRadius = 2.0;
+    constexpr double kPi     = 3.14159265358979323846;
+
+    kernel.first = -3;
+    kernel.count = kMaxTaps;
+
+    double weights[kMaxTaps], sum = 0.0;
+    for (uint32_t i = 0; i < kMaxTaps; ++i)
+    {
+        // Source pixel centers relative to the destination center, in destination pixels
+        auto t      = ((kernel.first + int(i)) + 0.5 - 1.0) * 0.5;
+        auto x      = t / kRadius;
+        auto window = besselI0(kAlpha * std::sqrt(std::max(0.0, 1.0 - x * x))) / besselI0(kAlpha);
+        auto sinc   = t == 0.0 ? 1.0 : std::sin(kPi * t) / (kPi * t);
+        weights[i]  = sinc * window;
+        sum += weights[i];
+    }
+    for (uint32_t i = 0; i < kMaxTaps; ++i)
+        kernel.weights[i] = float(weights[i] / sum);
+    return kernel;
+}
+
+static const Kernel& kernelFor(Filter filter)
+{
+    static const Kernel box    = makeKernel(Filter::fBox);
+    static const Kernel kaiser = makeKernel(Filter::fKaiser);
+    return filter == Filter::fBox ? box : kaiser;
+}
+
+// byte -> [0, 1], either straight or sRGB decoded
+static const float* unormTable()
+{
+    static const auto table = [] {
+        std::vector<float> values(256);
+        for (int i = 0; i < 256; ++i)
+            values[i] = float(i) / 255.0f;
+        return values;
+    }();
+    return table.data();
+}
+
+static const float* srgbDecodeTable()
+{
+    static const auto table = [] {
+        std::vector<float> values(256);
+        for (int i = 0; i < 256; ++i)
+        {
+            auto c    = double(i) / 255.0;
+            values[i] = float(c <= 0.04045 ? c / 12.92 : std::pow((c + 0.055) / 1.055, 2.4));
+        }
+        return values;
+    }();
+    return table.data();
+}
+
+// Linear [0, 1] in kEncodeSteps steps -> sRGB byte, a step is below a fifth of a code in the darks
+static constexpr uint32_t kEncodeSteps = 16384;
+
+static const unsigned char* srgbEncodeTable()
+{
+    static const auto table = [] {
+        std::vector<unsigned char> values(kEncodeSteps + 1);
+        for (uint32_t i = 0; i <= kEncodeSteps; ++i)
+        {
+            auto l    = double(i) / kEncodeSteps;
+            auto c    = l <= 0.0031308 ? l * 12.92 : 1.055 * std::pow(l, 1.0 / 2.4) - 0.055;
+            values[i] = (unsigned char)std::lround(std::clamp(c, 0.0, 1.0) * 255.0);
+        }
+        return values;
+    }();
+    return table.data();
+}
+
+#if MIPMAP_USE_SSE
+
+using Pixel = __m128;
+
+static inline Pixel splat(float value) { return _mm_set1_ps(value); }
+static inline Pixel load(const float* p) { return _mm_loadu_ps(p); }
+static inline void  store(float* p, Pixel v) { _mm_storeu_ps(p, v); }
+static inline Pixel madd(Pixel acc, Pixel a, Pixel w) { return _mm_add_ps(acc, _mm_mul_ps(a, w)); }
+static inline Pixel clampPixel(Pixel v, Pixel lo, Pixel hi) { return _mm_min_ps(_mm_max_ps(v, lo), hi); }
+
+#else
+
+struct Pixel
+{
+    float c[4];
+};
+
+static inline Pixel splat(float value) { return {{value, value, value, value}}; }
+static inline Pixel load(const float* p) { return {{p[0], p[1], p[2], p[3]}}; }
+static inline void  store(float* p, Pixel v) { memcpy(p, v.c, sizeof(v.c)); }
+
+static inline Pixel madd(Pixel acc, Pixel a, Pixel w)
+{
+    for (int i = 0; i < 4; ++i)
+        acc.c[i] += a.c[i] * w.c[i];
+    return acc;
+}
+
+static inline Pixel clampPixel(Pixel v, Pixel lo, Pixel hi)
+{
+    for (int i = 0; i < 4; ++i)
+        v.c[i] = std::min(std::max(v.c[i], lo.c[i]), hi.c[i]);
+    return v;
+}
+
+#endif
+
+// Level being filtered, either float pixels or rgba8 decoded a row at a time
+struct Source
+{
+    const float*         floats = nullptr;
+    const unsigned char* bytes  = nullptr;
+    const float*         decode = nullptr; // rgb of bytes
+    uint32_t             width  = 0;
+    uint32_t             height = 0;
+};
+
+static const float* fetchRow(const Source& source, uint32_t y, float* scratch)
+{
+    if (source.floats) return source.floats + size_t(y) * source.width * 4;
+
+    const auto* row   = source.bytes + size_t(y) * source.width * 4;
+    const auto* unorm = unormTable();
+    for (uint32_t x = 0; x < source.width * 4; x += 4)
+    {
+        scratch[x + 0] = source.decode[row[x + 0]];
+        scratch[x + 1] = source.decode[row[x + 1]];
+        scratch[x + 2] = source.decode[row[x + 2]];
+        scratch[x + 3] = unorm[row[x + 3]];
+    }
+    return scratch;
+}
+
+static uint32_t clampIndex(int index, uint32_t size) { return uint32_t(std::clamp(index, 0, int(size) - 1)); }
+
+// Separable filter of source into the width x height float level dst, clamped to [0, max_value]
+static void downsample(const Source& source, const Kernel& kernel, uint32_t width, uint32_t height, float max_value, float* dst)
+{
+    std::vector<uint32_t> columns(size_t(width) * kernel.count);
+    for (uint32_t x = 0; x < width; ++x)
+    {
+        for (uint32_t k = 0; k < kernel.count; ++k)
+            columns[x * kernel.count + k] = clampIndex(int(2 * x) + kernel.first + int(k), source.width) * 4;
+    }
+
+    Pixel weights[kMaxTaps];
+    for (uint32_t k = 0; k < kernel.count; ++k)
+        weights[k] = splat(kernel.weights[k]);
+
+    auto tasks = (height + kRowsPerTask - 1) / kRowsPerTask;
+    WorkerPool::global().parallel_for(tasks, [&](size_t task) {
+        auto first_y = uint32_t(task) * kRowsPerTask;
+        auto last_y  = std::min(height, first_y + kRowsPerTask);
+
+        // Source rows the band reads, edge rows repeat
+        auto first_row = int(2 * first_y) + kernel.first;
+        auto rows      = 2 * (last_y - 1 - first_y) + kernel.count;
+
+        std::vector<float> filtered(size_t(rows) * width * 4);
+        std::vector<float> scratch(source.floats ? 0 : size_t(source.width) * 4);
+        for (uint32_t r = 0; r < rows; ++r)
+        {
+            const auto* row = fetchRow(source, clampIndex(first_row + int(r), source.height), scratch.data());
+            auto*       out = filtered.data() + size_t(r) * width * 4;
+            for (uint32_t x = 0; x < width; ++x)
+            {
+                const auto* taps = &columns[x * kernel.count];
+
+                auto acc = splat(0.0f);
+                for (uint32_t k = 0; k < kernel.count; ++k)
+                    acc = madd(acc, load(row + taps[k]), weights[k]);
+                store(out + x * 4, acc);
+            }
+        }
+
+        auto lo = splat(0.0f), hi = splat(max_value);
+        for (auto y = first_y; y < last_y; ++y)
+        {
+            const auto* base = filtered.data() + size_t(2 * (y - first_y)) * width * 4;
+            auto*       out  = dst + size_t(y) * width * 4;
+            for (uint32_t x = 0; x < width * 4; x += 4)
+            {
+                auto acc = splat(0.0f);
+                for (uint32_t k = 0; k < kernel.count; ++k)
+                    acc = madd(acc, load(base + size_t(k) * width * 4 + x), weights[k]);
+                store(out + x, clampPixel(acc, lo, hi));
+            }
+        }
+    });
+}
+
+// Runs func(first_row, last_row) over bands of rows on the worker pool
+template <typename Func>
+static void forRows(uint32_t height, Func&& func)
+{
+    auto tasks = (height + kRowsPerTask - 1) / kRowsPerTask;
+    WorkerPool::global().parallel_for(tasks, [&](size_t task) {
+        auto first = uint32_t(task) * kRowsPerTask;
+        func(first, std::min(height, first + kRowsPerTask));
+    });
+}
+
+static float coverage(const float* pixels, size_t count, float cutoff, float scale)
+{
+    size_t passed = 0;
+    for (size_t i = 0; i < count; ++i)
+        passed += pixels[i * 4 + 3] * scale > cutoff;
+    return count ? float(passed) / float(count) : 0.0f;
+}
+
+// Coverage grows with the alpha scale, bisect for the scale closest to level 0's coverage
+static float coverageScale(const float* pixels, size_t count, float cutoff, float target)
+{
+    auto best  = 1.0f;
+    auto error = std::abs(coverage(pixels, count, cutoff, best) - target);
+
+    auto lo = 0.0f, hi = 4.0f;
+    for (int i = 0; i < 12 && error > 0.0f; ++i)
+    {
+        auto mid     = (lo + hi) * 0.5f;
+        auto covered = coverage(pixels, count, cutoff, mid);
+        if (std::abs(covered - target) < error)
+        {
+            best  = mid;
+            error = std::abs(covered - target);
+        }
+
+        if (covered < target)
+            lo = mid;
+        else
+            hi = mid;
+    }
+    return best;
+}
+
+uint32_t level_count(uint32_t width, uint32_t height)
+{
+    uint32_t levels = 1;
+    for (auto size = std::max(width, height); size > 1; size >>= 1)
+        ++levels;
+    return levels;
+}
+
+size_t chain_pixels(uint32_t width, uint32_t height, uint32_t levels, std::vector<size_t>* offsets)
+{
+    if (offsets) offsets->clear();
+
+    size_t pixels = 0;
+    for (uint32_t level = 0; level < levels; ++level)
+    {
+        if (offsets) offsets->push_back(pixels);
+        pixels += size_t(std::max(1u, width >> level)) * std::max(1u, height >> level);
+    }
+    return pixels;
+}
+
+uint32_t build_rgba8(const unsigned char* src, uint32_t width, uint32_t height, const Options& options, std::vector<unsigned char>& dst)
+{
+    auto                levels = level_count(width, height);
+    std::vector<size_t> offsets;
+    dst.resize(chain_pixels(width, height, levels, &offsets) * 4);
+    memcpy(dst.data(), src, size_t(width) * height * 4);
+    if (levels == 1) return levels;
+
+    const auto& kernel = kernelFor(options.filter);
+    const auto* encode = srgbEncodeTable();
+    auto        cutoff = options.alpha_cutoff;
+
+    float target = 0.0f;
+    if (cutoff > 0.0f)
+    {
+        size_t passed = 0, count = size_t(width) * height;
+        for (size_t i = 0; i < count; ++i)
+            passed += src[i * 4 + 3] > cutoff * 255.0f;
+        target = float(passed) / float(count);
+    }
+
+    Source source;
+    source.bytes  = src;
+    source.decode = options.srgb ? srgbDecodeTable() : unormTable();
+    source.width  = width;
+    source.height = height;
+
+    std::vector<float> previous, current;
+    for (uint32_t level = 1; level < levels; ++level)
+    {
+        auto level_width  = std::max(1u, width >> level);
+        auto level_height = std::max(1u, height >> level);
+        auto count        = size_t(level_width) * level_height;
+
+        current.resize(count * 4);
+        downsample(source, kernel, level_width, level_height, 1.0f, current.data());
+
+        auto scale = cutoff > 0.0f ? coverageScale(current.data(), count, cutoff, target) : 1.0f;
+        auto out   = dst.data() + offsets[level] * 4;
+        forRows(level_height, [&](uint32_t first, uint32_t last) {
+            for (auto i = size_t(first) * level_width; i < size_t(last) * level_width; ++i)
+            {
+                const auto* pixel = &current[i * 4];
+                for (int c = 0; c < 3; ++c)
+                {
+                    out[i * 4 + c] = options.srgb ? encode[uint32_t(pixel[c] * kEncodeSteps + 0.5f)]
+                                                  : (unsigned char)(pixel[c] * 255.0f + 0.5f);
+                }
+                out[i * 4 + 3] = (unsigned char)(std::min(1.0f, pixel[3] * scale) * 255.0f + 0.5f);
+            }
+        });
+
+        previous.swap(current);
+        source        = Source();
+        source.floats = previous.data();
+        source.width  = level_width;
+        source.height = level_height;
+    }
+    return levels;
+}
+
+uint32_t build_rgba32f(const float* src, uint32_t width, uint32_t height, const Options& options, std::vector<float>& dst)
+{
+    auto                levels = level_count(width, height);
+    std::vector<size_t> offsets;
+    dst.resize(chain_pixels(width, height, levels, &offsets) * 4);
+    memcpy(dst.data(), src, size_t(width) * height * 4 * sizeof(float));
+
+    const auto& kernel = kernelFor(options.filter);
+    auto        cutoff = options.alpha_cutoff;
+    auto        target = cutoff > 0.0f ? coverage(src, size_t(width) * height, cutoff, 1.0f) : 0.0f;
+
+    // Levels are filtered in place from the one above, the alpha scale of a level only touches its copy
+    std::vector<float> unscaled;
+    for (uint32_t level = 1; level < levels; ++level)
+    {
+        auto level_width  = std::max(1u, width >> level);
+        auto level_height = std::max(1u, height >> level);
+        auto count        = size_t(level_width) * level_height;
+
+        Source source;
+        source.floats = cutoff > 0.0f && level > 1 ? unscaled.data() : dst.data() + offsets[level - 1] * 4;
+        source.width  = std::max(1u, width >> (level - 1));
+        source.height = std::max(1u, height >> (level - 1));
+
+        auto* out = dst.data() + offsets[level] * 4;
+        downsample(source, kernel, level_width, level_height, FLT_MAX, out);
+        if (cutoff <= 0.0f) continue;
+
+        unscaled.assign(out, out + count * 4);
+
+        auto scale = coverageScale(out, count, cutoff, target);
+        forRows(level_height, [&](uint32_t first, uint32_t last) {
+            for (auto i = size_t(first) * level_width; i < size_t(last) * level_width; ++i)
+                out[i * 4 + 3] = std::min(1.0f, out[i * 4 + 3] * scale);
+        });
+    }
+    return levels;
+}
+
+} // namespace mipmap
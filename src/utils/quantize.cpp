@@ -0,0 +1,137 @@
+#include <utils/quantize.h>
+#include <utils/half.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace quantize
+{
+
+static auto toSnorm16(float value)
+{
+    return int16_t(lroundf(std::clamp(value, -1.0f, 1.0f) * 32767.0f));
+}
+
+static auto readFloats(const unsigned char* addr, float* out, int count)
+{
+    memcpy(out, addr, count * sizeof(float));
+}
+
+void encode_octahedral(const float n[3], int16_t out[2])
+{
+    auto length = fabsf(n[0]) + fabsf(n[1]) + fabsf(n[2]);
+    if (length == 0.0f)
+    {
+        out[0] = out[1] = 0;
+        return;
+    }
+
+    auto x = n[0] / length;
+    auto y = n[1] / length;
+    if (n[2] < 0.0f)
+    {
+        auto fx = (1.0f - fabsf(y)) * (x >= 0.0f ? 1.0f : -1.0f);
+        auto fy = (1.0f - fabsf(x)) * (y >= 0.0f ? 1.0f : -1.0f);
+        x       = fx;
+        y       = fy;
+    }
+
+    out[0] = toSnorm16(x);
+    out[1] = toSnorm16(y);
+}
+
+void decode_octahedral(const int16_t in[2], float n[3])
+{
+    auto x = std::max(in[0] / 32767.0f, -1.0f);
+    auto y = std::max(in[1] / 32767.0f, -1.0f);
+    auto z = 1.0f - fabsf(x) - fabsf(y);
+    if (z < 0.0f)
+    {
+        auto fx = (1.0f - fabsf(y)) * (x >= 0.0f ? 1.0f : -1.0f);
+        auto fy = (1.0f - fabsf(x)) * (y >= 0.0f ? 1.0f : -1.0f);
+        x       = fx;
+        y       = fy;
+    }
+
+    auto length = sqrtf(x * x + y * y + z * z);
+    n[0]        = x / length;
+    n[1]        = y / length;
+    n[2]        = z / length;
+}
+
+void positions_unorm16(uint16_t* dst, const unsigned char* src, size_t count, size_t stride, const float offset[3], const float scale[3])
+{
+    float inv[3];
+    for (int c = 0; c < 3; ++c)
+        inv[c] = scale[c] > 0.0f ? 65535.0f / scale[c] : 0.0f;
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        float p[3];
+        readFloats(src + i * stride, p, 3);
+        for (int c = 0; c < 3; ++c)
+            dst[i * 4 + c] = uint16_t(lroundf(std::clamp((p[c] - offset[c]) * inv[c], 0.0f, 65535.0f)));
+        dst[i * 4 + 3] = 0;
+    }
+}
+
+void normals_oct16(int16_t* dst, const unsigned char* src, size_t count, size_t stride)
+{
+    for (size_t i = 0; i < count; ++i)
+    {
+        float n[3];
+        readFloats(src + i * stride, n, 3);
+        encode_octahedral(n, dst + i * 2);
+    }
+}
+
+void tangents_oct16(int16_t* dst, const unsigned char* src, size_t count, size_t stride)
+{
+    for (size_t i = 0; i < count; ++i)
+    {
+        float t[4];
+        readFloats(src + i * stride, t, 4);
+        encode_octahedral(t, dst + i * 4);
+        dst[i * 4 + 2] = t[3] < 0.0f ? -32767 : 32767;
+        dst[i * 4 + 3] = 0;
+    }
+}
+
+void uvs_half(uint16_t* dst, const unsigned char* src, size_t count, size_t stride)
+{
+    for (size_t i = 0; i < count; ++i)
+    {
+        float uv[2];
+        readFloats(src + i * stride, uv, 2);
+        dst[i * 2 + 0] = half::from_float(uv[0]);
+        dst[i * 2 + 1] = half::from_float(uv[1]);
+    }
+}
+
+void weights_unorm8(uint8_t* dst, const unsigned char* src, size_t count, size_t stride)
+{
+    for (size_t i = 0; i < count; ++i)
+    {
+        float w[4];
+        readFloats(src + i * stride, w, 4);
+
+        auto sum = std::max(w[0] + w[1] + w[2] + w[3], 1e-8f);
+        int  q[4];
+        int  total   = 0;
+        int  largest = 0;
+        for (int c = 0; c < 4; ++c)
+        {
+            q[c] = int(lroundf(std::clamp(w[c] / sum, 0.0f, 1.0f) * 255.0f));
+            total += q[c];
+            if (q[c] > q[largest]) largest = c;
+        }
+
+        // rounding error goes to the dominant influence
+        q[largest] = std::clamp(q[largest] + 255 - total, 0, 255);
+        for (int c = 0; c < 4; ++c)
+            dst[i * 4 + c] = uint8_t(q[c]);
+    }
+}
+
+} // namespace quantize
@@ -0,0 +1,106 @@
+#include <utils/workerPool.h>
+
+WorkerPool::WorkerPool(uint32_t count)
+{
+    if (count == 0)
+    {
+        auto hardware = std::thread::hardware_concurrency();
+        count         = hardware > 1 ? hardware - 1 : 1;
+    }
+
+    m_threads.reserve(count);
+    for (uint32_t i = 0; i < count; ++i)
+        m_threads.emplace_back([this]() { _worker_loop(); });
+}
+
+WorkerPool::~WorkerPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_cv.notify_all();
+
+    for (auto& thread : m_threads)
+        thread.join();
+}
+
+WorkerPool& WorkerPool::global()
+{
+    static WorkerPool pool;
+    return pool;
+}
+
+void WorkerPool::parallel_for(size_t count, const std::function<void(size_t)>& func)
+{
+    if (count == 0) return;
+
+    if (count == 1 || m_threads.empty())
+    {
+        for (size_t i = 0; i < count; ++i)
+            func(i);
+        return;
+    }
+
+    // Note: helpers may start after the caller already drained all items, so the shared state
+    // must outlive this call; func is only touched while items are left, i.e. before we return
+    struct State
+    {
+        std::atomic<size_t>     next = 0;
+        std::atomic<size_t>     done = 0;
+        std::mutex              mutex;
+        std::condition_variable cv;
+    };
+    auto state = std::make_shared<State>();
+
+    auto run = [state, count, &func]() {
+        size_t finished = 0;
+        for (auto i = state->next++; i < count; i = state->next++)
+        {
+            func(i);
+            ++finished;
+        }
+
+        if (finished && state->done.fetch_add(finished) + finished == count)
+        {
+            std::lock_guard<std::mutex> lock(state->mutex);
+            state->cv.notify_all();
+        }
+    };
+
+    auto helpers = std::min<size_t>(m_threads.size(), count - 1);
+    for (size_t i = 0; i < helpers; ++i)
+        _push(run);
+
+    run();
+
+    std::unique_lock<std::mutex> lock(state->mutex);
+    state->cv.wait(lock, [&]() { return state->done == count; });
+}
+
+void WorkerPool::_push(std::function<void()>&& task)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_tasks.emplace_back(std::move(task));
+    }
+    m_cv.notify_one();
+}
+
+void WorkerPool::_worker_loop()
+{
+    while (true)
+    {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_cv.wait(lock, [this]() { return m_stop || !m_tasks.empty(); });
+            if (m_stop && m_tasks.empty()) return;
+
+            task = std::move(m_tasks.front());
+            m_tasks.pop_front();
+        }
+
+        task();
+    }
+}
@@ -40,6 +40,11 @@ void BottomBar::set_pickpixel_callback(std::function<void(uint32_t, uint32_t)> f
     m_cmd_widget->set_pickpixel_callback(func);
 }
 
+void BottomBar::set_load_callback(std::function<bool(const std::string&, const std::string&)> func)
+{
+    m_cmd_widget->set_load_callback(func);
+}
+
 void BottomBar::set_showprofiler_callback(std::function<void()> func)
 {
     m_cmd_widget->set_showprofiler_callback(func);
@@ -34,8 +34,9 @@ static QStringList g_cmdList = {
     "rotate camera",
     "active entity",
     "reset_alive entity",
-    "load image",
     "load scene",
+    "load add",
+    "load cancel",
 };
 
 CmdWidget::CmdWidget(SceneMgr* scene, QWidget* parent) :
@@ -120,3 +121,8 @@ void CmdWidget::set_saveframe_callback(std::function<void()> func)
 {
     m_cmd_ctrlr->set_saveframe_callback(func);
 }
+
+void CmdWidget::set_load_callback(std::function<bool(const std::string&, const std::string&)> func)
+{
+    m_cmd_ctrlr->set_load_callback(func);
+}
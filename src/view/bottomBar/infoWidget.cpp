@@ -75,6 +75,96 @@ void InfoWidget::_update_state_info()
     stateInfo += "    Material Count: " + QString::number(m_scene->material_count()) + "\n";
     stateInfo += "    Texture Count: " + QString::number(m_scene->texture_count()) + "\n";
     stateInfo += "    Image Count: " + QString::number(m_scene->image_count()) + "\n";
+    stateInfo += "    Load Time: " + QString::number(m_scene->load_stats().load_ms, 'f', 1) + " ms";
+    if (m_scene->load_stats().ready_ms > 0.0) stateInfo += " (drawable after " + QString::number(m_scene->load_stats().ready_ms, 'f', 1) + " ms)";
+    stateInfo += m_scene->load_stats().from_cache ? " (cache)\n" : "\n";
+
+    const auto& stats = m_scene->load_stats();
+    if (stats.compressed_images > 0)
+    {
+        stateInfo += "\nCompressed Textures: \n";
+        stateInfo += "    Images: " + QString::number(stats.compressed_images) + "\n";
+        stateInfo += "    Memory: " + QString::number(stats.compressed_bytes / (1024.0 * 1024.0), 'f', 2) + " MB (" +
+                     QString::number(stats.compressed_rgba8_bytes / (1024.0 * 1024.0), 'f', 2) + " MB as RGBA8)\n";
+    }
+    if (stats.mip_images > 0)
+    {
+        stateInfo += "\nMip Chains: \n";
+        stateInfo += "    Images: " + QString::number(stats.mip_images) + "\n";
+        stateInfo += "    Memory: " + QString::number(stats.mip_bytes / (1024.0 * 1024.0), 'f', 2) + " MB below level 0\n";
+    }
+    if (auto environment = m_scene->environment())
+    {
+        stateInfo += "\nEnvironment: \n";
+        stateInfo += "    Specular: " + QString::number(environment->face_size) + " px faces, " + QString::number(environment->levels) + " roughness levels\n";
+        stateInfo += "    Sampling CDF: " + QString::number(environment->cdf_width) + " x " + QString::number(environment->cdf_height) + "\n";
+        stateInfo += "    Memory: " + QString::number(environment->bytes() / (1024.0 * 1024.0), 'f', 2) + " MB, " +
+                     QString::number(environment->build_ms, 'f', 1) + " ms" + (environment->from_cache ? " (cache)\n" : "\n");
+    }
+    const auto& residency = m_scene->residency_stats();
+    if (residency.images > 0)
+    {
+        auto mb = [](uint64_t bytes) { return QString::number(bytes / (1024.0 * 1024.0), 'f', 2); };
+        stateInfo += "\nTexture Residency: \n";
+        stateInfo += "    Resident: " + mb(residency.resident_bytes) + " / " + mb(residency.full_bytes) + " MB (budget " + mb(residency.budget) + " MB)\n";
+        stateInfo += "    Images: " + QString::number(residency.images) + " (" + QString::number(residency.reduced_images) + " reduced, " +
+                     QString::number(residency.used_images) + " drawn, " + QString::number(residency.loading) + " loading)\n";
+        stateInfo += "    Evicted: " + mb(residency.evicted_bytes) + " MB in " + QString::number(residency.evictions) + ", reloaded: " +
+                     mb(residency.reloaded_bytes) + " MB in " + QString::number(residency.reloads) + "\n";
+    }
+    if (stats.native_images > 0)
+    {
+        stateInfo += "\nStandalone Images: \n";
+        stateInfo += "    Images: " + QString::number(stats.native_images) + "\n";
+        stateInfo += "    Memory: " + QString::number(stats.native_image_bytes / (1024.0 * 1024.0), 'f', 2) + " MB (" +
+                     QString::number(stats.native_image_bytes_f32 / (1024.0 * 1024.0), 'f', 2) + " MB as RGBA32F, " +
+                     QString::number((stats.native_image_bytes_f32 - stats.native_image_bytes) / (1024.0 * 1024.0), 'f', 2) + " MB saved)\n";
+    }
+    if (stats.image_lookups > 0)
+    {
+        stateInfo += "\nImage Sharing: \n";
+        stateInfo += "    Hits: " + QString::number(stats.image_hits) + " / " + QString::number(stats.image_lookups) + "\n";
+        stateInfo += "    Saved: " + QString::number(stats.image_bytes_saved / (1024.0 * 1024.0), 'f', 2) + " MB\n";
+    }
+    if (stats.meshopt_views > 0 || stats.draco_primitives > 0)
+    {
+        auto decode = [](const char* name, uint32_t count, uint64_t bytes_in, uint64_t bytes_out, double ms) {
+            return QString("    ") + name + ": " + QString::number(count) + " (" + QString::number(bytes_in / 1024.0, 'f', 1) + " KB -> " +
+                   QString::number(bytes_out / 1024.0, 'f', 1) + " KB in " + QString::number(ms, 'f', 1) + " ms)\n";
+        };
+        stateInfo += "\nDecompression: \n";
+        if (stats.meshopt_views > 0) stateInfo += decode("Meshopt Views", stats.meshopt_views, stats.meshopt_bytes_in, stats.meshopt_bytes_out, stats.meshopt_ms);
+        if (stats.draco_primitives > 0) stateInfo += decode("Draco Primitives", stats.draco_primitives, stats.draco_bytes_in, stats.draco_bytes_out, stats.draco_ms);
+    }
+    if (stats.optimized_geometry > 0 || stats.geometry_bytes_raw > 0 || stats.meshlet_count > 0 || stats.lod_geometry > 0)
+    {
+        auto saved = int64_t(stats.geometry_bytes_raw) - int64_t(stats.geometry_bytes);
+        stateInfo += "\nMesh Optimization: \n";
+        stateInfo += "    Optimized Geometry: " + QString::number(stats.optimized_geometry) + " (" + QString::number(stats.optimized_triangle) + " triangles)\n";
+        stateInfo += "    ACMR: " + QString::number(stats.acmr_before(), 'f', 3) + " -> " + QString::number(stats.acmr_after(), 'f', 3) + "\n";
+        stateInfo += "    Bytes Saved: " + QString::number(saved / 1024.0, 'f', 1) + " KB\n";
+        stateInfo += "    Meshlets: " + QString::number(stats.meshlet_count) + "\n";
+        stateInfo += "    LODs: " + QString::number(stats.lod_levels) + " levels over " + QString::number(stats.lod_geometry) + " geometries\n";
+    }
+    if (stats.attribute_bytes_raw > 0)
+    {
+        auto ratio = 100.0 * double(stats.attribute_bytes) / double(stats.attribute_bytes_raw);
+        stateInfo += "\nAttribute Quantization: \n";
+        stateInfo += "    Memory: " + QString::number(stats.attribute_bytes_raw / 1024.0, 'f', 1) + " KB -> " + QString::number(stats.attribute_bytes / 1024.0, 'f', 1) + " KB";
+        stateInfo += " (" + QString::number(ratio, 'f', 1) + "%)\n";
+    }
+    if (stats.batch_count > 0)
+    {
+        stateInfo += "\nInstancing: \n";
+        stateInfo += "    Batches: " + QString::number(stats.batch_count) + " (" + QString::number(stats.batched_draws) + " draws merged)\n";
+    }
+    if (stats.animation_keys_in > 0)
+    {
+        stateInfo += "\nAnimation: \n";
+        stateInfo += "    Keys: " + QString::number(stats.animation_keys_in) + " -> " + QString::number(stats.animation_keys_out) + "\n";
+        stateInfo += "    Memory: " + QString::number(stats.animation_bytes_in / 1024.0, 'f', 1) + " KB -> " + QString::number(stats.animation_bytes_out / 1024.0, 'f', 1) + " KB";
+        stateInfo += " (max error " + QString::number(stats.animation_max_error, 'g', 3) + ")\n";
+    }
     stateInfo += "\nRendering Info: \n";
     // stateInfo += "    AA: " + (m_scene->isAAEnabled() ? "Enabled" : "Disabled") + "\n";
     // stateInfo += "    HDR: " + (m_scene->isHDREnabled() ? "Enabled" : "Disabled") + "\n";
@@ -118,6 +118,7 @@ void MainWindow::_setup_callbacks()
     m_menu_bar->set_stop_record_callback([this]() { m_render_window->end_record(); });
     m_menu_bar->set_resetview_callback([this]() { m_render_window->reset_view(); });
     m_menu_bar->set_flushstate_callback([this]() { m_bottom_bar->flush_state(); });
+    m_menu_bar->set_loadstatus_callback([this](const std::string& message, int timeout) { m_status_bar->showMessage(message.c_str(), timeout); });
 
     QObject::connect(m_page_tab, &QTabBar::currentChanged, m_page_stack, &QStackedWidget::setCurrentIndex);
 
@@ -127,4 +128,5 @@ void MainWindow::_setup_callbacks()
     m_bottom_bar->set_saveframe_callback([this]() { m_menu_bar->save_frame(); });
     m_bottom_bar->set_showprofiler_callback([this]() { m_bottom_bar->show_profiler(m_render_window->profiler_info()); });
     m_bottom_bar->set_pickpixel_callback([this](uint32_t x, uint32_t y) { m_bottom_bar->show_pick_info(m_render_window->pick_pixel(x, y)); });
+    m_bottom_bar->set_load_callback([this](const std::string& mode, const std::string& fileName) { return m_menu_bar->load(mode, fileName); });
 }
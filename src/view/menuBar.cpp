@@ -2,6 +2,7 @@
 
 #include <controller/loader/gltfLoader.h>
 #include <controller/loader/triangleLoader.h>
+#include <controller/loadController.h>
 
 #include <model/sceneMgr.h>
 
@@ -17,11 +18,46 @@ MenuBar::MenuBar(SceneMgr* scene, QWidget* parent) :
     QMenuBar(parent),
     m_scene(scene),
     // m_loader(new TriangleLoader(m_scene))
-    m_loader(new GLTFLoader(m_scene))
+    m_loader(new GLTFLoader(m_scene)),
+    m_load_controller(std::make_unique<LoadController>(m_scene))
 {
     _init_file_menu();
     _init_edit_menu();
     _init_help_menu();
+
+    // Scenes load in the background, opens are committed whole and the view is framed once the
+    // opened scene replaced the old one, adds show up as they come in
+    if (auto loader = dynamic_cast<GLTFLoader*>(m_loader)) m_load_controller->set_config(loader->config());
+    m_load_controller->set_status_callback([this](const LoadController::Status& status) {
+        if (m_loadstatus_func) m_loadstatus_func(LoadController::describe(status), status.state == LoadController::State::sRunning ? 0 : 10000);
+    });
+    m_load_controller->set_ready_callback([this](const LoadController::Status& status) {
+        m_flushstate_func();
+        m_renderframe_func();
+    });
+    m_load_controller->set_committed_callback([this](const LoadController::Status& status) {
+        if (status.replace) m_resetview_func();
+        m_flushstate_func();
+        m_renderframe_func();
+    });
+
+    m_loader->generateLuts();
+}
+
+MenuBar::~MenuBar() = default;
+
+bool MenuBar::load(const std::string& mode, const std::string& fileName)
+{
+    if (mode == "scene")
+        m_load_controller->open(fileName);
+    else if (mode == "add")
+        m_load_controller->add(fileName);
+    else if (mode == "cancel")
+        m_load_controller->cancel_all();
+    else
+        return false;
+
+    return true;
 }
 
 void MenuBar::_init_file_menu()
@@ -33,10 +69,13 @@ void MenuBar::_init_file_menu()
     m_action_open_scene->setShortcut(Qt::CTRL | Qt::Key_O);
     m_action_close_scene = m_menu_file_scene->addAction("Close");
     m_action_close_scene->setShortcut(Qt::CTRL | Qt::Key_E);
-    m_action_add_scene  = m_menu_file_scene->addAction("Add");
-    m_action_save_scene = m_menu_file_scene->addAction("Save");
+    m_action_add_scene   = m_menu_file_scene->addAction("Add");
+    m_action_save_scene  = m_menu_file_scene->addAction("Save");
+    m_action_cancel_load = m_menu_file_scene->addAction("Cancel Loading");
     connect(m_action_open_scene, &QAction::triggered, this, [this]() { _on_open_scene(); });
     connect(m_action_close_scene, &QAction::triggered, this, [this]() { _on_clear_scene(); });
+    connect(m_action_add_scene, &QAction::triggered, this, [this]() { _on_add_scene(); });
+    connect(m_action_cancel_load, &QAction::triggered, this, [this]() { _on_cancel_load(); });
 
     m_menu_file_image   = m_menu_file->addMenu("Image");
     m_action_open_image = m_menu_file_image->addAction("Open Image");
@@ -47,6 +86,11 @@ void MenuBar::_init_file_menu()
     m_action_open_hdr->setShortcut(Qt::CTRL | Qt::Key_H);
     connect(m_action_open_hdr, &QAction::triggered, this, [this]() { _on_open_hdr(); });
 
+    // Opt-in, applies to the HDRs opened afterwards
+    m_action_prepare_environment = m_menu_file_image->addAction("Prefilter HDR Environment");
+    m_action_prepare_environment->setCheckable(true);
+    connect(m_action_prepare_environment, &QAction::toggled, this, [this](bool checked) { m_loader->set_prepare_environment(checked); });
+
     m_action_open_lut_ggx = m_menu_file_image->addAction("Open LUT GGX");
     connect(m_action_open_lut_ggx, &QAction::triggered, this, [this]() { _on_open_lut_ggx(); });
     m_action_open_lut_charlie = m_menu_file_image->addAction("Open LUT Charlie");
@@ -101,6 +145,22 @@ void MenuBar::_init_help_menu()
 
 void MenuBar::_on_add_scene()
 {
+    QFileDialog fileDialog;
+    fileDialog.setWindowTitle(QObject::tr("Add Files"));
+    fileDialog.setNameFilter(QObject::tr("*.gltf;;*.glb;;All Files (*)"));
+    fileDialog.setFileMode(QFileDialog::ExistingFiles);
+    fileDialog.setDirectory(QDir::currentPath());
+
+    if (fileDialog.exec() != QFileDialog::Accepted)
+    {
+        qDebug() << "File dialog canceled";
+        return;
+    }
+
+    // A job per file, they load side by side on the worker pool and commit into their own uuid
+    // namespace of the current scene
+    for (const auto& file : fileDialog.selectedFiles())
+        m_load_controller->add(file.toStdString());
 }
 
 void MenuBar::_on_open_scene()
@@ -121,30 +181,34 @@ void MenuBar::_on_open_scene()
         qDebug() << "File dialog canceled";
     }
 
-    if (!fileName.empty())
-    {
-        m_scene->clear_scene();
-        m_loader->loadScene(fileName);
-
-        m_resetview_func();
-        m_flushstate_func();
-        m_renderframe_func();
-    }
+    // The current scene stays until the new one is complete
+    if (!fileName.empty()) m_load_controller->open(fileName);
 }
 
 void MenuBar::_on_clear_scene()
 {
     m_scene->clear_scene();
+    m_load_controller->clear();
     m_renderframe_func();
 }
 
+void MenuBar::_on_cancel_load()
+{
+    m_load_controller->cancel_all();
+}
+
 void MenuBar::_on_open_image()
 {
     std::string fileName;
 
     QFileDialog fileDialog;
     fileDialog.setWindowTitle(QObject::tr("Open Image"));
+    // KTX2 images need the BCn formats of a USE_KTX2 build
+#ifdef USE_KTX2
+    fileDialog.setNameFilter(QObject::tr("*.png;;*.jpg;;*.jpeg;;*.bmp;;*.ktx2;;All Files (*)"));
+#else
     fileDialog.setNameFilter(QObject::tr("*.png;;*.jpg;;*.jpeg;;*.bmp;;All Files (*)"));
+#endif
     fileDialog.setDirectory(QDir::currentPath());
 
     if (fileDialog.exec() == QFileDialog::Accepted)
@@ -50,7 +50,10 @@ RenderWindow::RenderWindow() :
     m_last_frame_time = std::chrono::steady_clock::now();
     m_timer           = new QTimer(this);
     connect(m_timer, &QTimer::timeout, this, [this]() {
+        m_scene->process_pending();
         if (!m_renderer) return;
+        m_scene->select_lods(float(height() * devicePixelRatio()));
+        m_scene->update_residency(float(height() * devicePixelRatio()));
         animate_frame();
         render_frame();
     });
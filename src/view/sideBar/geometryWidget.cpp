@@ -65,7 +65,7 @@ void GeometryWidget::_init_ui()
     m_layout->addStretch();
 }
 
-void GeometryWidget::set_geometry(uint32_t uuid)
+void GeometryWidget::set_geometry(acre::UUID uuid)
 {
     m_geometryR = m_scene->find<acre::GeometryID>(uuid);
     m_geometry  = m_geometryR->ptr<acre::GeometryID>();
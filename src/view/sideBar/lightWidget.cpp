@@ -23,7 +23,7 @@ void LightWidget::_on_update_type(int index)
     }
 }
 
-void LightWidget::set_light(uint32_t uuid)
+void LightWidget::set_light(acre::UUID uuid)
 {
     m_lightR = m_scene->find<acre::LightID>(uuid);
     m_light  = m_lightR->ptr<acre::LightID>();
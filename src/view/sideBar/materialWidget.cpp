@@ -151,7 +151,7 @@ void MaterialWidget::_init_ui()
     m_layout->addStretch();
 }
 
-void MaterialWidget::set_material(uint32_t uuid)
+void MaterialWidget::set_material(acre::UUID uuid)
 {
     m_materialR = m_scene->find<acre::MaterialID>(uuid);
     if (!m_materialR || m_materialR->idx() == RESOURCE_ID_VALID) return;
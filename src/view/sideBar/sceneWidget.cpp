@@ -139,7 +139,7 @@ void SceneWidget::_on_treeitem_selected(QTreeWidgetItem* current, QTreeWidgetIte
         switch (tab)
         {
             case TabWidget::wCamera:
-                m_scene->set_main_camera(current->text(0).toInt());
+                m_scene->set_main_camera(current->text(0).toULongLong());
                 toCameraWidget->set_camera(m_scene->main_camera());
                 break;
             case TabWidget::wLight:
@@ -161,25 +161,25 @@ void SceneWidget::_on_treeitem_selected(QTreeWidgetItem* current, QTreeWidgetIte
                 {
                     toLightWidget->disable_sun();
                     toLightWidget->disable_hdr();
-                    toLightWidget->set_light(selectedText.toInt());
+                    toLightWidget->set_light(selectedText.toULongLong());
                     toLightWidget->update_properties();
                 }
                 break;
             }
             case TabWidget::wGeometry:
-                toGeometryWidget->set_geometry(current->text(0).toInt());
+                toGeometryWidget->set_geometry(current->text(0).toULongLong());
                 toGeometryWidget->update_properties();
-                m_scene->highlight_geometry(current->text(0).toInt());
+                m_scene->highlight_geometry(current->text(0).toULongLong());
                 m_renderframe_func();
                 break;
             case TabWidget::wMaterial:
-                toMaterialWidget->set_material(current->text(0).toInt());
+                toMaterialWidget->set_material(current->text(0).toULongLong());
                 toMaterialWidget->update_properties();
-                m_scene->highlight_material(current->text(0).toInt());
+                m_scene->highlight_material(current->text(0).toULongLong());
                 m_renderframe_func();
                 break;
             case TabWidget::wTransform:
-                toTransformWidget->set_transform(current->text(0).toInt());
+                toTransformWidget->set_transform(current->text(0).toULongLong());
                 toTransformWidget->update_properties();
                 break;
         }
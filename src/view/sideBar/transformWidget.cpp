@@ -86,7 +86,7 @@ void TransformWidget::_init_ui()
     m_layout->addStretch();
 }
 
-void TransformWidget::set_transform(uint32_t uuid)
+void TransformWidget::set_transform(acre::UUID uuid)
 {
     m_transformR = m_scene->find<acre::TransformID>(uuid);
     m_transform  = m_transformR->ptr<acre::TransformID>();
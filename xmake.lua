@@ -42,6 +42,15 @@ target("acreEditor", function()
     
     -- add_defines("USE_VULKAN")
 
+    -- KTX2/KHR_texture_basisu, needs add_requires("basisu") at the top of this file and an acre
+    -- build with BCn image formats
+    -- add_defines("USE_KTX2")
+    -- add_packages("basisu")
+
+    -- KHR_draco_mesh_compression, needs add_requires("draco") at the top of this file
+    -- add_defines("USE_DRACO")
+    -- add_packages("draco")
+
     after_install(function(target)
         os.cp(os.scriptdir() .. "/tools/dxc/bin/x64/*", target:targetdir())
         if is_mode("release") then